@@ -0,0 +1,75 @@
+/* Measures how rasterizing and remapping one RGB frame scales with the number of threads.
+   To compile: build the parallel_raster_benchmark target of the CMake project (see CMakeLists.txt).
+   To run: ./parallel_raster_benchmark [tweezerSize] */
+
+#include "../core/bitplane_rasterizer.h"
+#include "../core/frame_pipeline.h"
+#include "../core/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+const int SCR_WIDTH = 1140;
+const int SCR_HEIGHT = 912;
+const int DMD_ROW_OFFSET = 607;
+const int NUM_FRAMES = 100;
+
+int main(int argc, char** argv) {
+    int tweezerSize = argc > 1 ? atoi(argv[1]) : 3;
+    const int tweezerCounts[] = { 100, 400, 2000 };
+    const int threadCounts[] = { 1, 2, 4, 8, 12, 16 };
+
+    TweezerStamp stamp;
+    stamp.makeSquare(tweezerSize);
+    DmdRemap remap;
+    remap.build(SCR_WIDTH, SCR_HEIGHT, DMD_ROW_OFFSET);
+    std::vector<uint32_t> packed((size_t)SCR_WIDTH * SCR_HEIGHT);
+    std::vector<uint32_t> remapped((size_t)SCR_WIDTH * SCR_HEIGHT);
+    std::vector<double> times(NUM_FRAMES);
+
+    printf("tweezerSize %d, %d frames per point, %u hardware threads\n", tweezerSize, NUM_FRAMES, std::thread::hardware_concurrency());
+    printf("%10s %8s %14s %14s %8s\n", "tweezers", "threads", "median (us)", "min (us)", "speedup");
+    for (int numTweezers : tweezerCounts) {
+        // Tweezers spread over the middle of the screen, drifting by a fraction of a pixel per subframe.
+        TrajectoryStore trajectories;
+        trajectories.reserve(numTweezers, SUBFRAMES_PER_FRAME, 2);
+        int side = 1;
+        while (side * side < numTweezers) side++;
+        for (int j = 0; j < SUBFRAMES_PER_FRAME; j++) {
+            for (int i = 0; i < numTweezers; i++) {
+                trajectories.moveX(j, i) = 100.0f + (i / side) * 700.0f / side + 0.4f * j;
+                trajectories.moveY(j, i) = 200.0f + (i % side) * 700.0f / side + 0.4f * j;
+            }
+        }
+
+        FrameJob job;
+        job.trajectories = &trajectories;
+        job.numMoves = SUBFRAMES_PER_FRAME;
+        job.stamp = &stamp;
+        job.inverted = true;
+        job.remap = &remap;
+        job.width = SCR_WIDTH;
+        job.height = SCR_HEIGHT;
+
+        double baseline = 0.0;
+        for (int numThreads : threadCounts) {
+            ThreadPool pool(numThreads);
+            job.pool = &pool;
+            for (int f = 0; f < NUM_FRAMES; f++) {
+                auto start = std::chrono::steady_clock::now();
+                renderFrame(job, 0, packed.data(), remapped.data());
+                auto end = std::chrono::steady_clock::now();
+                times[f] = std::chrono::duration<double, std::micro>(end - start).count();
+            }
+            std::sort(times.begin(), times.end());
+            double median = times[NUM_FRAMES / 2];
+            if (numThreads == 1) baseline = median;
+            printf("%10d %8d %14.1f %14.1f %8.2f\n", numTweezers, numThreads, median, times[0], baseline / median);
+        }
+    }
+
+    return 0;
+}
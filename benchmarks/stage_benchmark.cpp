@@ -0,0 +1,331 @@
+/* Times each stage of turning an occupancy matrix into displayed frames in isolation: routing, trajectory smoothing, tweezer
+   stamping, the DMD remap, texture upload and presentation, plus the time to the first frame of a shot.
+   Lattices are swept from 20 x 20 to 100 x 100 sites at several fill fractions, with N from 1 to 100 and several tweezer sizes.
+   The OpenGL stages run through the headless EGL backend, so they measure the local driver (llvmpipe on a server), and "present"
+   waits for the frame with glFinish where a window would swap.
+   To compile: build the stage_benchmark target of the CMake project (see CMakeLists.txt).
+   To run: ./stage_benchmark --benchmark_out=stages.json --benchmark_out_format=json [--benchmark_filter=<regex>]
+   (or build the stage_benchmark_json target, which writes stage_benchmark.json into the build directory) */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "../core/bitplane_rasterizer.h"
+#include "../core/dmd_remap.h"
+#include "../core/frame_context.h"
+#include "../core/router.h"
+#include "../core/tweezer_shapes.h"
+
+#ifdef DMD_USE_EGL
+#include "../render/dmd_renderer.h"
+#include "../render/egl_backend.h"
+#include "../render/gl_extensions.h"
+#include "../render/texture_uploader.h"
+#endif
+
+namespace {
+
+const int SCREEN_WIDTH = 1140;
+const int SCREEN_HEIGHT = 912;
+const int ROW_OFFSET = 607;
+const int MAX_TIME = 40;
+
+// LatticeShot: a deterministic random occupancy matrix and the lattice geometry of the example call in main.cpp, scaled so that the
+// whole lattice stays on the DMD.
+struct LatticeShot {
+    int rows = 0;
+    int cols = 0;
+    int numTweezers = 0;
+    std::vector<int> occupancy;
+    LatticeGeometry lattice;
+
+    LatticeShot(int size, int fillPercent) : rows(size), cols(size), occupancy((size_t)size * size) {
+        srand(size * 1000 + fillPercent);
+        for (int& site : occupancy) {
+            site = rand() % 100 < fillPercent ? 1 : 0;
+            numTweezers += site;
+        }
+        float spacing = 10.0f * 20.0f / size;
+        lattice.vec1X = 0.866f * spacing;
+        lattice.vec1Y = 0.5f * spacing;
+        lattice.vec2X = 0.866f * spacing;
+        lattice.vec2Y = -0.5f * spacing;
+        lattice.centerX = SCREEN_HEIGHT / 2.0f;
+        lattice.centerY = SCREEN_WIDTH / 2.0f;
+    }
+
+    // load: copies the occupancy matrix into the context, which routing then modifies.
+    void load(FrameContext& context, int N) const {
+        context.prepare(rows, cols, numTweezers, N, MAX_TIME);
+        int** tweezerPositions = context.tweezerPositions();
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) tweezerPositions[i][j] = occupancy[(size_t)i * cols + j];
+        }
+    }
+};
+
+void setLatticeCounters(benchmark::State& state, const LatticeShot& shot) {
+    state.counters["tweezers"] = shot.numTweezers;
+}
+
+// Lattice sizes and fill fractions (in percent) swept by every routing and smoothing benchmark.
+void latticeArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({ "size", "fill" })->ArgsProduct({ { 20, 50, 100 }, { 25, 50, 75 } })->Unit(benchmark::kMicrosecond);
+}
+
+void BM_Route(benchmark::State& state) {
+    LatticeShot shot((int)state.range(0), (int)state.range(1));
+    FrameContext context;
+    int numFrames = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        shot.load(context, 1);
+        state.ResumeTiming();
+        numFrames = routeCenterOfMass(shot.numTweezers, shot.rows, shot.cols, context.tweezerPositions(), context.trajectories, MAX_TIME,
+                                      LatticeTopology::Square, &context.centerOfMass);
+        benchmark::DoNotOptimize(numFrames);
+    }
+    setLatticeCounters(state, shot);
+    state.counters["latticeFrames"] = numFrames;
+    state.counters["siteSteps"] = (double)countLatticeMoves(context.trajectories, shot.numTweezers, numFrames);
+}
+BENCHMARK(BM_Route)->Apply(latticeArguments);
+
+// The assignment is cubic in the number of tweezers off their targets, so the 100 x 100 lattice is left out. The shots' lattice vectors
+// are 60 degrees apart, so they can be routed on either topology.
+void BM_RouteAssignment(benchmark::State& state) {
+    LatticeShot shot((int)state.range(0), (int)state.range(1));
+    LatticeTopology topology = (LatticeTopology)state.range(2);
+    FrameContext context;
+    int numFrames = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        shot.load(context, 1);
+        state.ResumeTiming();
+        numFrames = routeAssignment(shot.numTweezers, shot.rows, shot.cols, context.tweezerPositions(), context.trajectories, MAX_TIME,
+                                    context.routing, topology);
+        benchmark::DoNotOptimize(numFrames);
+    }
+    setLatticeCounters(state, shot);
+    state.counters["latticeFrames"] = numFrames;
+    state.counters["siteSteps"] = (double)countLatticeMoves(context.trajectories, shot.numTweezers, numFrames, topology);
+    state.counters["assignmentCost"] = (double)context.routing.assignmentCost;
+}
+BENCHMARK(BM_RouteAssignment)
+    ->ArgNames({ "size", "fill", "topology" })
+    ->ArgsProduct({ { 20, 50 }, { 25, 50, 75 }, { 0, 1 } })
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_RouteReservation(benchmark::State& state) {
+    LatticeShot shot((int)state.range(0), (int)state.range(1));
+    LatticeTopology topology = (LatticeTopology)state.range(2);
+    FrameContext context;
+    int numFrames = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        shot.load(context, 1);
+        state.ResumeTiming();
+        numFrames = routeReservation(shot.numTweezers, shot.rows, shot.cols, context.tweezerPositions(), context.trajectories, MAX_TIME,
+                                     context.routing, context.reservation, topology);
+        benchmark::DoNotOptimize(numFrames);
+    }
+    setLatticeCounters(state, shot);
+    state.counters["latticeFrames"] = numFrames;
+    state.counters["assignmentFrames"] = context.reservation.assignmentFrames;
+    state.counters["siteSteps"] = (double)countLatticeMoves(context.trajectories, shot.numTweezers, numFrames, topology);
+}
+BENCHMARK(BM_RouteReservation)
+    ->ArgNames({ "size", "fill", "topology" })
+    ->ArgsProduct({ { 20, 50 }, { 25, 50, 75 }, { 0, 1 } })
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_Smooth(benchmark::State& state) {
+    LatticeShot shot((int)state.range(0), (int)state.range(1));
+    int N = (int)state.range(2);
+    FrameContext context;
+    shot.load(context, N);
+    int numFrames = routeCenterOfMass(shot.numTweezers, shot.rows, shot.cols, context.tweezerPositions(), context.trajectories, MAX_TIME);
+    TrajectoryStore routed = context.trajectories;
+    for (auto _ : state) {
+        // Smoothing recenters the lattice stage in place, so every iteration starts from the routed moves.
+        state.PauseTiming();
+        context.trajectories = routed;
+        state.ResumeTiming();
+        int numMoves = smoothTrajectories(context.trajectories, shot.numTweezers, numFrames, shot.rows, shot.cols, N, shot.lattice);
+        benchmark::DoNotOptimize(numMoves);
+    }
+    setLatticeCounters(state, shot);
+    state.counters["moves"] = N * (numFrames - 1) + 1;
+}
+BENCHMARK(BM_Smooth)
+    ->ArgNames({ "size", "fill", "N" })
+    ->ArgsProduct({ { 20, 50, 100 }, { 25, 50, 75 }, { 1, 10, 50, 100 } })
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_GenerateFrames(benchmark::State& state) {
+    LatticeShot shot((int)state.range(0), (int)state.range(1));
+    int N = (int)state.range(2);
+    FrameContext context;
+    for (auto _ : state) {
+        state.PauseTiming();
+        shot.load(context, N);
+        state.ResumeTiming();
+        int numFrames = generateFrames(shot.numTweezers, shot.rows, shot.cols, context.tweezerPositions(), context.trajectories, N,
+                                       shot.lattice, MAX_TIME);
+        benchmark::DoNotOptimize(numFrames);
+    }
+    setLatticeCounters(state, shot);
+}
+BENCHMARK(BM_GenerateFrames)
+    ->ArgNames({ "size", "fill", "N" })
+    ->ArgsProduct({ { 20, 50, 100 }, { 50 }, { 1, 50, 100 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// RoutedShot: a shot planned up front, for the benchmarks of the stages that consume the smoothed moves.
+struct RoutedShot {
+    LatticeShot shot;
+    FrameContext context;
+    int numMoves = 0;
+
+    RoutedShot(int size, int fillPercent, int N) : shot(size, fillPercent) {
+        shot.load(context, N);
+        int numFrames = generateFrames(shot.numTweezers, shot.rows, shot.cols, context.tweezerPositions(), context.trajectories, N,
+                                       shot.lattice, MAX_TIME);
+        numMoves = N * (numFrames - 1) + 1;
+    }
+};
+
+// BM_Stamp: rasterizes the first RGB frame of a shot (24 subframes of stamped tweezers) on one thread.
+void BM_Stamp(benchmark::State& state) {
+    RoutedShot routed((int)state.range(0), (int)state.range(1), 50);
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec spec;
+    spec.shape = (TweezerShape)state.range(3);
+    spec.size = (int)state.range(2);
+    const TweezerStamp& stamp = shapes.get(spec);
+    std::vector<uint32_t> frame((size_t)SCREEN_WIDTH * SCREEN_HEIGHT);
+    for (auto _ : state) {
+        rasterizeFrame(routed.context.trajectories, 0, SUBFRAMES_PER_FRAME, stamp, true, frame.data(), SCREEN_WIDTH, SCREEN_HEIGHT);
+        benchmark::ClobberMemory();
+    }
+    setLatticeCounters(state, routed.shot);
+}
+BENCHMARK(BM_Stamp)
+    ->ArgNames({ "size", "fill", "tweezerSize", "shape" })
+    ->ArgsProduct({ { 20, 50, 100 }, { 50 }, { 1, 3, 6 }, { (int)TweezerShape::Square, (int)TweezerShape::Disc } })
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_Remap(benchmark::State& state) {
+    DmdRemap remap;
+    remap.build(SCREEN_WIDTH, SCREEN_HEIGHT, ROW_OFFSET);
+    std::vector<uint32_t> src((size_t)SCREEN_WIDTH * SCREEN_HEIGHT, 0x00123456), dst((size_t)SCREEN_WIDTH * SCREEN_HEIGHT);
+    remap.fillOutside(dst.data(), ALL_SUBFRAMES_MASK);
+    for (auto _ : state) {
+        remap.apply(src.data(), dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed((int64_t)state.iterations() * SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+}
+BENCHMARK(BM_Remap)->Unit(benchmark::kMicrosecond);
+
+#ifdef DMD_USE_EGL
+
+// headlessDisplay: one EGL context shared by every OpenGL benchmark, or null when there is no EGL display.
+EglBackend* headlessDisplay() {
+    static EglBackend* display = nullptr;
+    static bool tried = false;
+    if (!tried) {
+        tried = true;
+        display = new EglBackend();
+        if (display->init(SCREEN_WIDTH, SCREEN_HEIGHT)) loadGLExtensions(display->procLoader());
+        else display = nullptr;
+    }
+    return display;
+}
+
+// BM_Upload: streams one packed frame into the display texture and waits until the GPU has it (the replacement for glTexImage2D).
+void BM_Upload(benchmark::State& state) {
+    EglBackend* display = headlessDisplay();
+    if (display == nullptr) {
+        state.SkipWithError("no EGL display");
+        return;
+    }
+    TextureUploader uploader;
+    uploader.init(SCREEN_WIDTH, SCREEN_HEIGHT, (int)state.range(0));
+    std::vector<uint32_t> frame((size_t)SCREEN_WIDTH * SCREEN_HEIGHT, 0x00ABCDEF);
+    for (auto _ : state) {
+        uploader.upload(frame.data());
+        glFinish();
+    }
+    uploader.release();
+    state.SetBytesProcessed((int64_t)state.iterations() * SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+}
+BENCHMARK(BM_Upload)->ArgName("ringSize")->Arg(1)->Arg(3)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// BM_Present: clears the target and presents it (glFinish in place of glfwSwapBuffers, which would also wait for vertical sync).
+void BM_Present(benchmark::State& state) {
+    EglBackend* display = headlessDisplay();
+    if (display == nullptr) {
+        state.SkipWithError("no EGL display");
+        return;
+    }
+    for (auto _ : state) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        display->present();
+    }
+}
+BENCHMARK(BM_Present)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// BM_TimeToFirstFrame: plans a shot and displays its first RGB frame through the whole renderer, with the given number of pipeline
+// workers (0 renders in line) and with or without GPU rasterization.
+void BM_TimeToFirstFrame(benchmark::State& state) {
+    if (headlessDisplay() == nullptr) {
+        state.SkipWithError("no EGL display");
+        return;
+    }
+    static DmdRenderer* renderer = nullptr;
+    static DmdRendererConfig current;
+    DmdRendererConfig config;
+    config.headless = true;
+    config.shaderDirectory = DMD_SOURCE_DIRECTORY;
+    config.pipelineWorkers = (int)state.range(2);
+    config.gpuRaster = state.range(3) != 0;
+    if (renderer == nullptr || current.pipelineWorkers != config.pipelineWorkers || current.gpuRaster != config.gpuRaster) {
+        delete renderer;
+        renderer = new DmdRenderer();
+        current = config;
+        if (!renderer->init(config)) {
+            state.SkipWithError("renderer could not be set up");
+            return;
+        }
+    }
+
+    LatticeShot shot((int)state.range(0), (int)state.range(1));
+    std::vector<uint8_t> occupancy(shot.occupancy.begin(), shot.occupancy.end());
+    ShotRequest request;
+    request.occupancy = occupancy.data();
+    request.occupancyRows = shot.rows;
+    request.occupancyCols = shot.cols;
+    request.N = 1;
+    request.lattice = shot.lattice;
+    request.shape.size = 3;
+    for (auto _ : state) {
+        // With N = 1 and at most 40 lattice moves, each shot fits in two RGB frames, so the shot time is dominated by the first one.
+        ShotResult result = renderer->runShot(request);
+        benchmark::DoNotOptimize(result.numRgbFrames);
+    }
+    setLatticeCounters(state, shot);
+}
+BENCHMARK(BM_TimeToFirstFrame)
+    ->ArgNames({ "size", "fill", "workers", "gpuRaster" })
+    ->ArgsProduct({ { 20, 100 }, { 50 }, { 0, 2 }, { 0, 1 } })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#endif
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+/* Compares the per-frame rasterization cost of each tweezer shape.
+   To compile: build the tweezer_shape_benchmark target of the CMake project (see CMakeLists.txt).
+   To run: ./tweezer_shape_benchmark [numTweezers] [tweezerSize] */
+
+#include "../core/bitplane_rasterizer.h"
+#include "../core/tweezer_shapes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+const int SCR_WIDTH = 1140;
+const int SCR_HEIGHT = 912;
+const int NUM_FRAMES = 200;
+
+const int TWEEZER_PATTERN[13][2] = {
+                       {0, 2},
+             {-1, 1},  {0, 1},  {1, 1},
+    {-2, 0}, {-1, 0},  {0, 0},  {1, 0}, {2, 0},
+             {-1, -1}, {0, -1}, {1, -1},
+                       {0, -2}
+};
+
+int main(int argc, char** argv) {
+    int numTweezers = argc > 1 ? atoi(argv[1]) : 400;
+    int tweezerSize = argc > 2 ? atoi(argv[2]) : 3;
+
+    // Tweezers on a square grid in the middle of the screen, drifting by a fraction of a pixel per subframe.
+    TrajectoryStore trajectories;
+    trajectories.reserve(numTweezers, SUBFRAMES_PER_FRAME, 2);
+    int side = 1;
+    while (side * side < numTweezers) side++;
+    for (int j = 0; j < SUBFRAMES_PER_FRAME; j++) {
+        for (int i = 0; i < numTweezers; i++) {
+            trajectories.moveX(j, i) = 100.0f + (i / side) * 700.0f / side + 0.4f * j;
+            trajectories.moveY(j, i) = 200.0f + (i % side) * 700.0f / side + 0.4f * j;
+        }
+    }
+
+    std::vector<uint8_t> customMask = {
+        0, 1, 1, 1, 0,
+        1, 1, 0, 1, 1,
+        1, 0, 0, 0, 1,
+        1, 1, 0, 1, 1,
+        0, 1, 1, 1, 0
+    };
+
+    TweezerShapeRegistry registry;
+    registry.setPattern(TWEEZER_PATTERN, 13);
+    struct Case { const char* name; TweezerShapeSpec spec; };
+    std::vector<Case> cases(6);
+    cases[0].name = "square";
+    cases[0].spec.shape = TweezerShape::Square;
+    cases[1].name = "diamond";
+    cases[1].spec.shape = TweezerShape::Diamond;
+    cases[2].name = "disc";
+    cases[2].spec.shape = TweezerShape::Disc;
+    cases[3].name = "gaussian";
+    cases[3].spec.shape = TweezerShape::Gaussian;
+    cases[3].spec.parameter = 0.5f;
+    cases[4].name = "pattern";
+    cases[4].spec.shape = TweezerShape::Pattern;
+    cases[5].name = "custom";
+    cases[5].spec.shape = TweezerShape::Custom;
+    cases[5].spec.mask = customMask.data();
+    cases[5].spec.maskRows = 5;
+    cases[5].spec.maskCols = 5;
+
+    std::vector<uint32_t> frame((size_t)SCR_WIDTH * SCR_HEIGHT);
+    std::vector<double> times(NUM_FRAMES);
+
+    printf("%d tweezers, tweezerSize %d, %d frames per shape\n", numTweezers, tweezerSize, NUM_FRAMES);
+    printf("%-10s %8s %8s %12s %12s\n", "shape", "pixels", "spans", "median (us)", "min (us)");
+    for (Case& c : cases) {
+        c.spec.size = tweezerSize;
+        const TweezerStamp& stamp = registry.get(c.spec);
+        int pixels = 0;
+        for (const StampSpan& span : stamp.spans) pixels += span.colEnd - span.colBegin;
+
+        for (int f = 0; f < NUM_FRAMES; f++) {
+            auto start = std::chrono::steady_clock::now();
+            rasterizeFrame(trajectories, 0, SUBFRAMES_PER_FRAME, stamp, true, frame.data(), SCR_WIDTH, SCR_HEIGHT);
+            auto end = std::chrono::steady_clock::now();
+            times[f] = std::chrono::duration<double, std::micro>(end - start).count();
+        }
+        std::sort(times.begin(), times.end());
+        printf("%-10s %8d %8d %12.1f %12.1f\n", c.name, pixels, (int)stamp.spans.size(), times[NUM_FRAMES / 2], times[0]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+/* dmd_cli: runs shots through the renderer without MATLAB, for profiling and for sequencers that drive the DMD directly.
+   Each shot is read from a text file (see shot_file.h) and displayed as the MEX function would display it; timings and the upload and
+   pipeline statistics are printed per shot. A shot file with a replan section is held at its frame, repaired and continued.
+   Usage: dmd_cli [options] shot-file...
+      --headless              render offscreen through EGL (no display needed)
+      --window                use an ordinary window instead of the second monitor
+      --plan-only             only route and smooth the shots; no OpenGL is used
+      --repeat <count>        run every shot this many times
+      --capture <directory>   write every displayed frame to the directory as a PPM file
+      --shaders <directory>   the directory holding the shaders (default: the working directory)
+      --gpu-remap             remap in the fragment shader
+      --gpu-raster [path]     draw the tweezers on the GPU; path is auto, compute or instanced
+      --no-invert             do not invert the frames
+      --workers <count>       threads producing frames ahead of the display (0 renders in line)
+      --raster-threads <count>
+      --max-time <count>      the maximum number of lattice moves in a shot
+      --plan-cache <count>    keep the plans of this many shots, and display a shot seen before without routing it again
+      --cache-frames          with --plan-cache, keep the RGB frames of the plans too, so that a repeated shot is not rasterized again
+      --refresh <hz>          the refresh rate that presents are checked against (default: the monitor's, if known)
+      --routing <method>      route every shot with this method: com, assignment or reservation (default: as given in the shot file)
+      --topology <topology>   route every shot on this lattice: square or triangular (default: as given in the shot file)
+      --pacing <action>       on a late or dropped frame: report (default), abort or reissue
+      --trace <file>          write the latency trace of every shot to the file as Chrome-trace JSON
+      --trace-capacity <count>
+                              the number of timestamps kept for --trace (default 65536) */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "shot_file.h"
+#include "../core/frame_context.h"
+#include "../core/plan_cache.h"
+#include "../core/router.h"
+
+static void printUsage() {
+    fprintf(stderr, "Usage: dmd_cli [--headless] [--window] [--plan-only] [--repeat count] [--capture directory] [--shaders directory]\n"
+                    "               [--gpu-remap] [--gpu-raster [auto|compute|instanced]] [--no-invert] [--workers count]\n"
+                    "               [--raster-threads count] [--max-time count] [--plan-cache count] [--cache-frames]\n"
+                    "               [--routing com|assignment|reservation]\n"
+                    "               [--topology square|triangular] [--refresh hz] [--pacing report|abort|reissue] [--trace file]\n"
+                    "               [--trace-capacity count] shot-file...\n");
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// printTargets: prints how well a shot filled its target pattern.
+static void printTargets(int numTargets, int targetsFilled, int parkedAtoms, long long assignmentCost) {
+    printf("    targets: %d of %d filled, %d atoms parked, assignment cost %lld\n", targetsFilled, numTargets, parkedAtoms, assignmentCost);
+}
+
+// planOnly: routes and smooths a shot with the core library alone, taking the plan from cache if it holds one, and returns the number
+// of lattice frames.
+static int planOnly(const ShotRequest& request, int maxTime, FrameContext& context, PlanCache& cache, const std::string& name) {
+    auto start = std::chrono::steady_clock::now();
+    int numTweezers = 0;
+    for (int i = 0; i < request.occupancyRows * request.occupancyCols; i++) numTweezers += request.occupancy[i] == 1;
+    int numFrames = 0;
+    const CachedPlan* plan = nullptr;
+    bool cached = false;
+    if (numTweezers > 0) {
+        context.prepare(request.occupancyRows, request.occupancyCols, numTweezers, request.N, maxTime);
+        if (cache.enabled()) {
+            plan = cache.find(request.occupancy, request.occupancyRows, request.occupancyCols, request.N, request.lattice, maxTime,
+                              request.routing, request.targetPattern);
+        }
+        if (plan != nullptr) {
+            context.trajectories.copyFrom(plan->trajectories, plan->numLatticeFrames);
+            numFrames = plan->numLatticeFrames;
+            cached = true;
+        }
+        else {
+            int** tweezerPositions = context.tweezerPositions();
+            for (int i = 0; i < request.occupancyRows; i++) {
+                for (int j = 0; j < request.occupancyCols; j++) {
+                    tweezerPositions[i][j] = request.occupancy[i * request.occupancyCols + j];
+                }
+            }
+            numFrames = generateFrames(numTweezers, request.occupancyRows, request.occupancyCols, tweezerPositions, context.trajectories,
+                                       request.N, request.lattice, maxTime, request.routing, &context.routing, &context.reservation,
+                                       &context.centerOfMass, request.targetPattern);
+            if (cache.enabled()) {
+                CachedPlan& stored = cache.insert(context.trajectories, numTweezers, numFrames);
+                stored.assignmentCost = context.routing.assignmentCost;
+                stored.numTargets = context.routing.numTargets;
+                stored.targetsFilled = context.routing.targetsFilled;
+                stored.parkedAtoms = context.routing.parkedAtoms;
+                cache.trim();
+            }
+        }
+    }
+    double elapsed = millisecondsSince(start);
+    printf("%s: %d tweezers, %d lattice frames, %lld site steps, %d moves, plan %.3f ms%s\n", name.c_str(), numTweezers, numFrames,
+           numFrames > 0 ? countLatticeMoves(context.trajectories, numTweezers, numFrames, request.lattice.topology) : 0LL,
+           numFrames > 0 ? request.N * (numFrames - 1) + 1 : 0, elapsed, cached ? " (cached)" : "");
+    if (numFrames > 0 && request.targetPattern != nullptr) {
+        if (plan != nullptr) printTargets(plan->numTargets, plan->targetsFilled, plan->parkedAtoms, plan->assignmentCost);
+        else {
+            printTargets(context.routing.numTargets, context.routing.targetsFilled, context.routing.parkedAtoms,
+                         context.routing.assignmentCost);
+        }
+    }
+    return numFrames;
+}
+
+// printReplan: prints what repairing a plan changed and produced.
+static void printReplan(int fromFrame, int lostAtoms, int extraAtoms, int repairedPaths, int numTweezers, int numFrames, double elapsed) {
+    printf("    replan from frame %d: %d lost, %d extra, ", fromFrame, lostAtoms, extraAtoms);
+    if (repairedPaths < 0) printf("routed from scratch");
+    else printf("%d paths repaired", repairedPaths);
+    printf(", %d tweezers, %d lattice frames, replan %.3f ms\n", numTweezers, numFrames, elapsed);
+}
+
+// replanOnly: repairs the plan that planOnly left in context from the frame and delta of a shot file, with the core library alone
+// (see DmdRenderer::replanShot); if it cannot be repaired, the occupancy found by the image is planned from scratch.
+static void replanOnly(const ShotFile& shot, int planFrames, int maxTime, FrameContext& context, PlanCache& cache,
+                       const std::string& name) {
+    const ShotRequest& request = shot.request;
+    if (planFrames == 0) return;
+    auto start = std::chrono::steady_clock::now();
+    ReplanWorkspace& workspace = context.replan;
+    std::swap(context.trajectories, workspace.previous);
+    int numFrames = replanFrames(workspace.previous, planFrames, shot.replanFrame, shot.delta.data(), request.occupancyRows,
+                                 request.occupancyCols, context.trajectories, request.N, request.lattice, maxTime, workspace,
+                                 context.reservation, request.targetPattern);
+    if (numFrames > 0) {
+        printReplan(shot.replanFrame, workspace.lostAtoms, workspace.extraAtoms, workspace.repairedPaths, context.trajectories.numTweezers,
+                    numFrames, millisecondsSince(start));
+        return;
+    }
+    printReplan(shot.replanFrame, workspace.lostAtoms, workspace.extraAtoms, -1, 0, 0, millisecondsSince(start));
+    ShotRequest observed = request;
+    observed.occupancy = workspace.observed.data();
+    planOnly(observed, maxTime, context, cache, name + " (observed)");
+}
+
+// printPlanCache: prints the statistics of a plan cache, if it is enabled.
+static void printPlanCache(const PlanCache& cache) {
+    if (!cache.enabled()) return;
+    const PlanCache::Stats& stats = cache.stats();
+    printf("plan cache: %lld lookups, %lld hits (%.1f%%), %d plans, %zu bytes, %lld evictions, %lld frame sets skipped\n",
+           stats.lookups, stats.hits, 100.0 * stats.hitRate(), cache.size(), cache.capacityBytes(), stats.evictions,
+           stats.framesSkipped);
+}
+
+int main(int argc, char** argv) {
+    DmdRendererConfig config;
+    bool planOnlyMode = false;
+    int repeat = 1;
+    bool overrideRouting = false;
+    RoutingMethod routing = RoutingMethod::CenterOfMass;
+    bool overrideTopology = false;
+    LatticeTopology topology = LatticeTopology::Square;
+    std::string traceFile;
+    int traceCapacity = 65536;
+    std::vector<std::string> shotFiles;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--headless") config.headless = true;
+        else if (option == "--window") config.useSecondMonitor = false;
+        else if (option == "--plan-only") planOnlyMode = true;
+        else if (option == "--gpu-remap") config.gpuRemap = true;
+        else if (option == "--no-invert") config.inverted = false;
+        else if (option == "--gpu-raster") {
+            config.gpuRaster = true;
+            if (hasValue && (!strcmp(argv[i + 1], "auto") || !strcmp(argv[i + 1], "compute") || !strcmp(argv[i + 1], "instanced"))) {
+                std::string path = argv[++i];
+                config.gpuRasterPath = path == "compute" ? GpuRasterPath::Compute :
+                                       path == "instanced" ? GpuRasterPath::Instanced : GpuRasterPath::Automatic;
+            }
+        }
+        else if (option == "--repeat" && hasValue) repeat = atoi(argv[++i]);
+        else if (option == "--capture" && hasValue) config.captureDirectory = argv[++i];
+        else if (option == "--shaders" && hasValue) config.shaderDirectory = std::string(argv[++i]) + "/";
+        else if (option == "--workers" && hasValue) config.pipelineWorkers = atoi(argv[++i]);
+        else if (option == "--raster-threads" && hasValue) config.rasterThreads = atoi(argv[++i]);
+        else if (option == "--max-time" && hasValue) config.maxTime = atoi(argv[++i]);
+        else if (option == "--plan-cache" && hasValue) config.planCacheEntries = atoi(argv[++i]);
+        else if (option == "--cache-frames") config.cacheFrames = true;
+        else if (option == "--routing" && hasValue) {
+            overrideRouting = true;
+            if (!parseRoutingMethod(argv[++i], routing)) {
+                printUsage();
+                return 2;
+            }
+        }
+        else if (option == "--topology" && hasValue) {
+            overrideTopology = true;
+            if (!parseLatticeTopology(argv[++i], topology)) {
+                printUsage();
+                return 2;
+            }
+        }
+        else if (option == "--refresh" && hasValue) config.refreshRate = atof(argv[++i]);
+        else if (option == "--pacing" && hasValue) {
+            std::string action = argv[++i];
+            if (action == "report") config.pacingAction = PacingAction::Report;
+            else if (action == "abort") config.pacingAction = PacingAction::Abort;
+            else if (action == "reissue") config.pacingAction = PacingAction::Reissue;
+            else {
+                printUsage();
+                return 2;
+            }
+        }
+        else if (option == "--trace" && hasValue) traceFile = argv[++i];
+        else if (option == "--trace-capacity" && hasValue) traceCapacity = atoi(argv[++i]);
+        else if (option[0] == '-') {
+            printUsage();
+            return 2;
+        }
+        else shotFiles.push_back(option);
+    }
+    if (shotFiles.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<ShotFile> shots(shotFiles.size());
+    for (size_t i = 0; i < shots.size(); i++) {
+        std::string error;
+        if (!readShotFile(shotFiles[i], shots[i], error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (overrideRouting) shots[i].request.routing = routing;
+        if (overrideTopology) shots[i].request.lattice.topology = topology;
+    }
+
+    if (planOnlyMode) {
+        FrameContext context;
+        PlanCache cache;
+        cache.configure(config.planCacheEntries, config.planCacheBytes);
+        for (int r = 0; r < repeat; r++) {
+            for (size_t i = 0; i < shots.size(); i++) {
+                int numFrames = planOnly(shots[i].request, config.maxTime, context, cache, shotFiles[i]);
+                if (shots[i].replanFrame >= 0) replanOnly(shots[i], numFrames, config.maxTime, context, cache, shotFiles[i]);
+            }
+        }
+        printPlanCache(cache);
+        return 0;
+    }
+
+    if (!traceFile.empty()) config.traceCapacity = traceCapacity;
+    DmdRenderer renderer;
+    if (!renderer.init(config)) return 1;
+    for (int r = 0; r < repeat; r++) {
+        for (size_t i = 0; i < shots.size(); i++) {
+            auto start = std::chrono::steady_clock::now();
+            // A shot with a replan section is held at the frame of its image, and continued from there.
+            ShotRequest request = shots[i].request;
+            request.holdFrame = shots[i].replanFrame;
+            ShotResult result = renderer.runShot(request);
+            double elapsed = millisecondsSince(start);
+            const TextureUploader::UploadStats& upload = renderer.uploadStats();
+            const FramePipeline::PipelineStats& pipeline = renderer.pipelineStats();
+            printf("%s: %d tweezers, %d lattice frames, %d moves, %d RGB frames, shot %.3f ms (%.3f ms per frame)%s\n",
+                   shotFiles[i].c_str(), result.numTweezers, result.numLatticeFrames, result.numMoves, result.numRgbFrames, elapsed,
+                   result.numRgbFrames > 0 ? elapsed / result.numRgbFrames : 0.0,
+                   result.framesCached ? " (cached plan and frames)" : result.planCached ? " (cached plan)" : "");
+            if (shots[i].request.targetPattern != nullptr) {
+                printTargets(result.numTargets, result.targetsFilled, result.parkedAtoms, result.assignmentCost);
+            }
+            printf("    upload: %lld uploads, mean CPU %.1f us, max CPU %.1f us, fence waits %lld\n", upload.uploads,
+                   upload.uploads > 0 ? upload.totalCpuMicroseconds / upload.uploads : 0.0, upload.maxCpuMicroseconds, upload.fenceWaits);
+            printf("    pipeline: %lld frames, %lld underruns, first frame wait %.1f us\n", pipeline.framesConsumed, pipeline.underruns,
+                   pipeline.firstFrameWaitMicroseconds);
+            const PacingReport& pacing = renderer.pacingReport();
+            printf("    pacing: %d presents, interval mean %.1f us (min %.1f, max %.1f, expected %.1f), %d late (%d repeated refreshes),"
+                   " %d dropped, %d reissues%s\n", pacing.presents, pacing.meanIntervalMicroseconds(), pacing.minIntervalMicroseconds,
+                   pacing.maxIntervalMicroseconds, pacing.expectedPeriodMicroseconds, pacing.lateFrames, pacing.repeatedRefreshes,
+                   pacing.droppedFrames, pacing.reissues, pacing.aborted ? ", aborted" : "");
+            if (!result.completed) return 1;
+            if (shots[i].replanFrame >= 0) {
+                start = std::chrono::steady_clock::now();
+                result = renderer.replanShot(shots[i].request, shots[i].replanFrame, shots[i].delta.data());
+                printReplan(shots[i].replanFrame, result.lostAtoms, result.extraAtoms, result.repairedPaths, result.numTweezers,
+                            result.numLatticeFrames, millisecondsSince(start));
+                if (!result.completed) return 1;
+            }
+        }
+    }
+    printf("high-water memory: %zu bytes\n", renderer.context().highWaterBytes);
+    printPlanCache(renderer.planCache());
+    if (!traceFile.empty()) {
+        const LatencyTrace& trace = renderer.latencyTrace();
+        if (!trace.writeChromeTrace(traceFile)) {
+            fprintf(stderr, "Could not write %s\n", traceFile.c_str());
+            return 1;
+        }
+        if (trace.recorded() > traceCapacity) {
+            printf("trace: kept the last %d of %lld timestamps; raise --trace-capacity to keep them all\n", traceCapacity, trace.recorded());
+        }
+    }
+    return 0;
+}
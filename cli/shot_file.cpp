@@ -0,0 +1,160 @@
+#include "shot_file.h"
+
+#include <fstream>
+#include <sstream>
+
+// readMatrix: reads rows * cols whitespace-separated values into matrix, as 1 where the value is nonzero (or exactly 1 if exact).
+static bool readMatrix(std::istream& in, int rows, int cols, bool exact, std::vector<uint8_t>& matrix) {
+    matrix.assign((size_t)rows * cols, 0);
+    for (size_t i = 0; i < matrix.size(); i++) {
+        double value;
+        if (!(in >> value)) return false;
+        matrix[i] = exact ? value == 1.0 : value != 0.0;
+    }
+    return true;
+}
+
+// readPattern: reads rows * cols whitespace-separated TargetSite values into pattern (any other value being a free site).
+static bool readPattern(std::istream& in, int rows, int cols, std::vector<uint8_t>& pattern) {
+    pattern.assign((size_t)rows * cols, (uint8_t)TargetSite::Free);
+    for (size_t i = 0; i < pattern.size(); i++) {
+        double value;
+        if (!(in >> value)) return false;
+        if (value == 1.0) pattern[i] = (uint8_t)TargetSite::Target;
+        else if (value == 2.0) pattern[i] = (uint8_t)TargetSite::Reservoir;
+    }
+    return true;
+}
+
+// readDelta: reads rows * cols whitespace-separated AtomChange values into delta (any other value being no change).
+static bool readDelta(std::istream& in, int rows, int cols, std::vector<int8_t>& delta) {
+    delta.assign((size_t)rows * cols, (int8_t)AtomChange::Unchanged);
+    for (size_t i = 0; i < delta.size(); i++) {
+        double value;
+        if (!(in >> value)) return false;
+        if (value == -1.0) delta[i] = (int8_t)AtomChange::Lost;
+        else if (value == 1.0) delta[i] = (int8_t)AtomChange::Extra;
+    }
+    return true;
+}
+
+// parseShape: reads a TweezerShape given by name or number.
+static bool parseShape(const std::string& name, TweezerShape& shape) {
+    const char* names[] = { "square", "diamond", "disc", "gaussian", "pattern", "custom" };
+    for (int i = 0; i < 6; i++) {
+        if (name == names[i] || name == std::to_string(i)) {
+            shape = (TweezerShape)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseRoutingMethod(const std::string& name, RoutingMethod& method) {
+    const char* names[] = { "com", "assignment", "reservation" };
+    for (int i = 0; i < 3; i++) {
+        if (name == names[i] || name == std::to_string(i)) {
+            method = (RoutingMethod)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseLatticeTopology(const std::string& name, LatticeTopology& topology) {
+    const char* names[] = { "square", "triangular" };
+    for (int i = 0; i < 2; i++) {
+        if (name == names[i] || name == std::to_string(i)) {
+            topology = (LatticeTopology)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readShotFile(const std::string& path, ShotFile& shot, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    ShotRequest& request = shot.request;
+    request = ShotRequest();
+    shot.occupancy.clear();
+    shot.mask.clear();
+    shot.target.clear();
+    shot.replanFrame = -1;
+    shot.delta.clear();
+    bool haveSize = false, haveOccupancy = false, haveN = false, haveLattice[3] = { false, false, false };
+    std::string keyword;
+    while (file >> keyword) {
+        if (keyword[0] == '#') {
+            std::string comment;
+            std::getline(file, comment);
+            continue;
+        }
+
+        bool ok = true;
+        if (keyword == "size") {
+            // The matrices read so far have the dimensions given first.
+            if (haveSize) {
+                error = path + ": 'size' given more than once";
+                return false;
+            }
+            ok = (bool)(file >> request.occupancyRows >> request.occupancyCols) && request.occupancyRows > 0 && request.occupancyCols > 0;
+            haveSize = ok;
+        }
+        else if (keyword == "N") {
+            ok = (bool)(file >> request.N) && request.N > 0;
+            haveN = ok;
+        }
+        else if (keyword == "tweezerSize") ok = (bool)(file >> request.shape.size);
+        else if (keyword == "vec1") ok = haveLattice[0] = (bool)(file >> request.lattice.vec1X >> request.lattice.vec1Y);
+        else if (keyword == "vec2") ok = haveLattice[1] = (bool)(file >> request.lattice.vec2X >> request.lattice.vec2Y);
+        else if (keyword == "center") ok = haveLattice[2] = (bool)(file >> request.lattice.centerX >> request.lattice.centerY);
+        else if (keyword == "topology") {
+            std::string name;
+            ok = (bool)(file >> name) && parseLatticeTopology(name, request.lattice.topology);
+        }
+        else if (keyword == "shape") {
+            std::string name;
+            ok = (bool)(file >> name) && parseShape(name, request.shape.shape);
+        }
+        else if (keyword == "parameter") ok = (bool)(file >> request.shape.parameter);
+        else if (keyword == "routing") {
+            std::string name;
+            ok = (bool)(file >> name) && parseRoutingMethod(name, request.routing);
+        }
+        else if (keyword == "mask") {
+            ok = (bool)(file >> request.shape.maskRows >> request.shape.maskCols) && request.shape.maskRows > 0 &&
+                 request.shape.maskCols > 0 && readMatrix(file, request.shape.maskRows, request.shape.maskCols, false, shot.mask);
+        }
+        else if (keyword == "occupancy") {
+            ok = haveSize && readMatrix(file, request.occupancyRows, request.occupancyCols, true, shot.occupancy);
+            haveOccupancy = ok;
+        }
+        else if (keyword == "target") ok = haveSize && readPattern(file, request.occupancyRows, request.occupancyCols, shot.target);
+        else if (keyword == "replan") {
+            ok = haveSize && (bool)(file >> shot.replanFrame) && shot.replanFrame >= 0 &&
+                 readDelta(file, request.occupancyRows, request.occupancyCols, shot.delta);
+        }
+        else {
+            error = path + ": unknown keyword '" + keyword + "'";
+            return false;
+        }
+        if (!ok) {
+            error = path + ": invalid or missing values for '" + keyword + "'";
+            return false;
+        }
+    }
+
+    if (!haveSize || !haveOccupancy || !haveN || !haveLattice[0] || !haveLattice[1] || !haveLattice[2]) {
+        error = path + ": size, N, vec1, vec2, center and occupancy are required";
+        return false;
+    }
+    request.occupancy = shot.occupancy.data();
+    request.shape.mask = shot.mask.empty() ? nullptr : shot.mask.data();
+    request.targetPattern = shot.target.empty() ? nullptr : shot.target.data();
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef SHOT_FILE_H
+#define SHOT_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../render/dmd_renderer.h"
+
+// ShotFile: a shot read from a text file, for driving the renderer without MATLAB. The file holds one keyword per line followed by its
+// values; blank lines and lines starting with # are ignored:
+//      size <rows> <cols>              the dimensions of the occupancy matrix, given once and before the matrices sized by it
+//      N <n>                           the smoothing factor
+//      tweezerSize <size>              see TweezerShapeSpec::size
+//      vec1 <x> <y>                    the lattice vectors and center, in DMD pixels (see LatticeGeometry)
+//      vec2 <x> <y>
+//      center <x> <y>
+//      topology <name or number>       optional: square or triangular (see LatticeTopology)
+//      shape <name or number>          optional: square, diamond, disc, gaussian or custom (see TweezerShape)
+//      parameter <value>               optional: the Gaussian cut-off (see TweezerShapeSpec::parameter)
+//      mask <rows> <cols>              optional: a custom tweezer mask, followed by <rows> rows of <cols> values, nonzero where drawn
+//      routing <name or number>        optional: com, assignment or reservation (see RoutingMethod)
+//      occupancy                       followed by <rows> rows of <cols> values, 1 where a site holds an atom
+//      target                          optional: a target pattern, followed by <rows> rows of <cols> values, 1 for a target site and 2
+//                                      for a reservoir site (see TargetSite)
+//      replan <frame>                  optional: hold the shot at lattice frame <frame> and repair its plan from there (see
+//                                      DmdRenderer::replanShot), followed by <rows> rows of <cols> values, -1 where an atom was lost,
+//                                      1 where an extra atom was found and 0 elsewhere (see AtomChange)
+struct ShotFile {
+    ShotRequest request;
+    std::vector<uint8_t> occupancy;
+    std::vector<uint8_t> mask;
+    std::vector<uint8_t> target;
+    int replanFrame = -1;                  // the lattice frame to repair the plan from, or -1 if the file has no replan section
+    std::vector<int8_t> delta;
+};
+
+// readShotFile: parses a shot file. Returns false, with a message in error, if the file cannot be read or is incomplete.
+bool readShotFile(const std::string& path, ShotFile& shot, std::string& error);
+
+// parseRoutingMethod: reads a RoutingMethod given by name or number. Returns false if there is no such method.
+bool parseRoutingMethod(const std::string& name, RoutingMethod& method);
+
+// parseLatticeTopology: reads a LatticeTopology given by name or number. Returns false if there is no such topology.
+bool parseLatticeTopology(const std::string& name, LatticeTopology& topology);
+
+#endif
@@ -0,0 +1,67 @@
+#include "assignment.h"
+
+#include <cstddef>
+#include <limits>
+
+long long AssignmentSolver::solve(const int* cost, int rows, int cols, int* assignment) {
+    const long long INF = std::numeric_limits<long long>::max() / 4;
+    // Rows and columns are numbered from 1 below; column 0 is the virtual column from which each augmenting path starts.
+    rowPotential.assign(rows + 1, 0);
+    colPotential.assign(cols + 1, 0);
+    colOwner.assign(cols + 1, 0);
+    previousCol.assign(cols + 1, 0);
+    minSlack.resize(cols + 1);
+    visited.resize(cols + 1);
+
+    for (int row = 1; row <= rows; row++) {
+        // Grow a tree of tight edges from the new row until it reaches a free column, then flip the path.
+        colOwner[0] = row;
+        int col = 0;
+        for (int j = 0; j <= cols; j++) {
+            minSlack[j] = INF;
+            visited[j] = 0;
+        }
+        do {
+            visited[col] = 1;
+            int owner = colOwner[col];
+            const int* ownerCost = cost + (size_t)(owner - 1) * cols;
+            long long delta = INF;
+            int nextCol = 0;
+            for (int j = 1; j <= cols; j++) {
+                if (visited[j]) continue;
+                long long slack = ownerCost[j - 1] - rowPotential[owner] - colPotential[j];
+                if (slack < minSlack[j]) {
+                    minSlack[j] = slack;
+                    previousCol[j] = col;
+                }
+                if (minSlack[j] < delta) {
+                    delta = minSlack[j];
+                    nextCol = j;
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (visited[j]) {
+                    rowPotential[colOwner[j]] += delta;
+                    colPotential[j] -= delta;
+                }
+                else {
+                    minSlack[j] -= delta;
+                }
+            }
+            col = nextCol;
+        } while (colOwner[col] != 0);
+        do {
+            int previous = previousCol[col];
+            colOwner[col] = colOwner[previous];
+            col = previous;
+        } while (col != 0);
+    }
+
+    long long total = 0;
+    for (int j = 1; j <= cols; j++) {
+        if (colOwner[j] == 0) continue;
+        assignment[colOwner[j] - 1] = j - 1;
+        total += cost[(size_t)(colOwner[j] - 1) * cols + (j - 1)];
+    }
+    return total;
+}
@@ -0,0 +1,23 @@
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <vector>
+
+// AssignmentSolver: minimum-cost assignment of rows to columns with the Hungarian algorithm (shortest augmenting paths with
+// potentials), in O(rows^2 * cols) time. Its buffers are kept between calls, so repeated problems of similar size do not allocate.
+class AssignmentSolver {
+public:
+    // solve: assigns every row to a distinct column so that the total cost is minimal, and returns that cost.
+    // Inputs:
+    //      cost: a row-major rows * cols matrix of non-negative costs
+    //      rows, cols: the dimensions of the matrix, with rows <= cols
+    //      assignment: receives the column assigned to each row (rows entries)
+    long long solve(const int* cost, int rows, int cols, int* assignment);
+
+private:
+    std::vector<long long> rowPotential, colPotential, minSlack;
+    std::vector<int> colOwner, previousCol;
+    std::vector<char> visited;
+};
+
+#endif
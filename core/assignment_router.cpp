@@ -0,0 +1,270 @@
+#include "assignment_router.h"
+
+#include <algorithm>
+
+// The number of times a frame in which no tweezer could move is retried after exchanging targets, before routing gives up.
+static const int MAX_STALLED_PASSES = 2;
+
+static int latticeDistance(const LatticeNeighbourhood& neighbourhood, int row, int col, int targetRow, int targetCol) {
+    return neighbourhood.distance(targetRow - row, targetCol - col);
+}
+
+// chooseTargets: marks the numTweezers sites closest to the center of mass as targets (ties broken by row, then column).
+static void chooseTargets(int numTweezers, int occupancyRows, int occupancyCols, double comRow, double comCol,
+                          AssignmentWorkspace& workspace) {
+    int numSites = occupancyRows * occupancyCols;
+    std::vector<int>& sites = workspace.sites;
+    sites.resize(numSites);
+    for (int s = 0; s < numSites; s++) sites[s] = s;
+    auto closer = [&](int a, int b) {
+        double rowA = a / occupancyCols - comRow, colA = a % occupancyCols - comCol;
+        double rowB = b / occupancyCols - comRow, colB = b % occupancyCols - comCol;
+        double distanceA = rowA * rowA + colA * colA, distanceB = rowB * rowB + colB * colB;
+        return distanceA != distanceB ? distanceA < distanceB : a < b;
+    };
+    if (numTweezers < numSites) std::nth_element(sites.begin(), sites.begin() + numTweezers, sites.end(), closer);
+    workspace.targets.reset(occupancyRows, occupancyCols);
+    for (int t = 0; t < numTweezers; t++) workspace.targets.set(sites[t] / occupancyCols, sites[t] % occupancyCols);
+}
+
+// choosePatternTargets: marks the target and reservoir sites of a target pattern, listing the target sites first and the reservoir sites
+// after them in workspace.sites, and returns the number of target sites.
+static int choosePatternTargets(const uint8_t* targetPattern, int occupancyRows, int occupancyCols, AssignmentWorkspace& workspace,
+                                int& numReservoir) {
+    int numSites = occupancyRows * occupancyCols;
+    std::vector<int>& sites = workspace.sites;
+    sites.clear();
+    workspace.targets.reset(occupancyRows, occupancyCols);
+    workspace.reservoir.reset(occupancyRows, occupancyCols);
+    for (int s = 0; s < numSites; s++) {
+        if (targetPattern[s] != (uint8_t)TargetSite::Target) continue;
+        sites.push_back(s);
+        workspace.targets.set(s / occupancyCols, s % occupancyCols);
+    }
+    int numTargets = (int)sites.size();
+    for (int s = 0; s < numSites; s++) {
+        if (targetPattern[s] != (uint8_t)TargetSite::Reservoir) continue;
+        sites.push_back(s);
+        workspace.reservoir.set(s / occupancyCols, s % occupancyCols);
+    }
+    numReservoir = (int)sites.size() - numTargets;
+    return numTargets;
+}
+
+// matchSites: matches the tweezers in "atoms" with the sites in "sites" at minimum total lattice distance, as many pairs as the smaller of
+// the two lists holds, sets the target of every matched tweezer and returns the total distance.
+static long long matchSites(const std::vector<int>& atoms, const std::vector<int>& sites, int occupancyCols,
+                            const LatticeNeighbourhood& neighbourhood, TrajectoryStore& trajectories, AssignmentWorkspace& workspace) {
+    int numAtoms = (int)atoms.size(), numSites = (int)sites.size();
+    if (numAtoms == 0 || numSites == 0) return 0;
+    // The solver assigns every row, so the shorter list gives the rows.
+    bool byAtom = numAtoms <= numSites;
+    int rows = byAtom ? numAtoms : numSites, cols = byAtom ? numSites : numAtoms;
+    workspace.cost.resize((size_t)rows * cols);
+    for (int a = 0; a < numAtoms; a++) {
+        int row = trajectories.latticeRow(0, atoms[a]), col = trajectories.latticeCol(0, atoms[a]);
+        for (int t = 0; t < numSites; t++) {
+            int distance = latticeDistance(neighbourhood, row, col, sites[t] / occupancyCols, sites[t] % occupancyCols);
+            workspace.cost[byAtom ? (size_t)a * numSites + t : (size_t)t * numAtoms + a] = distance;
+        }
+    }
+    workspace.matching.resize(rows);
+    long long cost = workspace.solver.solve(workspace.cost.data(), rows, cols, workspace.matching.data());
+    for (int r = 0; r < rows; r++) {
+        int i = atoms[byAtom ? r : workspace.matching[r]];
+        int site = sites[byAtom ? workspace.matching[r] : r];
+        workspace.targetRow[i] = site / occupancyCols;
+        workspace.targetCol[i] = site % occupancyCols;
+    }
+    return cost;
+}
+
+// assignTargets: gives every tweezer a target site, keeping the tweezers already on one and matching the rest optimally. The first
+// numTargets entries of workspace.sites are the target sites, and the numReservoir after them the reservoir sites, which the tweezers
+// left over are matched to in turn. A tweezer left without a site stays where it is.
+static void assignTargets(int numTweezers, int numTargets, int numReservoir, int occupancyCols, const LatticeNeighbourhood& neighbourhood,
+                          TrajectoryStore& trajectories, AssignmentWorkspace& workspace) {
+    workspace.targetRow.resize(numTweezers);
+    workspace.targetCol.resize(numTweezers);
+    workspace.freeAtoms.clear();
+    workspace.freeTargets.clear();
+    for (int i = 0; i < numTweezers; i++) {
+        int row = trajectories.latticeRow(0, i), col = trajectories.latticeCol(0, i);
+        if (workspace.targets.occupied(row, col)) {
+            workspace.targetRow[i] = row;
+            workspace.targetCol[i] = col;
+        }
+        else {
+            workspace.targetRow[i] = -1;
+            workspace.freeAtoms.push_back(i);
+        }
+    }
+    for (int t = 0; t < numTargets; t++) {
+        if (workspace.atomAt[workspace.sites[t]] < 0) workspace.freeTargets.push_back(workspace.sites[t]);
+    }
+    workspace.assignmentCost =
+        matchSites(workspace.freeAtoms, workspace.freeTargets, occupancyCols, neighbourhood, trajectories, workspace);
+
+    // The tweezers left over keep a reservoir site they are already on, and are matched to the empty ones.
+    workspace.parkedAtoms = 0;
+    workspace.surplusAtoms.clear();
+    workspace.freeReservoir.clear();
+    for (int i : workspace.freeAtoms) {
+        if (workspace.targetRow[i] >= 0) continue;
+        int row = trajectories.latticeRow(0, i), col = trajectories.latticeCol(0, i);
+        if (numReservoir > 0 && workspace.reservoir.occupied(row, col)) {
+            workspace.targetRow[i] = row;
+            workspace.targetCol[i] = col;
+            workspace.parkedAtoms++;
+        }
+        else {
+            workspace.surplusAtoms.push_back(i);
+        }
+    }
+    for (int t = numTargets; t < numTargets + numReservoir; t++) {
+        if (workspace.atomAt[workspace.sites[t]] < 0) workspace.freeReservoir.push_back(workspace.sites[t]);
+    }
+    workspace.parkedAtoms += (int)std::min(workspace.surplusAtoms.size(), workspace.freeReservoir.size());
+    workspace.assignmentCost +=
+        matchSites(workspace.surplusAtoms, workspace.freeReservoir, occupancyCols, neighbourhood, trajectories, workspace);
+    for (int i : workspace.surplusAtoms) {
+        if (workspace.targetRow[i] >= 0) continue;
+        workspace.targetRow[i] = trajectories.latticeRow(0, i);
+        workspace.targetCol[i] = trajectories.latticeCol(0, i);
+    }
+}
+
+// stepTweezer: moves tweezer i one site along a shortest path to its target in the next frame, and returns whether it moved. When every
+// such step is blocked, it exchanges targets with a blocker if that shortens their two paths; at equal length it does so only with a
+// blocker that has already arrived and not yet moved this frame, which is then stepped on in turn so that the whole chain shifts at once.
+static bool stepTweezer(int i, int currentFrame, int occupancyCols, const LatticeNeighbourhood& neighbourhood, int** tweezerPositions,
+                        TrajectoryStore& trajectories, AssignmentWorkspace& workspace, int& numExchanges) {
+    std::vector<int>& atomAt = workspace.atomAt;
+    std::vector<int>& targetRow = workspace.targetRow;
+    std::vector<int>& targetCol = workspace.targetCol;
+    int row = trajectories.latticeRow(currentFrame, i);
+    int col = trajectories.latticeCol(currentFrame, i);
+    // Up to two neighbouring sites lie on a shortest path; try the one leaving the more even remainder first.
+    int candidates[2][2];
+    int numCandidates = neighbourhood.shortestSteps(targetRow[i] - row, targetCol[i] - col, candidates);
+    for (int c = 0; c < numCandidates; c++) {
+        candidates[c][0] += row;
+        candidates[c][1] += col;
+    }
+
+    for (int c = 0; c < numCandidates; c++) {
+        int nextRow = candidates[c][0], nextCol = candidates[c][1];
+        if (atomAt[nextRow * occupancyCols + nextCol] >= 0) continue;
+        atomAt[nextRow * occupancyCols + nextCol] = i;
+        atomAt[row * occupancyCols + col] = -1;
+        tweezerPositions[nextRow][nextCol] = 1;
+        tweezerPositions[row][col] = 0;
+        trajectories.latticeRow(currentFrame + 1, i) = nextRow;
+        trajectories.latticeCol(currentFrame + 1, i) = nextCol;
+        return true;
+    }
+
+    for (int c = 0; c < numCandidates; c++) {
+        int rowJ = candidates[c][0], colJ = candidates[c][1];
+        int j = atomAt[rowJ * occupancyCols + colJ];
+        bool waiting = rowJ == targetRow[j] && colJ == targetCol[j] && rowJ == trajectories.latticeRow(currentFrame, j) &&
+                       colJ == trajectories.latticeCol(currentFrame, j);
+        int current = latticeDistance(neighbourhood, row, col, targetRow[i], targetCol[i]) +
+                      latticeDistance(neighbourhood, rowJ, colJ, targetRow[j], targetCol[j]);
+        int exchanged = latticeDistance(neighbourhood, row, col, targetRow[j], targetCol[j]) +
+                        latticeDistance(neighbourhood, rowJ, colJ, targetRow[i], targetCol[i]);
+        // Exchanging at equal length with a blocker that is still on its way would only be undone by the blocker in the next frame.
+        if (exchanged > current || (exchanged == current && !waiting)) continue;
+        std::swap(targetRow[i], targetRow[j]);
+        std::swap(targetCol[i], targetCol[j]);
+        numExchanges++;
+        // Tweezer i now heads for the blocker's site, which it can take at once if the blocker moves on.
+        if (waiting && stepTweezer(j, currentFrame, occupancyCols, neighbourhood, tweezerPositions, trajectories, workspace, numExchanges)) {
+            return stepTweezer(i, currentFrame, occupancyCols, neighbourhood, tweezerPositions, trajectories, workspace, numExchanges);
+        }
+        return false;
+    }
+    return false;
+}
+
+int routeAssignment(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories,
+                    int maxTime, AssignmentWorkspace& workspace, LatticeTopology topology, const uint8_t* targetPattern) {
+    // Populate the first lattice frame with initial positions of tweezers, and find their center of mass, in one pass.
+    long long rowSum = 0, colSum = 0;
+    workspace.occupancy.load(tweezerPositions, occupancyRows, occupancyCols, trajectories, rowSum, colSum);
+    workspace.assignmentCost = 0;
+    workspace.numTargets = 0;
+    workspace.targetsFilled = 0;
+    workspace.parkedAtoms = 0;
+    if (numTweezers == 0) return 1;
+
+    const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+    int numReservoir = 0;
+    if (targetPattern != nullptr) {
+        workspace.numTargets = choosePatternTargets(targetPattern, occupancyRows, occupancyCols, workspace, numReservoir);
+    }
+    else {
+        chooseTargets(numTweezers, occupancyRows, occupancyCols, (double)rowSum / numTweezers, (double)colSum / numTweezers, workspace);
+        workspace.numTargets = numTweezers;
+    }
+    if (numReservoir == 0 && workspace.occupancy.covers(workspace.targets)) {
+        workspace.targetsFilled = workspace.numTargets;
+        return 1;
+    }
+    std::vector<int>& atomAt = workspace.atomAt;
+    atomAt.assign((size_t)occupancyRows * occupancyCols, -1);
+    for (int i = 0; i < numTweezers; i++) atomAt[trajectories.latticeRow(0, i) * occupancyCols + trajectories.latticeCol(0, i)] = i;
+    assignTargets(numTweezers, workspace.numTargets, numReservoir, occupancyCols, neighbourhood, trajectories, workspace);
+    std::vector<int>& targetRow = workspace.targetRow;
+    std::vector<int>& targetCol = workspace.targetCol;
+
+    int maxDistance = occupancyRows + occupancyCols;
+    workspace.order.resize(numTweezers);
+    workspace.bucketStart.resize(maxDistance + 2);
+
+    int currentFrame = 0;
+    int stalledPasses = 0;
+    // The store holds maxTime lattice frames, so routing stops once the last one has been filled.
+    while (currentFrame + 1 < maxTime) {
+        // Sort the tweezers by remaining distance (a counting sort), and start the next frame where this one ends.
+        std::fill(workspace.bucketStart.begin(), workspace.bucketStart.end(), 0);
+        int remaining = 0;
+        for (int i = 0; i < numTweezers; i++) {
+            int row = trajectories.latticeRow(currentFrame, i), col = trajectories.latticeCol(currentFrame, i);
+            trajectories.latticeRow(currentFrame + 1, i) = row;
+            trajectories.latticeCol(currentFrame + 1, i) = col;
+            int distance = latticeDistance(neighbourhood, row, col, targetRow[i], targetCol[i]);
+            workspace.bucketStart[distance + 1]++;
+            remaining += distance > 0;
+        }
+        if (remaining == 0) break;
+        for (int d = 1; d <= maxDistance + 1; d++) workspace.bucketStart[d] += workspace.bucketStart[d - 1];
+        for (int i = 0; i < numTweezers; i++) {
+            int distance = latticeDistance(neighbourhood, trajectories.latticeRow(currentFrame, i), trajectories.latticeCol(currentFrame, i),
+                                           targetRow[i], targetCol[i]);
+            workspace.order[workspace.bucketStart[distance]++] = i;
+        }
+
+        int numMoves = 0;
+        int numExchanges = 0;
+        for (int k = 0; k < numTweezers; k++) {
+            if (stepTweezer(workspace.order[k], currentFrame, occupancyCols, neighbourhood, tweezerPositions, trajectories, workspace,
+                            numExchanges)) {
+                numMoves++;
+            }
+        }
+
+        if (numMoves == 0) {
+            // Nothing moved, so the frame is routed again with the exchanged targets rather than stored.
+            if (numExchanges == 0 || ++stalledPasses > MAX_STALLED_PASSES) break;
+            continue;
+        }
+        stalledPasses = 0;
+        currentFrame++;
+    }
+    for (int i = 0; i < numTweezers; i++) {
+        int row = trajectories.latticeRow(currentFrame, i), col = trajectories.latticeCol(currentFrame, i);
+        workspace.targetsFilled += workspace.targets.occupied(row, col);
+    }
+    return currentFrame + 1;
+}
@@ -0,0 +1,77 @@
+#ifndef ASSIGNMENT_ROUTER_H
+#define ASSIGNMENT_ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assignment.h"
+#include "lattice_topology.h"
+#include "occupancy_grid.h"
+#include "trajectory_store.h"
+
+// TargetSite: the role of a site in a target pattern (see routeAssignment), as stored in the pattern matrix.
+enum class TargetSite : uint8_t {
+    Free = 0,        // may be left empty; atoms pass over it and surplus atoms may stay on it
+    Target = 1,      // to be filled with an atom
+    Reservoir = 2    // where the atoms left over once the targets are filled are parked (a reservoir, or an ejection zone)
+};
+
+// AssignmentWorkspace: the buffers used by routeAssignment, kept between shots (see FrameContext) so that routing does not allocate
+// once they have been sized.
+struct AssignmentWorkspace {
+    AssignmentSolver solver;
+    std::vector<int> sites;                   // every site of the lattice, the target sites first once they have been chosen
+    std::vector<int> atomAt;                  // the tweezer on each site, or -1
+    OccupancyGrid occupancy;                  // the sites holding an atom at the start
+    OccupancyGrid targets;                    // the target sites
+    OccupancyGrid reservoir;                  // the reservoir sites of a target pattern
+    std::vector<int> targetRow, targetCol;    // the site assigned to each tweezer
+    std::vector<int> freeAtoms, freeTargets;  // tweezers not on a target and targets without a tweezer, matched by the solver
+    std::vector<int> cost, matching;
+    std::vector<int> order, bucketStart;      // the tweezers sorted by remaining distance, for each frame
+    std::vector<int> surplusAtoms, freeReservoir;  // tweezers left over once the targets are matched, and empty reservoir sites
+    long long assignmentCost = 0;             // the total distance of the optimal assignment of the last shot, in lattice steps
+    int numTargets = 0;                       // the number of target sites of the last shot
+    int targetsFilled = 0;                    // how many of them hold an atom in the last lattice frame
+    int parkedAtoms = 0;                      // the surplus atoms assigned a reservoir site
+
+    size_t capacityBytes() const {
+        return (sites.capacity() + atomAt.capacity() + targetRow.capacity() + targetCol.capacity() + freeAtoms.capacity() +
+                freeTargets.capacity() + cost.capacity() + matching.capacity() + order.capacity() + bucketStart.capacity() +
+                surplusAtoms.capacity() + freeReservoir.capacity()) * sizeof(int) +
+               occupancy.capacityBytes() + targets.capacityBytes() + reservoir.capacityBytes();
+    }
+};
+
+// routeAssignment: routes every tweezer onto the compact set of numTweezers sites closest to the center of mass, or onto the target
+// sites of a target pattern, choosing which tweezer fills which site by a minimum-cost assignment over lattice distances, and returns
+// the number of lattice frames (stored in the lattice stage of "trajectories", as routeCenterOfMass does). The topology changes the
+// paths and their lengths, not the sites filled.
+// Tweezers that already sit on a target site keep it: with lattice distances this never makes the total distance worse, and leaves
+// only the holes of the target region to the Hungarian algorithm; when the target sites are all filled already (checked a word of
+// sites at a time, see OccupancyGrid::covers), the shot takes a single frame. The tweezers then step along shortest paths to their
+// sites, one site per frame and all in the same frames. In each frame they are taken in order of remaining distance, so that a queue of tweezers
+// moves up together, and a tweezer only enters a site that is empty at that point, so no two tweezers ever share or swap sites. A
+// tweezer blocked by another exchanges targets with it whenever that does not lengthen their combined paths (e.g. when the blocker has
+// already arrived, it moves on to the blocked tweezer's target). Routing stops once every tweezer has arrived, no tweezer can move,
+// or maxTime lattice frames have been filled.
+// With a target pattern, the holes are filled from the nearest of the other atoms (with fewer atoms than targets, every atom fills a
+// target and the rest stay empty). The atoms left over are then matched to the empty reservoir sites in a second assignment, those
+// already on a reservoir site keeping it; surplus atoms beyond the reservoir stay where they are, and are pushed on by the exchanges
+// above when they stand in the way. The costs of both assignments, the targets filled and the atoms parked are left in workspace.
+// Inputs:
+//      numTweezers: the total number of tweezers (i.e. the number of "1" values in tweezerPositions)
+//      occupancyRows, occupancyCols: the dimensions of the occupancy matrix
+//      tweezerPositions: the occupancy matrix, addressed as tweezerPositions[row][col]; updated in place as the tweezers move
+//      trajectories: the store receiving the lattice moves, reserved for at least numTweezers tweezers and maxTime frames
+//      maxTime: the maximum number of lattice frames
+//      workspace: buffers reused between calls
+//      topology: the moves a tweezer can make between lattice frames
+//      targetPattern: a row-major occupancyRows * occupancyCols matrix of TargetSite values, or null to fill the sites closest to the
+//                     center of mass
+int routeAssignment(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories,
+                    int maxTime, AssignmentWorkspace& workspace, LatticeTopology topology = LatticeTopology::Square,
+                    const uint8_t* targetPattern = nullptr);
+
+#endif
@@ -0,0 +1,41 @@
+#include "bitplane_rasterizer.h"
+
+#include <algorithm>
+#include <cstring>
+
+void rasterizeRows(const TrajectoryStore& trajectories, int firstMove, int numSubframes, const TweezerStamp& stamp, bool inverted,
+                   uint32_t* frame, int width, int rowBegin, int rowEnd) {
+    uint32_t* rows = frame + (size_t)rowBegin * width;
+    size_t numPixels = (size_t)(rowEnd - rowBegin) * width;
+    memset(rows, 0, numPixels * sizeof(uint32_t));
+
+    for (int j = 0; j < numSubframes; j++) {
+        uint32_t mask = subframeMask(j);
+        const float* xs = trajectories.moveX(firstMove + j);
+        const float* ys = trajectories.moveY(firstMove + j);
+        for (int i = 0; i < trajectories.numTweezers; i++) {
+            stamp.draw(frame, width, rowBegin, rowEnd, (int)xs[i], (int)ys[i], mask);
+        }
+    }
+
+    if (inverted) {
+        for (size_t p = 0; p < numPixels; p++) {
+            rows[p] ^= ALL_SUBFRAMES_MASK;
+        }
+    }
+}
+
+void rasterizeFrame(const TrajectoryStore& trajectories, int firstMove, int numSubframes, const TweezerStamp& stamp, bool inverted,
+                    uint32_t* frame, int width, int height, ThreadPool* pool) {
+    if (!pool || pool->size() == 1) {
+        rasterizeRows(trajectories, firstMove, numSubframes, stamp, inverted, frame, width, 0, height);
+        return;
+    }
+
+    int numTiles = std::min(pool->size() * TILES_PER_THREAD, height);
+    pool->parallelFor(numTiles, [&](int tile) {
+        int rowBegin = (int)((long long)height * tile / numTiles);
+        int rowEnd = (int)((long long)height * (tile + 1) / numTiles);
+        rasterizeRows(trajectories, firstMove, numSubframes, stamp, inverted, frame, width, rowBegin, rowEnd);
+    });
+}
@@ -0,0 +1,46 @@
+#ifndef BITPLANE_RASTERIZER_H
+#define BITPLANE_RASTERIZER_H
+
+#include <cstdint>
+
+#include "thread_pool.h"
+#include "trajectory_store.h"
+#include "tweezer_stamp.h"
+
+// Number of binary subframes packed into one RGB frame shown on the DMD.
+const int SUBFRAMES_PER_FRAME = 24;
+
+// Frames are rasterized into a packed 24-bit-plane target: one uint32_t per pixel, with binary subframe j stored in bit 23 - j.
+// Read as little-endian bytes this is BGRA, so the red channel holds subframes 0-7 (most significant bit first), green holds 8-15 and
+// blue holds 16-23, which is the order in which the DMD displays the bit planes of its RGB input.
+const uint32_t ALL_SUBFRAMES_MASK = 0x00FFFFFF;
+
+// subframeMask: the bit of a packed pixel that belongs to the given subframe.
+inline uint32_t subframeMask(int subframe) {
+    return 1u << (SUBFRAMES_PER_FRAME - 1 - subframe);
+}
+
+// rasterizeFrame: draws up to 24 consecutive smoothed moves as the bit planes of one packed RGB frame.
+// Each subframe's bit is ORed into the pixels covered by its tweezers, so overlapping tweezers simply set the same bit. In inverted
+// mode the whole frame is flipped with a single XOR once every subframe has been drawn. Given a thread pool, the frame is split into
+// horizontal tiles that are cleared, drawn and inverted independently; tiles share no pixels, so no atomics or merge step are needed.
+// Inputs:
+//      trajectories: the trajectory store holding the smoothed moves
+//      firstMove: the index of the smoothed move drawn in subframe 0
+//      numSubframes: the number of subframes to draw (at most SUBFRAMES_PER_FRAME); the remaining bit planes are left empty
+//      stamp: the shape drawn for each tweezer
+//      inverted: whether to invert the frame (see INVERTED_COLOR_MODE)
+//      frame: the packed target, width * height pixels
+//      width, height: the size of the frame, in pixels
+//      pool: the threads to split the frame across, or null to rasterize on the calling thread
+void rasterizeFrame(const TrajectoryStore& trajectories, int firstMove, int numSubframes, const TweezerStamp& stamp, bool inverted,
+                    uint32_t* frame, int width, int height, ThreadPool* pool = nullptr);
+
+// rasterizeRows: rasterizes only rows [rowBegin, rowEnd) of a frame (see rasterizeFrame).
+void rasterizeRows(const TrajectoryStore& trajectories, int firstMove, int numSubframes, const TweezerStamp& stamp, bool inverted,
+                   uint32_t* frame, int width, int rowBegin, int rowEnd);
+
+// Number of tiles per pool thread when rasterizing in parallel; more tiles than threads evens out tiles with more tweezers.
+const int TILES_PER_THREAD = 4;
+
+#endif
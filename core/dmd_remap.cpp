@@ -0,0 +1,80 @@
+#include "dmd_remap.h"
+
+#include <algorithm>
+#include <cstddef>
+
+int rowAlgorithm(int DMDRow, int DMDCol) {
+    return -DMDCol + (int)(DMDRow / 2);
+}
+
+int columnAlgorithm(int DMDRow, int DMDCol) {
+    return ((int)((DMDRow + 1) / 2)) + DMDCol;
+}
+
+void DmdRemap::build(int width, int height, int rowOffset) {
+    this->width = width;
+    this->height = height;
+    this->rowOffset = rowOffset;
+    copySpans.clear();
+    fillSpans.clear();
+    rowFirstSpan.assign(height + 1, 0);
+
+    for (int i = 0; i < height; i++) {
+        rowFirstSpan[i] = (int)copySpans.size();
+        int j = 0;
+        while (j < width) {
+            int x = rowOffset + rowAlgorithm(i, j);
+            int y = columnAlgorithm(i, j);
+            bool mapped = x >= 0 && x < height && y >= 0 && y < width;
+
+            if (!mapped) {
+                FillSpan span = { i * width + j, 0 };
+                while (j < width) {
+                    x = rowOffset + rowAlgorithm(i, j);
+                    y = columnAlgorithm(i, j);
+                    if (x >= 0 && x < height && y >= 0 && y < width) break;
+                    span.count++;
+                    j++;
+                }
+                fillSpans.push_back(span);
+                continue;
+            }
+
+            // Extend the span while the source keeps advancing by the same stride.
+            CopySpan span = { i * width + j, x * width + y, 0, 1 };
+            j++;
+            while (j < width) {
+                x = rowOffset + rowAlgorithm(i, j);
+                y = columnAlgorithm(i, j);
+                if (x < 0 || x >= height || y < 0 || y >= width) break;
+                int src = x * width + y;
+                int stride = src - (span.src + (span.count - 1) * span.srcStride);
+                if (span.count == 1) span.srcStride = stride;
+                else if (stride != span.srcStride) break;
+                span.count++;
+                j++;
+            }
+            copySpans.push_back(span);
+        }
+    }
+    rowFirstSpan[height] = (int)copySpans.size();
+}
+
+void DmdRemap::apply(const uint32_t* src, uint32_t* dst, int rowBegin, int rowEnd) const {
+    for (int s = rowFirstSpan[rowBegin]; s < rowFirstSpan[rowEnd]; s++) {
+        const CopySpan& span = copySpans[s];
+        uint32_t* out = dst + span.dst;
+        const uint32_t* in = src + span.src;
+        ptrdiff_t stride = span.srcStride;
+        for (int k = 0; k < span.count; k++) {
+            out[k] = *in;
+            in += stride;
+        }
+    }
+}
+
+void DmdRemap::fillOutside(uint32_t* dst, uint32_t color) const {
+    for (const FillSpan& span : fillSpans) {
+        std::fill(dst + span.dst, dst + span.dst + span.count, color);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef DMD_REMAP_H
+#define DMD_REMAP_H
+
+#include <cstdint>
+#include <vector>
+
+// rowAlgorithm, columnAlgorithm: map a pixel of the DMD (row, column) to the row and column of the image it should display.
+// The row is measured relative to a fixed offset that places the rotated image on the screen (see DmdRemap::build).
+int rowAlgorithm(int DMDRow, int DMDCol);
+int columnAlgorithm(int DMDRow, int DMDCol);
+
+// DmdRemap: a precomputed version of the transform from the image coordinate system into the DMD coordinate system.
+// The transform never changes, so build() evaluates rowAlgorithm() and columnAlgorithm() once for every DMD pixel and compresses the
+// result into spans: runs of consecutive destination pixels whose source pixels are a constant stride apart. Destination pixels with
+// no source pixel are listed separately; they only ever hold the background color, so they are filled once rather than every frame.
+class DmdRemap {
+public:
+    // build: computes the spans for a screen of the given size.
+    // Inputs:
+    //      width, height: the size of both the source image and the DMD screen, in pixels
+    //      rowOffset: the offset added to rowAlgorithm() to obtain the source row
+    void build(int width, int height, int rowOffset);
+
+    // apply: copies every mapped pixel of the packed image src into the packed image dst (see bitplane_rasterizer.h).
+    void apply(const uint32_t* src, uint32_t* dst) const { apply(src, dst, 0, height); }
+
+    // apply: remaps only DMD rows [rowBegin, rowEnd), so that separate threads can remap separate bands of the screen.
+    void apply(const uint32_t* src, uint32_t* dst, int rowBegin, int rowEnd) const;
+
+    // fillOutside: sets every DMD pixel that has no source pixel to the given packed color.
+    void fillOutside(uint32_t* dst, uint32_t color) const;
+
+    int width = 0;
+    int height = 0;
+    int rowOffset = 0;
+
+private:
+    struct CopySpan {
+        int dst;        // first destination pixel
+        int src;        // first source pixel
+        int srcStride;  // distance between the source pixels of consecutive destination pixels
+        int count;
+    };
+    struct FillSpan {
+        int dst;
+        int count;
+    };
+
+    std::vector<CopySpan> copySpans;
+    std::vector<int> rowFirstSpan;      // index of the first copy span of each DMD row, plus one entry past the last row
+    std::vector<FillSpan> fillSpans;
+};
+
+#endif
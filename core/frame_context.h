@@ -0,0 +1,86 @@
+#ifndef FRAME_CONTEXT_H
+#define FRAME_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assignment_router.h"
+#include "replan_router.h"
+#include "reservation_router.h"
+#include "router.h"
+#include "trajectory_store.h"
+
+// FrameContext: all of the per-shot buffers used to turn an occupancy matrix into displayed frames.
+// A single context is kept alive across calls; prepare() grows the buffers only when the lattice size, the number of tweezers or the
+// smoothing factor exceed anything seen before, so in steady state a shot runs without touching the heap.
+class FrameContext {
+public:
+    // prepare: sizes the routing and trajectory buffers for the upcoming shot.
+    // Inputs:
+    //      occupancyRows, occupancyCols: the dimensions of the occupancy matrix
+    //      numTweezers: the total number of tweezers for which moves are to be computed
+    //      N: the smoothing factor
+    //      maxTime: the maximum number of lattice moves to store
+    void prepare(int occupancyRows, int occupancyCols, int numTweezers, int N, int maxTime) {
+        if (occupancy.size() < (size_t)occupancyRows * occupancyCols) occupancy.resize((size_t)occupancyRows * occupancyCols);
+        if (occupancyRowPointers.size() < (size_t)occupancyRows) occupancyRowPointers.resize(occupancyRows);
+        for (int i = 0; i < occupancyRows; i++) {
+            occupancyRowPointers[i] = occupancy.data() + (size_t)i * occupancyCols;
+        }
+
+        trajectories.reserve(numTweezers, N, maxTime);
+        updateHighWater();
+    }
+
+    // prepareTextures: sizes the frame buffers used when frames are rendered on the calling thread.
+    // Inputs:
+    //      screenWidth, screenHeight: the size of the textures, in pixels
+    //      cpuRemap: whether the DMD remap runs on the CPU (and so needs dmdTextureArray) or in the fragment shader
+    void prepareTextures(int screenWidth, int screenHeight, bool cpuRemap) {
+        size_t textureSize = (size_t)screenWidth * screenHeight;
+        if (textureArray.size() < textureSize) textureArray.resize(textureSize);
+        if (cpuRemap && dmdTextureArray.size() < textureSize) {
+            dmdTextureArray.resize(textureSize);
+            dmdBorderFilled = false;
+        }
+        updateHighWater();
+    }
+
+    // tweezerPositions: the occupancy matrix of the current shot, addressed as tweezerPositions()[row][col].
+    int** tweezerPositions() { return occupancyRowPointers.data(); }
+
+    // capacityBytes: the amount of memory currently held by the context.
+    size_t capacityBytes() const {
+        return occupancy.capacity() * sizeof(int) + occupancyRowPointers.capacity() * sizeof(int*) + trajectories.capacityBytes() +
+               routing.capacityBytes() + reservation.capacityBytes() + centerOfMass.capacityBytes() + replan.capacityBytes() +
+               (textureArray.capacity() + dmdTextureArray.capacity()) * sizeof(uint32_t);
+    }
+
+    TrajectoryStore trajectories;
+    // routing, reservation, centerOfMass: the buffers of the assignment, reservation and center-of-mass routers (see generateFrames).
+    AssignmentWorkspace routing;
+    ReservationWorkspace reservation;
+    CenterOfMassWorkspace centerOfMass;
+    // replan: the buffers of replanFrames, with the plan being repaired.
+    ReplanWorkspace replan;
+    // textureArray: the packed RGB image (see bitplane_rasterizer.h) in camera coordinates; dmdTextureArray: the same image remapped
+    // into the DMD coordinate system.
+    std::vector<uint32_t> textureArray;
+    std::vector<uint32_t> dmdTextureArray;
+    // dmdBorderFilled: whether the DMD pixels that lie outside the remapped image have been set to the background color.
+    bool dmdBorderFilled = false;
+    // highWaterBytes: the largest amount of memory the context has held.
+    size_t highWaterBytes = 0;
+
+private:
+    void updateHighWater() {
+        size_t bytes = capacityBytes();
+        if (bytes > highWaterBytes) highWaterBytes = bytes;
+    }
+
+    std::vector<int> occupancy;
+    std::vector<int*> occupancyRowPointers;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "frame_pacing.h"
+
+#include <algorithm>
+#include <cmath>
+
+void FramePacing::beginShot(double expectedPeriodMicroseconds) {
+    report = PacingReport();
+    report.expectedPeriodMicroseconds = expectedPeriodMicroseconds;
+    restart();
+}
+
+void FramePacing::restart() {
+    havePresent = false;
+    lastGpuFrame = -1;
+}
+
+PacingFault FramePacing::classify(double interval) const {
+    double period = report.expectedPeriodMicroseconds;
+    if (period <= 0.0) return PacingFault::None;
+    if (interval > LATE_THRESHOLD * period) return PacingFault::Late;
+    if (interval < EARLY_THRESHOLD * period) return PacingFault::Dropped;
+    return PacingFault::None;
+}
+
+PacingFault FramePacing::presented(int frame, double microseconds) {
+    report.presents++;
+    bool first = !havePresent;
+    double interval = microseconds - lastPresent;
+    havePresent = true;
+    lastPresent = microseconds;
+    if (first) return PacingFault::None;
+
+    report.totalIntervalMicroseconds += interval;
+    report.minIntervalMicroseconds = report.intervals == 0 ? interval : std::min(report.minIntervalMicroseconds, interval);
+    report.maxIntervalMicroseconds = std::max(report.maxIntervalMicroseconds, interval);
+    report.intervals++;
+
+    PacingFault fault = classify(interval);
+    if (fault == PacingFault::Late) {
+        report.lateFrames++;
+        report.repeatedRefreshes += std::max(1, (int)std::lround(interval / report.expectedPeriodMicroseconds) - 1);
+    }
+    else if (fault == PacingFault::Dropped) {
+        report.droppedFrames++;
+    }
+    if (fault != PacingFault::None && report.firstFaultFrame < 0) report.firstFaultFrame = frame;
+    return fault;
+}
+
+void FramePacing::gpuFinished(int frame, double microseconds) {
+    if (lastGpuFrame >= 0 && frame == lastGpuFrame + 1 && classify(microseconds - lastGpuTime) == PacingFault::Late) {
+        report.gpuLateFrames++;
+    }
+    lastGpuFrame = frame;
+    lastGpuTime = microseconds;
+}
+
+void FramePacing::backlog(int frame) {
+    report.gpuBacklogFrames++;
+    if (report.firstBacklogFrame < 0) report.firstBacklogFrame = frame;
+}
@@ -0,0 +1,81 @@
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+// PacingAction: what the renderer does when a frame is found to have been shown late or dropped.
+enum class PacingAction {
+    Report = 0,    // keep going, and count the fault in the shot's PacingReport
+    Abort = 1,     // stop the shot and clear the display
+    Reissue = 2    // present a late frame again and go on from there, without clearing the display (up to a limit, then abort); a
+                   // dropped frame aborts the shot, as it can no longer be shown
+};
+
+// PacingFault: how a present compares with the refresh of the display.
+enum class PacingFault {
+    None = 0,
+    Late = 1,      // the present came one or more refreshes late, so the previous frame was shown again
+    Dropped = 2    // the present came too soon after the previous one for that frame to have been shown
+};
+
+// PacingReport: the presentation timing of one shot. Intervals are between consecutive presents of the same playback, in
+// microseconds; with no expected period (an unknown refresh rate) they are measured but no frame is classified.
+struct PacingReport {
+    int presents = 0;
+    double expectedPeriodMicroseconds = 0.0;
+    double totalIntervalMicroseconds = 0.0;
+    double minIntervalMicroseconds = 0.0;
+    double maxIntervalMicroseconds = 0.0;
+    int intervals = 0;
+    int lateFrames = 0;
+    int repeatedRefreshes = 0;    // extra refreshes for which a frame stayed on the display, summed over the late frames
+    int droppedFrames = 0;
+    int gpuLateFrames = 0;        // frames that also finished late on the GPU (timer queries), so the GPU rather than the CPU was behind
+    int gpuBacklogFrames = 0;     // frames submitted before the GPU had finished the previous one (sync fences)
+    int firstFaultFrame = -1;     // the RGB frame at which the first fault was seen, or -1
+    int firstBacklogFrame = -1;   // the first RGB frame submitted while the GPU was behind, or -1
+    int reissues = 0;
+    bool aborted = false;
+
+    // exact: whether every frame was shown for exactly one refresh, as planned.
+    bool exact() const { return lateFrames == 0 && droppedFrames == 0 && !aborted; }
+    double meanIntervalMicroseconds() const { return intervals > 0 ? totalIntervalMicroseconds / intervals : 0.0; }
+};
+
+// FramePacing: classifies the intervals between presents against the expected refresh period. A present more than
+// LATE_THRESHOLD periods after the previous one means the previous frame was held for round(interval / period) - 1 extra refreshes;
+// one less than EARLY_THRESHOLD periods after it means the previous frame was replaced before it could be scanned out. The same
+// thresholds are applied to GPU timestamps, which tell whether a late frame was also late on the GPU.
+class FramePacing {
+public:
+    static constexpr double LATE_THRESHOLD = 1.5;
+    static constexpr double EARLY_THRESHOLD = 0.5;
+
+    // beginShot: clears the report.
+    // Inputs:
+    //      expectedPeriodMicroseconds: the refresh period of the display, or 0 if it is unknown
+    void beginShot(double expectedPeriodMicroseconds);
+
+    // restart: forgets the last present, so that the next one has no interval.
+    void restart();
+
+    // presented: the present of RGB frame number frame returned at the given time. Returns the fault it reveals.
+    PacingFault presented(int frame, double microseconds);
+
+    // gpuFinished: the GPU finished drawing RGB frame number frame at the given time (results may arrive some frames late, but in
+    // order).
+    void gpuFinished(int frame, double microseconds);
+
+    // backlog: RGB frame number frame was submitted while the GPU was still working on the previous one.
+    void backlog(int frame);
+
+    PacingReport report;
+
+private:
+    PacingFault classify(double interval) const;
+
+    bool havePresent = false;
+    double lastPresent = 0.0;
+    int lastGpuFrame = -1;
+    double lastGpuTime = 0.0;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "frame_pipeline.h"
+#include "bitplane_rasterizer.h"
+
+#include <algorithm>
+#include <chrono>
+
+int FrameJob::numRgbFrames() const {
+    return numMoves / SUBFRAMES_PER_FRAME + 1;
+}
+
+const uint32_t* renderFrame(const FrameJob& job, int rgbFrame, uint32_t* packed, uint32_t* remapped) {
+    int firstMove = rgbFrame * SUBFRAMES_PER_FRAME;
+    int numSubframes = std::max(0, std::min(SUBFRAMES_PER_FRAME, job.numMoves - firstMove));
+    rasterizeFrame(*job.trajectories, firstMove, numSubframes, *job.stamp, job.inverted, packed, job.width, job.height, job.pool);
+    if (job.trace) job.trace->record(TraceEvent::RasterDone, rgbFrame);
+    if (!job.remap) return packed;
+    if (!job.pool || job.pool->size() == 1) {
+        job.remap->apply(packed, remapped);
+    }
+    else {
+        int numBands = job.pool->size() * TILES_PER_THREAD;
+        job.pool->parallelFor(numBands, [&](int band) {
+            job.remap->apply(packed, remapped, job.height * band / numBands, job.height * (band + 1) / numBands);
+        });
+    }
+    if (job.trace) job.trace->record(TraceEvent::RemapDone, rgbFrame);
+    return remapped;
+}
+
+void FramePipeline::start(int numWorkers, int ringSize, int width, int height) {
+    stop();
+    this->ringSize = std::max(ringSize, 1);
+    slots.clear();
+    for (int i = 0; i < this->ringSize; i++) {
+        slots.emplace_back(new Slot());
+        slots.back()->packed.resize((size_t)width * height);
+        slots.back()->remapped.resize((size_t)width * height);
+    }
+    stopping = false;
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(&FramePipeline::workerLoop, this);
+    }
+}
+
+void FramePipeline::stop() {
+    if (workers.empty()) return;
+    endShot();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+}
+
+void FramePipeline::beginShot(const FrameJob& job) {
+    this->job = job;
+    numRgbFrames = job.numRgbFrames();
+    for (int i = 0; i < ringSize; i++) {
+        slots[i]->sequence.store(2 * (long long)i, std::memory_order_relaxed);
+    }
+    nextFrame.store(0, std::memory_order_relaxed);
+    framesProduced.store(0, std::memory_order_relaxed);
+    cancelled.store(false, std::memory_order_relaxed);
+    stats = PipelineStats();
+    stats.minQueueDepth = ringSize;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shotGeneration++;
+        activeWorkers = (int)workers.size();
+    }
+    wake.notify_all();
+}
+
+const uint32_t* FramePipeline::acquire(int rgbFrame) {
+    Slot& slot = *slots[rgbFrame % ringSize];
+    long long ready = 2 * (long long)rgbFrame + 1;
+
+    int depth = framesProduced.load(std::memory_order_relaxed) - rgbFrame;
+    depth = std::max(0, std::min(depth, ringSize));
+    stats.totalQueueDepth += depth;
+    stats.minQueueDepth = std::min(stats.minQueueDepth, depth);
+    stats.maxQueueDepth = std::max(stats.maxQueueDepth, depth);
+
+    if (slot.sequence.load(std::memory_order_acquire) != ready) {
+        auto start = std::chrono::steady_clock::now();
+        while (slot.sequence.load(std::memory_order_acquire) != ready) std::this_thread::yield();
+        double waited = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (rgbFrame == 0) {
+            stats.firstFrameWaitMicroseconds = waited;
+        }
+        else {
+            stats.underruns++;
+            stats.underrunWaitMicroseconds += waited;
+        }
+    }
+    stats.framesConsumed++;
+    return job.remap ? slot.remapped.data() : slot.packed.data();
+}
+
+void FramePipeline::release(int rgbFrame) {
+    slots[rgbFrame % ringSize]->sequence.store(2 * ((long long)rgbFrame + ringSize), std::memory_order_release);
+}
+
+void FramePipeline::endShot() {
+    cancelled.store(true, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return activeWorkers == 0; });
+}
+
+void FramePipeline::workerLoop() {
+    long long seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || shotGeneration != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = shotGeneration;
+        }
+
+        while (!cancelled.load(std::memory_order_relaxed)) {
+            int frame = nextFrame.fetch_add(1, std::memory_order_relaxed);
+            if (frame >= numRgbFrames) break;
+
+            // Wait for the display to release the slot's previous frame.
+            Slot& slot = *slots[frame % ringSize];
+            long long free = 2 * (long long)frame;
+            while (slot.sequence.load(std::memory_order_acquire) != free) {
+                if (cancelled.load(std::memory_order_relaxed)) break;
+                std::this_thread::yield();
+            }
+            if (slot.sequence.load(std::memory_order_acquire) != free) break;
+
+            uint32_t background = job.inverted ? ALL_SUBFRAMES_MASK : 0;
+            if (job.remap && (!slot.borderFilled || slot.borderColor != background)) {
+                job.remap->fillOutside(slot.remapped.data(), background);
+                slot.borderFilled = true;
+                slot.borderColor = background;
+            }
+            if (frame == 0) {
+                renderFrame(job, frame, slot.packed.data(), slot.remapped.data());
+            }
+            else {
+                FrameJob serialJob = job;
+                serialJob.pool = nullptr;
+                renderFrame(serialJob, frame, slot.packed.data(), slot.remapped.data());
+            }
+            slot.sequence.store(free + 1, std::memory_order_release);
+            framesProduced.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        idle.notify_all();
+    }
+}
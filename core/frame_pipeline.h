@@ -0,0 +1,115 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dmd_remap.h"
+#include "latency_trace.h"
+#include "thread_pool.h"
+#include "trajectory_store.h"
+#include "tweezer_stamp.h"
+
+// FrameJob: everything needed to turn the smoothed moves of one shot into RGB frames.
+struct FrameJob {
+    const TrajectoryStore* trajectories = nullptr;
+    int numMoves = 0;                   // the number of smoothed moves to display
+    const TweezerStamp* stamp = nullptr;
+    bool inverted = false;
+    const DmdRemap* remap = nullptr;    // null when the remap is done by the fragment shader
+    int width = 0;
+    int height = 0;
+    ThreadPool* pool = nullptr;         // threads that rasterize and remap a single frame together (see rasterizeFrame), or null
+    LatencyTrace* trace = nullptr;      // where RasterDone and RemapDone are recorded for each frame, or null
+
+    // numRgbFrames: the number of RGB frames displayed for the shot, each holding up to SUBFRAMES_PER_FRAME moves.
+    int numRgbFrames() const;
+};
+
+// renderFrame: rasterizes RGB frame number rgbFrame of a job into packed, and remaps it into remapped if the job has a remap.
+// Returns the buffer holding the finished frame.
+const uint32_t* renderFrame(const FrameJob& job, int rgbFrame, uint32_t* packed, uint32_t* remapped);
+
+// FramePipeline: renders the RGB frames of a shot on worker threads so that the display thread only has to upload and swap them.
+// Finished frames are handed over through a bounded ring of frame buffers. Each slot carries a sequence number that encodes whose
+// turn it is (2f: free for frame f, 2f + 1: frame f ready), so producers and the consumer synchronize without locks; workers claim
+// frames from a shared counter, and frames are always consumed in order. The workers sleep on a condition variable between shots.
+// Only the first frame of a shot is rendered with the job's thread pool, which cuts the time to the first frame without having
+// several workers compete for the pool.
+class FramePipeline {
+public:
+    ~FramePipeline() { stop(); }
+
+    // start: launches the worker threads and allocates the ring.
+    // Inputs:
+    //      numWorkers: the number of producer threads
+    //      ringSize: the number of frames that can be buffered ahead of the display
+    //      width, height: the size of a frame, in pixels
+    void start(int numWorkers, int ringSize, int width, int height);
+
+    // stop: joins the worker threads. Any shot in progress is abandoned.
+    void stop();
+
+    bool running() const { return !workers.empty(); }
+
+    // beginShot: starts producing the frames of a job. The job (and everything it points to) must stay valid until endShot().
+    void beginShot(const FrameJob& job);
+
+    // acquire: returns RGB frame number rgbFrame once it has been produced. Frames must be acquired in order.
+    const uint32_t* acquire(int rgbFrame);
+
+    // release: returns the slot holding rgbFrame to the producers.
+    void release(int rgbFrame);
+
+    // endShot: stops handing out frames and waits for every worker to go idle.
+    void endShot();
+
+    // PipelineStats: queue statistics of the current shot. queueDepth* count the frames that were ready when the display asked for
+    // one; an underrun is a frame after the first that was not ready in time, so the display had to wait for the CPU.
+    struct PipelineStats {
+        long long framesConsumed = 0;
+        long long underruns = 0;
+        double underrunWaitMicroseconds = 0.0;
+        double firstFrameWaitMicroseconds = 0.0;
+        long long totalQueueDepth = 0;
+        int minQueueDepth = 0;
+        int maxQueueDepth = 0;
+    };
+
+    PipelineStats stats;
+
+private:
+    struct Slot {
+        std::atomic<long long> sequence{ 0 };
+        std::vector<uint32_t> packed;
+        std::vector<uint32_t> remapped;
+        bool borderFilled = false;
+        uint32_t borderColor = 0;
+    };
+
+    void workerLoop();
+
+    FrameJob job;
+    int numRgbFrames = 0;
+    int ringSize = 0;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<std::thread> workers;
+
+    std::atomic<int> nextFrame{ 0 };
+    std::atomic<int> framesProduced{ 0 };
+    std::atomic<bool> cancelled{ false };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    long long shotGeneration = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+};
+
+#endif
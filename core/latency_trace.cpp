@@ -0,0 +1,96 @@
+#include "latency_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+static const char* const TRACE_EVENT_NAMES[(int)TraceEvent::Count] = {
+    "shot received", "arguments parsed", "route done", "raster done", "remap done", "upload done", "present done", "shot done"
+};
+
+const char* traceEventName(TraceEvent event) {
+    int index = (int)event;
+    return index >= 0 && index < (int)TraceEvent::Count ? TRACE_EVENT_NAMES[index] : "unknown";
+}
+
+// traceThreadNumber: a small, stable number for the calling thread.
+static uint16_t traceThreadNumber() {
+    static std::atomic<int> threadCount{ 0 };
+    thread_local uint16_t number = (uint16_t)threadCount.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+void LatencyTrace::reserve(size_t capacity) {
+    records.assign(capacity, TraceRecord());
+    clear();
+}
+
+void LatencyTrace::clear() {
+    next.store(0, std::memory_order_relaxed);
+}
+
+int LatencyTrace::beginShot(Clock::time_point received) {
+    int current = shot.fetch_add(1, std::memory_order_relaxed) + 1;
+    record(TraceEvent::ShotReceived, -1, received == Clock::time_point() ? Clock::now() : received);
+    return current;
+}
+
+void LatencyTrace::store(TraceEvent event, int frame, Clock::time_point time) {
+    long long index = next.fetch_add(1, std::memory_order_relaxed);
+    TraceRecord& record = records[(size_t)(index % (long long)records.size())];
+    record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    record.shot = shot.load(std::memory_order_relaxed);
+    record.frame = frame;
+    record.event = event;
+    record.thread = traceThreadNumber();
+}
+
+std::vector<TraceRecord> LatencyTrace::snapshot() const {
+    long long count = next.load(std::memory_order_acquire);
+    long long capacity = (long long)records.size();
+    long long first = std::max(0LL, count - capacity);
+    std::vector<TraceRecord> ordered;
+    ordered.reserve((size_t)(count - first));
+    for (long long i = first; i < count; i++) {
+        ordered.push_back(records[(size_t)(i % capacity)]);
+    }
+    // Workers record concurrently with the display thread, so slots are claimed in roughly, but not exactly, time order.
+    std::stable_sort(ordered.begin(), ordered.end(), [](const TraceRecord& a, const TraceRecord& b) { return a.time < b.time; });
+    return ordered;
+}
+
+bool LatencyTrace::writeChromeTrace(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    std::vector<TraceRecord> ordered = snapshot();
+    int64_t origin = ordered.empty() ? 0 : ordered.front().time;
+    // Chrome traces are in microseconds.
+    auto microseconds = [origin](int64_t time) { return (double)(time - origin) / 1000.0; };
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    std::map<int, std::pair<int64_t, int64_t>> shotSpans;
+    for (const TraceRecord& record : ordered) {
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"dmd\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%d,"
+                      "\"args\":{\"shot\":%d,\"frame\":%d}}",
+                first ? "" : ",\n", traceEventName(record.event), microseconds(record.time), (int)record.thread, record.shot,
+                record.frame);
+        first = false;
+        auto span = shotSpans.find(record.shot);
+        if (span == shotSpans.end()) shotSpans[record.shot] = std::make_pair(record.time, record.time);
+        else span->second.second = record.time;
+    }
+    // Shot spans go on a track of their own, after the recording threads.
+    const int SHOT_TRACK = 65536;
+    for (const auto& span : shotSpans) {
+        fprintf(file, "%s{\"name\":\"shot %d\",\"cat\":\"dmd\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}",
+                first ? "" : ",\n", span.first, microseconds(span.second.first),
+                (double)(span.second.second - span.second.first) / 1000.0, SHOT_TRACK);
+        first = false;
+    }
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"shots\"}}",
+            first ? "" : ",\n", SHOT_TRACK);
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
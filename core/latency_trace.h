@@ -0,0 +1,83 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// TraceEvent: the points of a shot at which a timestamp is taken. Per-frame events carry the RGB frame number.
+enum class TraceEvent : uint16_t {
+    ShotReceived = 0,     // the MEX function (or another caller) was entered
+    ArgumentsParsed = 1,  // the inputs have been converted into a ShotRequest
+    RouteDone = 2,        // routing and smoothing have finished
+    RasterDone = 3,       // a frame has been rasterized (on the CPU, or dispatched to the GPU)
+    RemapDone = 4,        // a frame has been remapped into the DMD coordinate system on the CPU
+    UploadDone = 5,       // a frame has been queued for transfer into the display texture
+    PresentDone = 6,      // the swap (or its headless equivalent) has returned
+    ShotDone = 7,         // the display has been cleared after the last frame
+    Count = 8
+};
+
+// traceEventName: a short name for an event, as used in Chrome traces.
+const char* traceEventName(TraceEvent event);
+
+// TraceRecord: one timestamp. time is steady_clock time in nanoseconds; thread numbers the recording threads from 0 in the order in
+// which they first recorded.
+struct TraceRecord {
+    int64_t time = 0;
+    int32_t shot = 0;
+    int32_t frame = -1;
+    TraceEvent event = TraceEvent::ShotReceived;
+    uint16_t thread = 0;
+};
+
+// LatencyTrace: timestamps from the hot path of every shot, kept in a preallocated ring so that recording never allocates and the
+// most recent events survive long runs. Recording takes one clock read and one atomic increment, and may be done from any thread
+// (the frame-pipeline workers record their own raster and remap times). The trace must only be read while no shot is running.
+class LatencyTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // reserve: sets the number of records kept (0 disables tracing) and clears the trace.
+    void reserve(size_t capacity);
+
+    bool enabled() const { return !records.empty(); }
+
+    // beginShot: starts a new shot whose request arrived at received (now, if received is the clock's epoch), and records
+    // ShotReceived. Returns the shot number.
+    int beginShot(Clock::time_point received = Clock::time_point());
+
+    // record: timestamps an event of the current shot, now or at a given time.
+    void record(TraceEvent event, int frame = -1) {
+        if (enabled()) store(event, frame, Clock::now());
+    }
+    void record(TraceEvent event, int frame, Clock::time_point time) {
+        if (enabled()) store(event, frame, time);
+    }
+
+    // clear: drops every record, keeping the capacity.
+    void clear();
+
+    // snapshot: the records still held, oldest first.
+    std::vector<TraceRecord> snapshot() const;
+
+    // recorded: the number of records written since the last clear, including those that have since been overwritten.
+    long long recorded() const { return next.load(std::memory_order_relaxed); }
+
+    int currentShot() const { return shot.load(std::memory_order_relaxed); }
+
+    // writeChromeTrace: writes the records as a Chrome trace (JSON, for chrome://tracing or Perfetto): an instant event per record
+    // and a span per shot, from ShotReceived to its last record. Returns false if the file could not be written.
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    void store(TraceEvent event, int frame, Clock::time_point time);
+
+    std::vector<TraceRecord> records;
+    std::atomic<long long> next{ 0 };
+    std::atomic<int> shot{ -1 };
+};
+
+#endif
@@ -0,0 +1,33 @@
+#include "lattice_topology.h"
+
+#include <algorithm>
+
+// The moves along vec1 come first, so that ties between equally even remainders go to rows, as in the original square router.
+static const LatticeNeighbourhood SQUARE_NEIGHBOURHOOD = {
+    LatticeTopology::Square, 4, { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } }
+};
+static const LatticeNeighbourhood TRIANGULAR_NEIGHBOURHOOD = {
+    LatticeTopology::Triangular, 6, { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, -1 }, { -1, 1 } }
+};
+
+int LatticeNeighbourhood::shortestSteps(int dRow, int dCol, int steps[2][2]) const {
+    int remaining = distance(dRow, dCol);
+    int numSteps = 0;
+    int evenness[2];
+    for (int k = 0; k < numNeighbours && numSteps < 2; k++) {
+        int restRow = dRow - offsets[k][0], restCol = dCol - offsets[k][1];
+        if (distance(restRow, restCol) != remaining - 1) continue;
+        steps[numSteps][0] = offsets[k][0];
+        steps[numSteps][1] = offsets[k][1];
+        evenness[numSteps++] = std::max(abs(restRow), abs(restCol));
+    }
+    if (numSteps == 2 && evenness[1] < evenness[0]) {
+        std::swap(steps[0][0], steps[1][0]);
+        std::swap(steps[0][1], steps[1][1]);
+    }
+    return numSteps;
+}
+
+const LatticeNeighbourhood& latticeNeighbourhood(LatticeTopology topology) {
+    return topology == LatticeTopology::Triangular ? TRIANGULAR_NEIGHBOURHOOD : SQUARE_NEIGHBOURHOOD;
+}
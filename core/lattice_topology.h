@@ -0,0 +1,35 @@
+#ifndef LATTICE_TOPOLOGY_H
+#define LATTICE_TOPOLOGY_H
+
+#include <cstdlib>
+
+// LatticeTopology: which lattice sites are neighbours, i.e. which moves a tweezer can make between two lattice frames. The numeric
+// values are the codes accepted from MATLAB.
+enum class LatticeTopology {
+    Square = 0,       // four neighbours, +-vec1 and +-vec2 (row +- 1 or col +- 1)
+    Triangular = 1    // six neighbours, +-vec1, +-vec2 and +-(vec1 - vec2), for lattice vectors of equal length 60 degrees apart
+};
+
+// LatticeNeighbourhood: the moves of one topology, as (row, col) offsets, and the distances they give the lattice. The routers take
+// their neighbour generation and distances from here (see latticeNeighbourhood).
+struct LatticeNeighbourhood {
+    LatticeTopology topology;
+    int numNeighbours;
+    int offsets[6][2];
+
+    // distance: the smallest number of moves that covers dRow rows and dCol columns.
+    int distance(int dRow, int dCol) const {
+        if (topology == LatticeTopology::Triangular) return (abs(dRow) + abs(dCol) + abs(dRow + dCol)) / 2;
+        return abs(dRow) + abs(dCol);
+    }
+
+    // shortestSteps: writes the moves that begin a shortest path over (dRow, dCol) to steps and returns how many there are (at most two,
+    // and none for (0, 0)). The move leaving the most even remainder comes first (e.g. on a square lattice, the move along the axis with
+    // further to go), so that a tweezer following the first move heads straight for its target.
+    int shortestSteps(int dRow, int dCol, int steps[2][2]) const;
+};
+
+// latticeNeighbourhood: the neighbourhood of the given topology.
+const LatticeNeighbourhood& latticeNeighbourhood(LatticeTopology topology);
+
+#endif
@@ -0,0 +1,53 @@
+#include "occupancy_grid.h"
+
+#include <algorithm>
+
+void OccupancyGrid::reset(int rows, int cols) {
+    numRows = rows;
+    numCols = cols;
+    wordsPerRow = (cols + 2 + 63) / 64;
+    words.assign((size_t)(rows + 2) * wordsPerRow, 0);
+    // The border: the whole padded rows above and below the lattice, and the padded columns either side of every lattice row.
+    for (int col = -1; col <= cols; col++) {
+        set(-1, col);
+        set(rows, col);
+    }
+    for (int row = 0; row < rows; row++) {
+        set(row, -1);
+        set(row, cols);
+    }
+}
+
+int OccupancyGrid::load(int** tweezerPositions, int rows, int cols, TrajectoryStore& trajectories, long long& rowSum, long long& colSum) {
+    reset(rows, cols);
+    int numAtoms = 0;
+    rowSum = 0;
+    colSum = 0;
+    for (int i = 0; i < rows; i++) {
+        const int* row = tweezerPositions[i];
+        for (int j = 0; j < cols; j++) {
+            if (row[j] != 1) continue;
+            set(i, j);
+            trajectories.latticeRow(0, numAtoms) = i;
+            trajectories.latticeCol(0, numAtoms) = j;
+            rowSum += i;
+            colSum += j;
+            numAtoms++;
+        }
+    }
+    return numAtoms;
+}
+
+int OccupancyGrid::count() const {
+    int bits = 0;
+    for (uint64_t word : words) bits += popcount64(word);
+    return bits - 2 * (numCols + 2) - 2 * numRows;
+}
+
+bool OccupancyGrid::covers(const OccupancyGrid& region) const {
+    size_t numWords = std::min(words.size(), region.words.size());
+    for (size_t k = 0; k < numWords; k++) {
+        if (region.words[k] & ~words[k]) return false;
+    }
+    return true;
+}
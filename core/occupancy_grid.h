@@ -0,0 +1,102 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "trajectory_store.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// popcount64: the number of set bits in word.
+inline int popcount64(uint64_t word) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// lowestBit64: the index of the lowest set bit in word, which must not be 0.
+inline int lowestBit64(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// OccupancyGrid: the occupancy matrix as a bitset, one bit per lattice site and each row packed into 64-bit words, for the routers'
+// neighbour queries. The lattice is surrounded by a border of set bits, so that a site off the lattice reads as occupied and the
+// neighbours of an edge site need no bounds checks.
+class OccupancyGrid {
+public:
+    // reset: empties the grid for a lattice of rows x cols sites (leaving only the border set). Memory is only reallocated when the grid
+    // needs more room.
+    void reset(int rows, int cols);
+
+    // load: resets the grid to the occupancy matrix, and in the same pass stores the position of every atom in the first lattice frame
+    // of trajectories (numbering the tweezers in row-major order) and sums their rows and columns, for the center of mass. Returns the
+    // number of atoms.
+    // Inputs:
+    //      tweezerPositions: the occupancy matrix, addressed as tweezerPositions[row][col], 1 where a site holds an atom
+    //      rows, cols: the dimensions of the occupancy matrix
+    //      trajectories: the store receiving the positions, reserved for at least as many tweezers as there are atoms
+    //      rowSum, colSum: set to the sums of the atoms' rows and columns
+    int load(int** tweezerPositions, int rows, int cols, TrajectoryStore& trajectories, long long& rowSum, long long& colSum);
+
+    bool occupied(int row, int col) const { return (words[wordIndex(row, col)] >> bitIndex(col)) & 1; }
+    void set(int row, int col) { words[wordIndex(row, col)] |= (uint64_t)1 << bitIndex(col); }
+    void clear(int row, int col) { words[wordIndex(row, col)] &= ~((uint64_t)1 << bitIndex(col)); }
+
+    // move: moves an atom from one site to another.
+    void move(int fromRow, int fromCol, int toRow, int toCol) {
+        clear(fromRow, fromCol);
+        set(toRow, toCol);
+    }
+
+    // window: the occupancy of the 3 x 3 block of sites centered on (row, col), gathered from three rows of words: bit
+    // windowBit(dRow, dCol) is set where site (row + dRow, col + dCol) holds an atom or lies off the lattice. A move to a neighbour is
+    // possible where that bit is clear.
+    unsigned window(int row, int col) const {
+        return (unsigned)(rowBits(row, col) | rowBits(row + 1, col) << 3 | rowBits(row + 2, col) << 6);
+    }
+    static int windowBit(int dRow, int dCol) { return (dRow + 1) * 3 + dCol + 1; }
+
+    // count: the number of atoms, by popcount.
+    int count() const;
+
+    // covers: whether every site set in "region" (a grid of the same dimensions, e.g. the target sites of a routing) holds an atom.
+    bool covers(const OccupancyGrid& region) const;
+
+    int rows() const { return numRows; }
+    int cols() const { return numCols; }
+
+    size_t capacityBytes() const { return words.capacity() * sizeof(uint64_t); }
+
+private:
+    // wordIndex, bitIndex: where site (row, col) is stored, counting the border row above and the border column to the left.
+    size_t wordIndex(int row, int col) const { return (size_t)(row + 1) * wordsPerRow + ((col + 1) >> 6); }
+    static int bitIndex(int col) { return (col + 1) & 63; }
+
+    // rowBits: the three bits of padded row paddedRow for columns col - 1 to col + 1, lowest first.
+    uint64_t rowBits(int paddedRow, int col) const {
+        const uint64_t* row = words.data() + (size_t)paddedRow * wordsPerRow + (col >> 6);
+        int shift = col & 63;
+        uint64_t bits = row[0] >> shift;
+        if (shift > 61) bits |= row[1] << (64 - shift);
+        return bits & 7;
+    }
+
+    int numRows = 0;
+    int numCols = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> words;  // (numRows + 2) rows of wordsPerRow words; bit b of a row's words holds column b - 1
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "plan_cache.h"
+
+#include <iterator>
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void PlanCache::configure(int maxEntries, size_t maxBytes) {
+    this->maxEntries = maxEntries;
+    this->maxBytes = maxBytes;
+    clear();
+}
+
+CachedPlan* PlanCache::find(const uint8_t* occupancy, int rows, int cols, int N, const LatticeGeometry& lattice, int maxTime,
+                            RoutingMethod routing, const uint8_t* targetPattern) {
+    counters.lookups++;
+    size_t numSites = (size_t)rows * cols;
+    key.rows = rows;
+    key.cols = cols;
+    key.N = N;
+    key.maxTime = maxTime;
+    key.routing = routing;
+    key.lattice = lattice;
+    key.occupancy.assign(occupancy, occupancy + numSites);
+    if (targetPattern != nullptr) key.targetPattern.assign(targetPattern, targetPattern + numSites);
+    else key.targetPattern.clear();
+
+    // The fields are hashed one by one, so that padding never enters the hash.
+    uint64_t hash = hashBytes(FNV_OFFSET_BASIS, key.occupancy.data(), numSites);
+    hash = hashBytes(hash, key.targetPattern.data(), key.targetPattern.size());
+    int parameters[] = { rows, cols, N, maxTime, (int)routing, (int)lattice.topology, targetPattern != nullptr };
+    hash = hashBytes(hash, parameters, sizeof(parameters));
+    float geometry[] = { lattice.vec1X, lattice.vec1Y, lattice.vec2X, lattice.vec2Y, lattice.centerX, lattice.centerY };
+    key.hash = hashBytes(hash, geometry, sizeof(geometry));
+
+    auto found = index.find(key.hash);
+    if (found == index.end() || !matches(*found->second)) return nullptr;
+    entries.splice(entries.begin(), entries, found->second);
+    counters.hits++;
+    return &entries.front().plan;
+}
+
+bool PlanCache::matches(const Entry& entry) const {
+    const LatticeGeometry& a = entry.lattice;
+    const LatticeGeometry& b = key.lattice;
+    return entry.rows == key.rows && entry.cols == key.cols && entry.N == key.N && entry.maxTime == key.maxTime &&
+           entry.routing == key.routing && a.topology == b.topology && a.vec1X == b.vec1X && a.vec1Y == b.vec1Y && a.vec2X == b.vec2X &&
+           a.vec2Y == b.vec2Y && a.centerX == b.centerX && a.centerY == b.centerY && entry.occupancy == key.occupancy &&
+           entry.targetPattern == key.targetPattern;
+}
+
+CachedPlan& PlanCache::insert(const TrajectoryStore& trajectories, int numTweezers, int numLatticeFrames) {
+    // An entry with the same hash (a collision) is replaced; otherwise the least recently used entry makes room when the cache is full.
+    std::list<Entry> reuse;
+    auto found = index.find(key.hash);
+    if (found != index.end()) {
+        reuse.splice(reuse.begin(), entries, found->second);
+        index.erase(found);
+        counters.evictions++;
+    }
+    else if (!entries.empty() && (int)entries.size() >= maxEntries) {
+        evictLast(&reuse);
+    }
+    if (reuse.empty()) reuse.emplace_back();
+
+    Entry& entry = reuse.front();
+    entry.hash = key.hash;
+    entry.rows = key.rows;
+    entry.cols = key.cols;
+    entry.N = key.N;
+    entry.maxTime = key.maxTime;
+    entry.routing = key.routing;
+    entry.lattice = key.lattice;
+    entry.occupancy = key.occupancy;
+    entry.targetPattern = key.targetPattern;
+    CachedPlan& plan = entry.plan;
+    plan.trajectories.copyFrom(trajectories, numLatticeFrames);
+    plan.numTweezers = numTweezers;
+    plan.numLatticeFrames = numLatticeFrames;
+    plan.siteSteps = 0;
+    plan.assignmentCost = 0;
+    plan.numTargets = 0;
+    plan.targetsFilled = 0;
+    plan.parkedAtoms = 0;
+    plan.frameKey = 0;
+
+    entries.splice(entries.begin(), reuse);
+    index[key.hash] = entries.begin();
+    return entries.front().plan;
+}
+
+void PlanCache::evictLast(std::list<Entry>* reuse) {
+    auto last = std::prev(entries.end());
+    index.erase(last->hash);
+    counters.evictions++;
+    if (reuse != nullptr) reuse->splice(reuse->begin(), entries, last);
+    else entries.erase(last);
+}
+
+bool PlanCache::reserveFrames(CachedPlan& plan, size_t numValues) {
+    size_t bytes = key.occupancy.capacity() + key.targetPattern.capacity() + plan.trajectories.capacityBytes();
+    for (const Entry& entry : entries) {
+        if (&entry.plan == &plan) bytes += entry.occupancy.capacity() + entry.targetPattern.capacity();
+    }
+    // A buffer handed on by a larger plan is given up when it would not fit, though the frames themselves would.
+    if (bytes + numValues * sizeof(uint32_t) > maxBytes) {
+        std::vector<uint32_t>().swap(plan.frames);
+        counters.framesSkipped++;
+        return false;
+    }
+    if (bytes + plan.frames.capacity() * sizeof(uint32_t) > maxBytes) std::vector<uint32_t>().swap(plan.frames);
+    plan.frames.resize(numValues);
+    return true;
+}
+
+void PlanCache::trim() {
+    while (entries.size() > 1 && capacityBytes() > maxBytes) evictLast(nullptr);
+}
+
+void PlanCache::clear() {
+    entries.clear();
+    index.clear();
+    counters = Stats();
+}
+
+size_t PlanCache::capacityBytes() const {
+    size_t bytes = key.occupancy.capacity() + key.targetPattern.capacity();
+    for (const Entry& entry : entries) bytes += entry.plan.capacityBytes() + entry.occupancy.capacity() + entry.targetPattern.capacity();
+    return bytes;
+}
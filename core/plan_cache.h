@@ -0,0 +1,114 @@
+#ifndef PLAN_CACHE_H
+#define PLAN_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "router.h"
+#include "trajectory_smoothing.h"
+#include "trajectory_store.h"
+
+// hashBytes: folds size bytes of data into hash (64-bit FNV-1a); start from FNV_OFFSET_BASIS.
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size);
+
+// CachedPlan: the outcome of routing and smoothing one shot, as kept by a PlanCache.
+struct CachedPlan {
+    TrajectoryStore trajectories;          // the lattice frames, DMD-space sites and smoothed moves of the plan, sized for exactly these
+    int numTweezers = 0;
+    int numLatticeFrames = 0;
+    // The routing cost of the plan (see ShotResult).
+    long long siteSteps = 0;
+    long long assignmentCost = 0;
+    int numTargets = 0;
+    int targetsFilled = 0;
+    int parkedAtoms = 0;
+    // frames: the RGB frames of the plan as they were uploaded, one after the other, if they have been cached; they are only valid for
+    // the tweezer shape and display settings whose key is frameKey (0 when no frames are cached).
+    std::vector<uint32_t> frames;
+    uint64_t frameKey = 0;
+
+    size_t capacityBytes() const { return trajectories.capacityBytes() + frames.capacity() * sizeof(uint32_t); }
+};
+
+// PlanCache: a least-recently-used cache of plans, keyed by everything routing and smoothing depend on: the occupancy matrix, the
+// lattice geometry and topology, the smoothing factor, the routing method, the maximum number of lattice frames and the target
+// pattern. A shot whose occupancy has been seen before with the same parameters (as stochastic loading often produces) can then be
+// displayed without routing, and, with its frames cached, without rasterizing either.
+// Entries are looked up by a 64-bit hash of the key and then compared in full, so a collision is a miss, never a wrong plan. The
+// cache holds at most maxEntries plans, and evicts the least recently used ones beyond maxBytes; an entry evicted for a new plan
+// hands its buffers on to it, so that a full cache stores plans of similar size without allocating. Frames that would not fit in
+// maxBytes even on their own are not cached.
+class PlanCache {
+public:
+    struct Stats {
+        long long lookups = 0;
+        long long hits = 0;
+        long long evictions = 0;
+        long long framesSkipped = 0;  // shots whose frames were not cached, as they would not have fit in maxBytes
+
+        double hitRate() const { return lookups > 0 ? (double)hits / lookups : 0.0; }
+    };
+
+    // configure: sets the limits and empties the cache. A cache with maxEntries 0 is disabled.
+    void configure(int maxEntries, size_t maxBytes);
+    bool enabled() const { return maxEntries > 0; }
+
+    // find: looks up the plan of a shot, and returns it (now the most recently used) or null. The key of the shot is kept for a
+    // following insert().
+    // Inputs:
+    //      occupancy: the row-major occupancy matrix, 1 where a site holds an atom
+    //      rows, cols: the dimensions of the occupancy matrix
+    //      N, lattice, maxTime, routing, targetPattern: as passed to generateFrames (targetPattern may be null)
+    CachedPlan* find(const uint8_t* occupancy, int rows, int cols, int N, const LatticeGeometry& lattice, int maxTime,
+                     RoutingMethod routing, const uint8_t* targetPattern);
+
+    // insert: stores the plan of the shot last passed to find(), copying numLatticeFrames lattice frames and their smoothed moves from
+    // trajectories, and returns the entry for the rest of the plan to be filled in. Evicts the least recently used entry if the
+    // cache is full; call trim() once the entry is complete.
+    CachedPlan& insert(const TrajectoryStore& trajectories, int numTweezers, int numLatticeFrames);
+
+    // reserveFrames: sizes the frames of plan, an entry of this cache, for numValues values, if the entry alone then still fits in
+    // maxBytes; otherwise frees its frames, counts the shot in stats().framesSkipped and returns false, so that trim() is never left
+    // with a last entry it cannot bring within maxBytes.
+    bool reserveFrames(CachedPlan& plan, size_t numValues);
+
+    // trim: evicts the least recently used entries, sparing the most recent one, until the cache holds at most maxBytes.
+    void trim();
+
+    // clear: drops every entry and the statistics.
+    void clear();
+
+    int size() const { return (int)entries.size(); }
+    size_t capacityBytes() const;
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        int rows = 0, cols = 0, N = 0, maxTime = 0;
+        RoutingMethod routing = RoutingMethod::CenterOfMass;
+        LatticeGeometry lattice;
+        std::vector<uint8_t> occupancy;
+        std::vector<uint8_t> targetPattern;  // empty when the shot had none
+        CachedPlan plan;
+    };
+
+    // matches: whether entry holds the plan of the key last passed to find().
+    bool matches(const Entry& entry) const;
+
+    // evictLast: removes the least recently used entry, and returns it for reuse when a list of one is wanted.
+    void evictLast(std::list<Entry>* reuse);
+
+    int maxEntries = 0;
+    size_t maxBytes = 0;
+    std::list<Entry> entries;  // the most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    Entry key;                 // the key of the last find(), its plan unused
+    Stats counters;
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include "replan_router.h"
+
+#include <algorithm>
+#include <climits>
+
+// findChain: finds how to fill a hole that the spare cannot reach directly, through the tweezers ending around it: a path from the
+// hole over sites on which tweezers not yet repaired end, to one next to a site on which no tweezer ends and that is connected to the
+// spare's own last site "origin" by such sites, so that each of those tweezers can move up one site towards the hole and the spare end
+// on the site they leave at the far end. Of the possible paths, the one minimising its length plus the distance of the spare from its
+// far end is taken. Leaves the sites of the path, from the hole outwards, in workspace.chain, and returns false if there is none.
+static bool findChain(int hole, int spare, int origin, int occupancyRows, int occupancyCols, const LatticeNeighbourhood& neighbourhood,
+                      const TrajectoryStore& trajectories, ReplanWorkspace& workspace) {
+    int numSites = occupancyRows * occupancyCols;
+    // The sites the spare can reach once every other tweezer has arrived.
+    std::vector<char>& reachable = workspace.reachable;
+    std::vector<int>& queue = workspace.queue;
+    reachable.assign(numSites, 0);
+    reachable[origin] = 1;
+    queue.assign(1, origin);
+    for (size_t head = 0; head < queue.size(); head++) {
+        int row = queue[head] / occupancyCols, col = queue[head] % occupancyCols;
+        for (int k = 0; k < neighbourhood.numNeighbours; k++) {
+            int nextRow = row + neighbourhood.offsets[k][0], nextCol = col + neighbourhood.offsets[k][1];
+            if (nextRow < 0 || nextRow >= occupancyRows || nextCol < 0 || nextCol >= occupancyCols) continue;
+            int next = nextRow * occupancyCols + nextCol;
+            if (reachable[next] || workspace.endAt[next] >= 0) continue;
+            reachable[next] = 1;
+            queue.push_back(next);
+        }
+    }
+
+    std::vector<int>& parent = workspace.parent;
+    parent.assign(numSites, -2);
+    queue.assign(1, hole);
+    parent[hole] = -1;
+    int spareRow = trajectories.latticeRow(0, spare), spareCol = trajectories.latticeCol(0, spare);
+    int best = -1, bestCost = INT_MAX;
+    // The queue holds the sites in order of their distance from the hole, level by level.
+    std::vector<int>& depth = workspace.depth;
+    depth.assign(1, 0);
+    for (size_t head = 0; head < queue.size(); head++) {
+        int site = queue[head];
+        int row = site / occupancyCols, col = site % occupancyCols;
+        bool open = false;
+        for (int k = 0; k < neighbourhood.numNeighbours; k++) {
+            int nextRow = row + neighbourhood.offsets[k][0], nextCol = col + neighbourhood.offsets[k][1];
+            if (nextRow < 0 || nextRow >= occupancyRows || nextCol < 0 || nextCol >= occupancyCols) continue;
+            int next = nextRow * occupancyCols + nextCol;
+            int i = workspace.endAt[next];
+            if (i < 0) {
+                open = open || reachable[next];
+                continue;
+            }
+            if (parent[next] != -2 || workspace.repaired[i]) continue;
+            parent[next] = site;
+            queue.push_back(next);
+            depth.push_back(depth[head] + 1);
+        }
+        int cost = depth[head] + neighbourhood.distance(row - spareRow, col - spareCol);
+        if (site != hole && open && cost < bestCost) {
+            best = site;
+            bestCost = cost;
+        }
+    }
+    if (best < 0) return false;
+    std::vector<int>& chain = workspace.chain;
+    chain.clear();
+    for (int site = best; site >= 0; site = parent[site]) chain.push_back(site);
+    std::reverse(chain.begin(), chain.end());
+    return true;
+}
+
+int replanFrames(const TrajectoryStore& plan, int numPlanFrames, int fromFrame, const int8_t* delta, int occupancyRows,
+                 int occupancyCols, TrajectoryStore& trajectories, int N, const LatticeGeometry& lattice, int maxTime,
+                 ReplanWorkspace& workspace, ReservationWorkspace& reservation, const uint8_t* targetPattern) {
+    const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(lattice.topology);
+    int numSites = occupancyRows * occupancyCols;
+    int numPlanTweezers = plan.numTweezers;
+    fromFrame = std::max(0, std::min(fromFrame, numPlanFrames - 1));
+    // The lattice stage of a smoothed plan is counted from the center of the occupancy matrix (see smoothTrajectories).
+    int rowOffset = occupancyRows / 2, colOffset = occupancyCols / 2;
+    auto planSite = [&](int frame, int i) {
+        return (plan.latticeRow(frame, i) + rowOffset) * occupancyCols + plan.latticeCol(frame, i) + colOffset;
+    };
+
+    // Sort out the tweezers that keep their atoms and the extra atoms, comparing the delta with the occupancy of the plan in fromFrame.
+    std::vector<uint8_t>& observed = workspace.observed;
+    observed.assign(numSites, 0);
+    for (int i = 0; i < numPlanTweezers; i++) observed[planSite(fromFrame, i)] = 1;
+    std::vector<int>& continues = workspace.continues;
+    continues.clear();
+    workspace.holes.clear();
+    workspace.lostAtoms = 0;
+    for (int i = 0; i < numPlanTweezers; i++) {
+        if (delta[planSite(fromFrame, i)] != (int8_t)AtomChange::Lost) {
+            continues.push_back(i);
+            continue;
+        }
+        workspace.lostAtoms++;
+        int hole = planSite(numPlanFrames - 1, i);
+        if (targetPattern == nullptr || targetPattern[hole] == (uint8_t)TargetSite::Target) workspace.holes.push_back(hole);
+    }
+    int numKept = (int)continues.size();
+    std::vector<int>& spares = workspace.spares;
+    spares.clear();
+    for (int site = 0; site < numSites; site++) {
+        if (delta[site] == (int8_t)AtomChange::Extra && !observed[site]) spares.push_back(site);
+    }
+    workspace.extraAtoms = (int)spares.size();
+    for (int i = 0; i < numPlanTweezers; i++) {
+        if (delta[planSite(fromFrame, i)] == (int8_t)AtomChange::Lost) observed[planSite(fromFrame, i)] = 0;
+    }
+    for (int site : spares) observed[site] = 1;
+
+    // The repaired plan: the kept tweezers follow the rest of their paths (waiting on their last sites), and the extra atoms, numbered
+    // after them, wait where they are.
+    int numTweezers = numKept + workspace.extraAtoms;
+    int numFrames = std::max(maxTime, numPlanFrames - fromFrame);
+    trajectories.reserve(numTweezers, N, numFrames);
+    for (int frame = 0; frame < numFrames; frame++) {
+        int planFrame = std::min(fromFrame + frame, numPlanFrames - 1);
+        for (int k = 0; k < numKept; k++) {
+            trajectories.latticeRow(frame, k) = plan.latticeRow(planFrame, continues[k]) + rowOffset;
+            trajectories.latticeCol(frame, k) = plan.latticeCol(planFrame, continues[k]) + colOffset;
+        }
+        for (int e = 0; e < workspace.extraAtoms; e++) {
+            trajectories.latticeRow(frame, numKept + e) = spares[e] / occupancyCols;
+            trajectories.latticeCol(frame, numKept + e) = spares[e] % occupancyCols;
+        }
+    }
+    continues.resize(numTweezers, -1);
+    auto lastSite = [&](int i) {
+        return trajectories.latticeRow(numFrames - 1, i) * occupancyCols + trajectories.latticeCol(numFrames - 1, i);
+    };
+
+    // Hold the kept paths on the reservation table, and note the sites they end on.
+    size_t numNodes = (size_t)numSites * numFrames;
+    if (reservation.searchStamp.size() < numNodes) {
+        reservation.searchStamp.assign(numNodes, 0);
+        reservation.searchParent.resize(numNodes);
+        reservation.stamp = 0;
+    }
+    ReservationTable& table = reservation.table;
+    table.reset(numSites, numFrames);
+    std::vector<char>& keptEnd = workspace.keptEnd;
+    keptEnd.assign(numSites, 0);
+    for (int k = 0; k < numKept; k++) {
+        table.hold(trajectories, k, occupancyCols);
+        keptEnd[lastSite(k)] = 1;
+    }
+
+    // An extra atom standing where a kept path later passes takes over the rest of that path, from the frame the tweezer following it
+    // would arrive; that tweezer waits where it was in the frame before, and in turn takes over the next path to pass there, down the
+    // queue, until one can wait for good. No move is added, so no two tweezers come to share or swap sites.
+    for (int e = numKept; e < numTweezers; e++) {
+        int current = e, site = lastSite(e), frame = 1;
+        for (int handovers = 0;; handovers++) {
+            while (frame < numFrames && table.free(site, frame)) frame++;
+            if (frame == numFrames) break;
+            if (handovers > numTweezers) return 0;
+            int j = table.holder(site, frame);
+            table.release(trajectories, j, occupancyCols);
+            int waitRow = trajectories.latticeRow(frame - 1, j), waitCol = trajectories.latticeCol(frame - 1, j);
+            for (int pathFrame = frame; pathFrame < numFrames; pathFrame++) {
+                trajectories.latticeRow(pathFrame, current) = trajectories.latticeRow(pathFrame, j);
+                trajectories.latticeCol(pathFrame, current) = trajectories.latticeCol(pathFrame, j);
+                trajectories.latticeRow(pathFrame, j) = waitRow;
+                trajectories.latticeCol(pathFrame, j) = waitCol;
+            }
+            table.hold(trajectories, current, occupancyCols);
+            current = j;
+            site = waitRow * occupancyCols + waitCol;
+        }
+        table.hold(trajectories, current, occupancyCols);
+    }
+    std::vector<int>& endAt = workspace.endAt;
+    endAt.assign(numSites, -1);
+    for (int i = 0; i < numTweezers; i++) endAt[lastSite(i)] = i;
+
+    // The holes that are still empty, and the tweezers that may fill them: those ending where no kept path ended (one per extra atom),
+    // and with a target pattern every tweezer not ending on a target.
+    std::vector<int>& holes = workspace.holes;
+    holes.erase(std::remove_if(holes.begin(), holes.end(), [&](int hole) { return endAt[hole] >= 0; }), holes.end());
+    spares.clear();
+    for (int i = 0; i < numTweezers; i++) {
+        int last = lastSite(i);
+        if (targetPattern != nullptr ? targetPattern[last] != (uint8_t)TargetSite::Target : !keptEnd[last]) spares.push_back(i);
+    }
+
+    // Match holes and spares by a minimum-cost assignment, the smaller set as its rows.
+    std::vector<int>& repair = workspace.repair;
+    repair.clear();
+    workspace.fill.clear();
+    int numHoles = (int)holes.size(), numSpares = (int)spares.size();
+    if (numHoles > 0 && numSpares > 0) {
+        bool holeRows = numHoles <= numSpares;
+        int rows = holeRows ? numHoles : numSpares, cols = holeRows ? numSpares : numHoles;
+        workspace.cost.resize((size_t)rows * cols);
+        workspace.matching.resize(rows);
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                int hole = holes[holeRows ? r : c], spare = spares[holeRows ? c : r];
+                workspace.cost[(size_t)r * cols + c] = neighbourhood.distance(hole / occupancyCols - trajectories.latticeRow(0, spare),
+                                                                              hole % occupancyCols - trajectories.latticeCol(0, spare));
+            }
+        }
+        workspace.solver.solve(workspace.cost.data(), rows, cols, workspace.matching.data());
+        for (int r = 0; r < rows; r++) {
+            int hole = holes[holeRows ? r : workspace.matching[r]];
+            int spare = spares[holeRows ? workspace.matching[r] : r];
+            repair.push_back(spare);
+            workspace.fill.push_back(hole);
+        }
+    }
+
+    auto setEnd = [&](int i, int site) {
+        trajectories.latticeRow(numFrames - 1, i) = site / occupancyCols;
+        trajectories.latticeCol(numFrames - 1, i) = site % occupancyCols;
+        endAt[site] = i;
+    };
+    auto search = [&](int i) {
+        if (searchPath(i, numFrames, occupancyRows, occupancyCols, neighbourhood, trajectories, reservation) < 0) return false;
+        table.hold(trajectories, i, occupancyCols);
+        workspace.repairedPaths++;
+        return true;
+    };
+
+    // Fill the holes, nearest first, each around every other path. A hole the spare cannot reach (one inside a filled region, whose
+    // neighbours are held to the end) is filled by shifting a chain of tweezers towards it instead; one that no chain leads to is left
+    // empty, and the spare keeps its path.
+    std::vector<int>& order = workspace.order;
+    order.resize(repair.size());
+    for (size_t r = 0; r < repair.size(); r++) order[r] = (int)r;
+    auto remaining = [&](int r) {
+        int hole = workspace.fill[r], spare = repair[r];
+        return neighbourhood.distance(hole / occupancyCols - trajectories.latticeRow(0, spare),
+                                      hole % occupancyCols - trajectories.latticeCol(0, spare));
+    };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return remaining(a) < remaining(b); });
+    std::vector<char>& repaired = workspace.repaired;
+    repaired.assign(numTweezers, 0);
+    workspace.repairedPaths = 0;
+    workspace.holesFilled = 0;
+    for (int r : order) {
+        int spare = repair[r], hole = workspace.fill[r], origin = lastSite(spare);
+        table.release(trajectories, spare, occupancyCols);
+        endAt[origin] = -1;
+        setEnd(spare, hole);
+        repaired[spare] = 1;
+        if (search(spare)) {
+            workspace.holesFilled++;
+            continue;
+        }
+        endAt[hole] = -1;
+        if (!findChain(hole, spare, origin, occupancyRows, occupancyCols, neighbourhood, trajectories, workspace)) {
+            setEnd(spare, origin);
+            table.hold(trajectories, spare, occupancyCols);
+            continue;
+        }
+        // chain holds the sites from the hole outwards: each tweezer moves up to the site before its own, the spare takes the last. Their
+        // paths are kept, so that the shift can be undone if one of them cannot be placed.
+        std::vector<int>& chain = workspace.chain;
+        std::vector<int>& shifted = workspace.shifted;
+        shifted.assign(1, spare);
+        for (size_t c = 1; c < chain.size(); c++) shifted.push_back(endAt[chain[c]]);
+        workspace.savedRows.resize(shifted.size() * numFrames);
+        workspace.savedCols.resize(shifted.size() * numFrames);
+        for (size_t s = 0; s < shifted.size(); s++) {
+            for (int frame = 0; frame < numFrames; frame++) {
+                workspace.savedRows[s * numFrames + frame] = trajectories.latticeRow(frame, shifted[s]);
+                workspace.savedCols[s * numFrames + frame] = trajectories.latticeCol(frame, shifted[s]);
+            }
+        }
+        workspace.savedRows[numFrames - 1] = origin / occupancyCols;
+        workspace.savedCols[numFrames - 1] = origin % occupancyCols;
+        bool placed = true;
+        for (size_t c = 1; c < chain.size() && placed; c++) {
+            int i = shifted[c];
+            table.release(trajectories, i, occupancyCols);
+            repaired[i] = 1;
+            setEnd(i, chain[c - 1]);
+            placed = search(i);
+        }
+        if (placed) {
+            setEnd(spare, chain.back());
+            placed = search(spare);
+        }
+        if (placed) {
+            workspace.holesFilled++;
+            continue;
+        }
+        for (size_t s = 0; s < shifted.size(); s++) {
+            int i = shifted[s];
+            table.release(trajectories, i, occupancyCols);
+            for (int frame = 0; frame < numFrames; frame++) {
+                trajectories.latticeRow(frame, i) = workspace.savedRows[s * numFrames + frame];
+                trajectories.latticeCol(frame, i) = workspace.savedCols[s * numFrames + frame];
+            }
+            table.hold(trajectories, i, occupancyCols);
+            endAt[lastSite(i)] = i;
+            repaired[i] = s == 0;
+        }
+        endAt[hole] = -1;
+    }
+
+    // The repaired plan ends once the last tweezer has arrived.
+    int lastMove = 0;
+    for (int frame = 1; frame < numFrames; frame++) {
+        for (int i = 0; i < numTweezers; i++) {
+            if (trajectories.latticeRow(frame, i) != trajectories.latticeRow(frame - 1, i) ||
+                trajectories.latticeCol(frame, i) != trajectories.latticeCol(frame - 1, i)) {
+                lastMove = frame;
+                break;
+            }
+        }
+    }
+    smoothTrajectories(trajectories, numTweezers, lastMove + 1, occupancyRows, occupancyCols, N, lattice);
+    return lastMove + 1;
+}
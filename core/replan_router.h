@@ -0,0 +1,88 @@
+#ifndef REPLAN_ROUTER_H
+#define REPLAN_ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assignment.h"
+#include "reservation_router.h"
+#include "trajectory_smoothing.h"
+#include "trajectory_store.h"
+
+// AtomChange: what an image taken during a shot found on a site, compared with the plan (see replanFrames), as stored in the delta
+// matrix.
+enum class AtomChange : int8_t {
+    Lost = -1,       // the tweezer planned on the site holds no atom
+    Unchanged = 0,
+    Extra = 1        // an atom sits on a site no tweezer was planned on
+};
+
+// ReplanWorkspace: the buffers used by replanFrames, kept between shots (see FrameContext) so that replanning does not allocate once
+// they have been sized.
+struct ReplanWorkspace {
+    TrajectoryStore previous;               // the plan being repaired, swapped out of the caller's store (see DmdRenderer::replanShot)
+    AssignmentSolver solver;
+    std::vector<int> continues;             // per tweezer of the repaired plan, the tweezer of the old plan it continues, or -1
+    std::vector<int> holes;                 // the sites left empty by lost atoms that are to be filled
+    std::vector<int> spares;                // the tweezers that may fill them
+    std::vector<int> cost, matching;
+    std::vector<int> repair;                // the spares matched to holes
+    std::vector<int> fill;                  // the hole each of them is to fill
+    std::vector<int> order;                 // the order in which the holes are filled, as indices into repair
+    std::vector<char> repaired;             // per tweezer, whether its path has been searched again
+    std::vector<char> keptEnd;              // per site, whether a kept path ended on it before the extra atoms took over paths
+    std::vector<int> endAt;                 // per site, the tweezer ending on it, or -1
+    std::vector<int> parent, queue, depth;  // the breadth-first search for a chain of tweezers to shift into a hole
+    std::vector<int> chain;                 // the sites of that chain, from the hole outwards
+    std::vector<char> reachable;            // per site, whether the spare can reach it once the other tweezers have arrived
+    std::vector<int> shifted;               // the spare and the tweezers of the chain, whose paths are saved while it is shifted
+    std::vector<int> savedRows, savedCols;  // their paths, tweezer-major
+    std::vector<uint8_t> observed;          // the occupancy found by the image, for routing it from scratch when the repair fails
+    int lostAtoms = 0;                      // the tweezers of the last repair that lost their atoms
+    int extraAtoms = 0;                     // the atoms of the last repair that no tweezer held
+    int holesFilled = 0;                    // the holes given a tweezer
+    int repairedPaths = 0;                  // the paths searched again
+
+    size_t capacityBytes() const {
+        return previous.capacityBytes() +
+               (continues.capacity() + holes.capacity() + spares.capacity() + cost.capacity() + matching.capacity() +
+                repair.capacity() + fill.capacity() + order.capacity() + endAt.capacity() + parent.capacity() + queue.capacity() +
+                depth.capacity() + chain.capacity() + shifted.capacity() + savedRows.capacity() + savedCols.capacity()) *
+                   sizeof(int) +
+               repaired.capacity() + keptEnd.capacity() + reachable.capacity() + observed.capacity();
+    }
+};
+
+// replanFrames: repairs a plan from one of its lattice frames, once an image taken there has shown that some atoms were lost and
+// others appeared, and returns the number of lattice frames of the repaired plan (or 0 if it cannot be repaired). The repaired plan
+// starts from the atoms found in that frame and is stored, routed and smoothed, in "trajectories", so that its moves continue the
+// moves of the old plan from that frame on.
+// Only the affected paths are planned again. The tweezers of lost atoms are dropped, every other tweezer keeps the rest of its path,
+// and an extra atom waits where it was found, unless a kept path later passes there: it then takes over the rest of that path, and
+// the tweezer it displaces waits where it was and takes over the next path to pass there, down the queue, so that the last tweezer of
+// the queue is left over instead. The holes left by the lost atoms on the sites they were routed to (the target sites, with a target
+// pattern) are matched to the tweezers left over, and with a target pattern to every tweezer not ending on a target, by a
+// minimum-cost assignment over lattice distances. The paths of the matched tweezers are then searched, nearest first, on a reservation
+// table holding all the others (see searchPath), so that no two tweezers ever share or swap sites; a hole that cannot be reached
+// directly is filled by shifting a chain of tweezers towards it. A hole that neither reaches within maxTime lattice frames is left
+// empty, its tweezer keeping its path. Should the extra atoms keep displacing one another without end, 0 is returned and
+// "trajectories" holds no usable plan: the caller should then route workspace.observed, the occupancy found by the image, from scratch.
+// Inputs:
+//      plan: the plan to repair, as left by generateFrames (or an earlier repair) for an occupancy matrix of the given dimensions
+//      numPlanFrames: the number of lattice frames of the plan
+//      fromFrame: the lattice frame of the plan in which the image was taken (0 being the initial configuration)
+//      delta: a row-major occupancyRows * occupancyCols matrix of AtomChange values; a Lost value on a site no tweezer of the plan
+//             holds in fromFrame, or an Extra value on one a tweezer holds, is ignored
+//      occupancyRows, occupancyCols: the dimensions of the occupancy matrix
+//      trajectories: the store receiving the repaired plan, which must not be "plan"; sized here
+//      N, lattice: the smoothing factor and the lattice the plan was smoothed on
+//      maxTime: the maximum number of lattice frames of the repaired plan
+//      workspace: buffers reused between calls; the repaired plan's tweezer count is trajectories.numTweezers
+//      reservation: the buffers of the reservation table and the search, reused between calls
+//      targetPattern: the target pattern the plan was routed onto (see routeAssignment), or null
+int replanFrames(const TrajectoryStore& plan, int numPlanFrames, int fromFrame, const int8_t* delta, int occupancyRows,
+                 int occupancyCols, TrajectoryStore& trajectories, int N, const LatticeGeometry& lattice, int maxTime,
+                 ReplanWorkspace& workspace, ReservationWorkspace& reservation, const uint8_t* targetPattern = nullptr);
+
+#endif
@@ -0,0 +1,218 @@
+#include "reservation_router.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+// The number of orders (rotations of the group) in which a group of tweezers is replanned before routing stops shortening the plan.
+static const int MAX_GROUP_ORDERS = 8;
+
+void ReservationTable::reset(int numSites, int numFrames) {
+    this->numSites = numSites;
+    this->numFrames = numFrames;
+    holders.assign((size_t)numSites * numFrames, -1);
+}
+
+bool ReservationTable::freeFrom(int site, int frame) const {
+    for (; frame < numFrames; frame++) {
+        if (holders[(size_t)frame * numSites + site] >= 0) return false;
+    }
+    return true;
+}
+
+void ReservationTable::hold(const TrajectoryStore& trajectories, int i, int numCols) {
+    for (int frame = 0; frame < numFrames; frame++) {
+        holders[(size_t)frame * numSites + trajectories.latticeRow(frame, i) * numCols + trajectories.latticeCol(frame, i)] = i;
+    }
+}
+
+void ReservationTable::release(const TrajectoryStore& trajectories, int i, int numCols) {
+    for (int frame = 0; frame < numFrames; frame++) {
+        int& site = holders[(size_t)frame * numSites + trajectories.latticeRow(frame, i) * numCols + trajectories.latticeCol(frame, i)];
+        if (site == i) site = -1;
+    }
+}
+
+int searchPath(int i, int limit, int occupancyRows, int occupancyCols, const LatticeNeighbourhood& neighbourhood,
+               TrajectoryStore& trajectories, ReservationWorkspace& workspace) {
+    const ReservationTable& table = workspace.table;
+    int numSites = occupancyRows * occupancyCols;
+    int numFrames = table.frames();
+    int targetRow = trajectories.latticeRow(numFrames - 1, i), targetCol = trajectories.latticeCol(numFrames - 1, i);
+    int target = targetRow * occupancyCols + targetCol;
+    if (++workspace.stamp == INT_MAX) {
+        std::fill(workspace.searchStamp.begin(), workspace.searchStamp.end(), 0);
+        workspace.stamp = 1;
+    }
+
+    // Every step, waiting included, takes one frame, so the cost of a node is its frame. Among nodes of equal estimated total, the one
+    // furthest along is expanded first. Nodes that cannot arrive before the limit are never queued.
+    std::vector<std::pair<long long, int>>& open = workspace.open;
+    auto push = [&](int node, int parent, int frame, int row, int col) {
+        workspace.searchStamp[node] = workspace.stamp;
+        workspace.searchParent[node] = parent;
+        long long estimate = frame + neighbourhood.distance(targetRow - row, targetCol - col);
+        if (estimate >= limit) return;
+        open.push_back({ estimate * (numFrames + 1) + (numFrames - frame), node });
+        std::push_heap(open.begin(), open.end(), std::greater<std::pair<long long, int>>());
+    };
+    open.clear();
+    int startRow = trajectories.latticeRow(0, i), startCol = trajectories.latticeCol(0, i);
+    push(startRow * occupancyCols + startCol, -1, 0, startRow, startCol);
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<std::pair<long long, int>>());
+        int node = open.back().second;
+        open.pop_back();
+        int frame = node / numSites, site = node % numSites;
+        if (site == target && table.freeFrom(target, frame)) {
+            for (int n = node; n >= 0; n = workspace.searchParent[n]) {
+                trajectories.latticeRow(n / numSites, i) = n % numSites / occupancyCols;
+                trajectories.latticeCol(n / numSites, i) = n % numSites % occupancyCols;
+            }
+            for (int pathFrame = frame + 1; pathFrame < numFrames; pathFrame++) {
+                trajectories.latticeRow(pathFrame, i) = targetRow;
+                trajectories.latticeCol(pathFrame, i) = targetCol;
+            }
+            return frame;
+        }
+
+        int row = site / occupancyCols, col = site % occupancyCols;
+        for (int k = -1; k < neighbourhood.numNeighbours; k++) {
+            int nextRow = k < 0 ? row : row + neighbourhood.offsets[k][0];
+            int nextCol = k < 0 ? col : col + neighbourhood.offsets[k][1];
+            if (nextRow < 0 || nextRow >= occupancyRows || nextCol < 0 || nextCol >= occupancyCols) continue;
+            int next = nextRow * occupancyCols + nextCol;
+            int nextNode = (frame + 1) * numSites + next;
+            if (workspace.searchStamp[nextNode] == workspace.stamp || !table.free(next, frame + 1)) continue;
+            if (k >= 0 && table.swaps(site, next, frame)) continue;
+            push(nextNode, node, frame + 1, nextRow, nextCol);
+        }
+    }
+    return -1;
+}
+
+// collectGroup: fills workspace.group with tweezer i followed by every tweezer holding a site of i's straight path (see
+// LatticeNeighbourhood::shortestSteps) in the frame i would pass it, or the frames just before and after.
+static void collectGroup(int i, int occupancyCols, const LatticeNeighbourhood& neighbourhood, const TrajectoryStore& trajectories,
+                         ReservationWorkspace& workspace) {
+    const ReservationTable& table = workspace.table;
+    int numFrames = table.frames();
+    int targetRow = trajectories.latticeRow(numFrames - 1, i), targetCol = trajectories.latticeCol(numFrames - 1, i);
+    int row = trajectories.latticeRow(0, i), col = trajectories.latticeCol(0, i);
+    workspace.group.assign(1, i);
+    workspace.inGroup[i] = 1;
+    for (int frame = 1; row != targetRow || col != targetCol; frame++) {
+        int steps[2][2];
+        neighbourhood.shortestSteps(targetRow - row, targetCol - col, steps);
+        row += steps[0][0];
+        col += steps[0][1];
+        for (int passing = frame - 1; passing <= frame + 1 && passing < numFrames; passing++) {
+            int holder = table.holder(row * occupancyCols + col, passing);
+            if (holder >= 0 && !workspace.inGroup[holder]) {
+                workspace.inGroup[holder] = 1;
+                workspace.group.push_back(holder);
+            }
+        }
+    }
+    for (int j : workspace.group) workspace.inGroup[j] = 0;
+}
+
+// replanGroup: takes workspace.group out of the table and replans its tweezers one after another, each against the table and those
+// replanned before it, so that all arrive before frame "limit". The order is rotated after each failure. Returns false, with the old
+// paths back in the table, if no order works.
+static bool replanGroup(int limit, int occupancyRows, int occupancyCols, const LatticeNeighbourhood& neighbourhood,
+                        TrajectoryStore& trajectories, ReservationWorkspace& workspace) {
+    ReservationTable& table = workspace.table;
+    int numFrames = table.frames();
+    int size = (int)workspace.group.size();
+    workspace.savedRows.resize((size_t)size * numFrames);
+    workspace.savedCols.resize((size_t)size * numFrames);
+    workspace.groupArrival.resize(size);
+    for (int g = 0; g < size; g++) {
+        int j = workspace.group[g];
+        for (int frame = 0; frame < numFrames; frame++) {
+            workspace.savedRows[(size_t)g * numFrames + frame] = trajectories.latticeRow(frame, j);
+            workspace.savedCols[(size_t)g * numFrames + frame] = trajectories.latticeCol(frame, j);
+        }
+        table.release(trajectories, j, occupancyCols);
+    }
+
+    for (int rotation = 0; rotation < std::min(size, MAX_GROUP_ORDERS); rotation++) {
+        int placed = 0;
+        for (; placed < size; placed++) {
+            int g = (placed + rotation) % size;
+            int arrival = searchPath(workspace.group[g], limit, occupancyRows, occupancyCols, neighbourhood, trajectories, workspace);
+            if (arrival < 0) break;
+            workspace.groupArrival[g] = arrival;
+            table.hold(trajectories, workspace.group[g], occupancyCols);
+        }
+        if (placed == size) {
+            for (int g = 0; g < size; g++) workspace.arrival[workspace.group[g]] = workspace.groupArrival[g];
+            return true;
+        }
+        for (int k = 0; k < placed; k++) table.release(trajectories, workspace.group[(k + rotation) % size], occupancyCols);
+    }
+
+    for (int g = 0; g < size; g++) {
+        int j = workspace.group[g];
+        for (int frame = 0; frame < numFrames; frame++) {
+            trajectories.latticeRow(frame, j) = workspace.savedRows[(size_t)g * numFrames + frame];
+            trajectories.latticeCol(frame, j) = workspace.savedCols[(size_t)g * numFrames + frame];
+        }
+        table.hold(trajectories, j, occupancyCols);
+    }
+    return false;
+}
+
+int routeReservation(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories,
+                     int maxTime, AssignmentWorkspace& assignment, ReservationWorkspace& workspace, LatticeTopology topology,
+                     const uint8_t* targetPattern) {
+    int numFrames = routeAssignment(numTweezers, occupancyRows, occupancyCols, tweezerPositions, trajectories, maxTime, assignment,
+                                    topology, targetPattern);
+    workspace.assignmentFrames = numFrames;
+    workspace.replans = 0;
+    if (numTweezers == 0 || numFrames <= 1) return numFrames;
+    const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+
+    size_t numNodes = (size_t)occupancyRows * occupancyCols * numFrames;
+    if (workspace.searchStamp.size() < numNodes) {
+        workspace.searchStamp.assign(numNodes, 0);
+        workspace.searchParent.resize(numNodes);
+        workspace.stamp = 0;
+    }
+    workspace.inGroup.assign(numTweezers, 0);
+    workspace.arrival.assign(numTweezers, 0);
+    workspace.table.reset(occupancyRows * occupancyCols, numFrames);
+    for (int i = 0; i < numTweezers; i++) {
+        for (int frame = 1; frame < numFrames; frame++) {
+            if (trajectories.latticeRow(frame, i) != trajectories.latticeRow(frame - 1, i) ||
+                trajectories.latticeCol(frame, i) != trajectories.latticeCol(frame - 1, i)) {
+                workspace.arrival[i] = frame;
+            }
+        }
+        workspace.table.hold(trajectories, i, occupancyCols);
+    }
+
+    while (true) {
+        int makespan = *std::max_element(workspace.arrival.begin(), workspace.arrival.end());
+        if (makespan == 0) break;
+        bool shortened = true;
+        for (int i = 0; i < numTweezers && shortened; i++) {
+            if (workspace.arrival[i] != makespan) continue;
+            workspace.table.release(trajectories, i, occupancyCols);
+            int arrival = searchPath(i, makespan, occupancyRows, occupancyCols, neighbourhood, trajectories, workspace);
+            workspace.table.hold(trajectories, i, occupancyCols);
+            if (arrival >= 0) {
+                workspace.arrival[i] = arrival;
+            }
+            else {
+                collectGroup(i, occupancyCols, neighbourhood, trajectories, workspace);
+                shortened = replanGroup(makespan, occupancyRows, occupancyCols, neighbourhood, trajectories, workspace);
+            }
+            if (shortened) workspace.replans++;
+        }
+        if (!shortened) break;
+    }
+    return *std::max_element(workspace.arrival.begin(), workspace.arrival.end()) + 1;
+}
@@ -0,0 +1,107 @@
+#ifndef RESERVATION_ROUTER_H
+#define RESERVATION_ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "assignment_router.h"
+#include "lattice_topology.h"
+#include "trajectory_store.h"
+
+// ReservationTable: which tweezer holds each lattice site in each lattice frame of a plan, so that the path of one tweezer can be
+// searched around the paths of all the others.
+class ReservationTable {
+public:
+    // reset: empties the table for numSites sites over numFrames frames. Memory is only reallocated when the table needs more room.
+    void reset(int numSites, int numFrames);
+
+    // free: whether no tweezer holds site in frame.
+    bool free(int site, int frame) const { return holders[(size_t)frame * numSites + site] < 0; }
+
+    // holder: the tweezer holding site in frame, or -1.
+    int holder(int site, int frame) const { return holders[(size_t)frame * numSites + site]; }
+
+    // freeFrom: whether no tweezer holds site in frame or any later frame, i.e. whether a tweezer arriving there in frame can stay.
+    bool freeFrom(int site, int frame) const;
+
+    // swaps: whether moving from site "from" in frame to site "to" in frame + 1 would swap sites with a tweezer making the opposite move.
+    bool swaps(int from, int to, int frame) const {
+        int other = holders[(size_t)frame * numSites + to];
+        return other >= 0 && holders[(size_t)(frame + 1) * numSites + from] == other;
+    }
+
+    // hold, release: reserves or frees the sites of tweezer i's path, as stored in the lattice stage of trajectories (numCols being the
+    // number of columns of the occupancy matrix).
+    void hold(const TrajectoryStore& trajectories, int i, int numCols);
+    void release(const TrajectoryStore& trajectories, int i, int numCols);
+
+    int frames() const { return numFrames; }
+
+    size_t capacityBytes() const { return holders.capacity() * sizeof(int); }
+
+private:
+    int numSites = 0;
+    int numFrames = 0;
+    std::vector<int> holders;  // the tweezer holding each site in each frame, or -1, frame-major
+};
+
+// ReservationWorkspace: the buffers used by routeReservation besides those of routeAssignment, kept between shots (see FrameContext)
+// so that routing does not allocate once they have been sized.
+struct ReservationWorkspace {
+    ReservationTable table;
+    std::vector<int> arrival;                     // the frame in which each tweezer reaches its last site
+    std::vector<int> group;                       // the tweezers replanned together
+    std::vector<char> inGroup;                    // per tweezer, whether it is in group
+    std::vector<int> groupArrival;                // the new arrival frames of group
+    std::vector<int> savedRows, savedCols;        // the paths of group before replanning, group-major
+    std::vector<int> searchStamp, searchParent;   // per (frame, site) node of the space-time search
+    std::vector<std::pair<long long, int>> open;  // the open list of the space-time search, as a heap of (priority, node)
+    int stamp = 0;
+    int assignmentFrames = 0;                     // the number of lattice frames routeAssignment took for the last shot
+    int replans = 0;                              // the number of tweezers or groups given an earlier arrival in the last shot
+
+    size_t capacityBytes() const {
+        return table.capacityBytes() +
+               (arrival.capacity() + group.capacity() + groupArrival.capacity() + savedRows.capacity() + savedCols.capacity() +
+                searchStamp.capacity() + searchParent.capacity()) *
+                   sizeof(int) +
+               inGroup.capacity() + open.capacity() * sizeof(open[0]);
+    }
+};
+
+// searchPath: finds the path of tweezer i from its first site to its last one (its sites in the first and last frames of the table, as
+// stored in the lattice stage of "trajectories") that arrives soonest, and before frame "limit", through the sites and frames left
+// free by the reservation table, by A* over (site, frame). On success writes the path to the lattice stage of "trajectories" (the
+// tweezer waiting on its last site after arriving) and returns the arrival frame; otherwise returns -1 and leaves the path as it was.
+// The table is not changed, and workspace.searchStamp and searchParent must hold a node for every site in every frame of it.
+int searchPath(int i, int limit, int occupancyRows, int occupancyCols, const LatticeNeighbourhood& neighbourhood,
+               TrajectoryStore& trajectories, ReservationWorkspace& workspace);
+
+// routeReservation: routes every tweezer onto the same sites as routeAssignment (around the center of mass, or those of a target
+// pattern), then shortens the plan by replanning the tweezers that arrive last in space and time, and returns the number of lattice
+// frames (stored in the lattice stage of "trajectories", as routeCenterOfMass does).
+// The plan of routeAssignment is written to a reservation table. Each tweezer arriving in the last frame is then taken out of the
+// table and searched for again by A* over (site, frame) against the paths of all the others (cooperative A*): in every frame it may
+// wait or step to a neighbouring site, but never onto a site held in that frame, never into a swap with another tweezer, and it only
+// finishes on a site it can keep to the end, at least one frame earlier than before. A tweezer that cannot arrive earlier on its own
+// is replanned together with the tweezers holding its straight path, in up to MAX_GROUP_ORDERS orders; if none works, the old paths
+// are put back and routing stops. Otherwise the plan is one frame shorter (the makespan, the arrival of the last tweezer, decreased)
+// and the next tweezers arriving last are taken. Every change keeps the plan free of shared and swapped sites, so the result is never
+// longer than that of routeAssignment, and each tweezer still ends on the same site.
+// Inputs:
+//      numTweezers: the total number of tweezers (i.e. the number of "1" values in tweezerPositions)
+//      occupancyRows, occupancyCols: the dimensions of the occupancy matrix
+//      tweezerPositions: the occupancy matrix, addressed as tweezerPositions[row][col]; updated to the final positions
+//      trajectories: the store receiving the lattice moves, reserved for at least numTweezers tweezers and maxTime frames
+//      maxTime: the maximum number of lattice frames
+//      assignment: the buffers of routeAssignment, reused between calls
+//      workspace: the buffers of the reservation table and the search, reused between calls
+//      topology: the moves a tweezer can make between lattice frames
+//      targetPattern: a target pattern (see routeAssignment), or null
+int routeReservation(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories,
+                     int maxTime, AssignmentWorkspace& assignment, ReservationWorkspace& workspace,
+                     LatticeTopology topology = LatticeTopology::Square, const uint8_t* targetPattern = nullptr);
+
+#endif
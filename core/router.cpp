@@ -0,0 +1,167 @@
+#include "router.h"
+
+#include <algorithm>
+
+// The step code of a site whose moves have not been worked out yet (see stepCode).
+static const uint8_t UNKNOWN_STEPS = 0xFF;
+
+// routeCenterOfMass only steps the active tweezers once fewer than 1 / SPARSE_FRACTION of them moved in the last frame.
+static const int SPARSE_FRACTION = 2;
+
+// stepCode: packs up to two moves, as OccupancyGrid::windowBit + 1, into the low and then the high four bits; 0 means no move.
+static uint8_t stepCode(const int steps[2][2], int numSteps) {
+    uint8_t code = 0;
+    for (int s = numSteps - 1; s >= 0; s--) code = (uint8_t)(code << 4 | (OccupancyGrid::windowBit(steps[s][0], steps[s][1]) + 1));
+    return code;
+}
+
+int routeCenterOfMass(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories,
+                      int maxTime, LatticeTopology topology, CenterOfMassWorkspace* workspace) {
+    CenterOfMassWorkspace temporary;
+    CenterOfMassWorkspace& buffers = workspace ? *workspace : temporary;
+    OccupancyGrid& grid = buffers.occupancy;
+
+    // Populate the first lattice frame with initial positions of tweezers, and compute the center of mass in x- and y- directions, in
+    // one pass over tweezerPositions.
+    long long rowSum = 0, colSum = 0;
+    grid.load(tweezerPositions, occupancyRows, occupancyCols, trajectories, rowSum, colSum);
+    if (numTweezers == 0) return 1;
+    int COM_x = (int)(rowSum / numTweezers);
+    int COM_y = (int)(colSum / numTweezers);
+
+    const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+    std::vector<uint8_t>& steps = buffers.steps;
+    std::vector<int>& atomAt = buffers.atomAt;
+    std::vector<uint64_t>& active = buffers.active;
+    // steps and atomAt are padded by a border site on every side (with no moves and no tweezer), so that the neighbours of an edge site
+    // need no bounds checks; site (row, col) is stored at (row + 1) * paddedCols + col + 1.
+    int paddedCols = occupancyCols + 2;
+    steps.assign((size_t)(occupancyRows + 2) * paddedCols, 0);
+    atomAt.assign((size_t)(occupancyRows + 2) * paddedCols, -1);
+    for (int row = 0; row < occupancyRows; row++) std::fill_n(&steps[(size_t)(row + 1) * paddedCols + 1], occupancyCols, UNKNOWN_STEPS);
+    for (int i = 0; i < numTweezers; i++) {
+        atomAt[(size_t)(trajectories.latticeRow(0, i) + 1) * paddedCols + trajectories.latticeCol(0, i) + 1] = i;
+    }
+    // For each neighbour k of a site: how far back it is stored, and the step code nibble of a move from it into the site.
+    int neighbourDelta[6];
+    unsigned neighbourInto[6];
+    for (int k = 0; k < neighbourhood.numNeighbours; k++) {
+        neighbourDelta[k] = neighbourhood.offsets[k][0] * paddedCols + neighbourhood.offsets[k][1];
+        neighbourInto[k] = (unsigned)OccupancyGrid::windowBit(neighbourhood.offsets[k][0], neighbourhood.offsets[k][1]) + 1;
+    }
+    int numWords = (numTweezers + 63) / 64;
+    active.assign(numWords, ~(uint64_t)0);
+    if (numTweezers % 64 != 0) active[numWords - 1] = ((uint64_t)1 << (numTweezers % 64)) - 1;
+
+    int currentFrame = 0;
+    // stepOne: moves tweezer i one site towards the center of mass if it can, taking the first such move whose site is empty, and
+    // returns the site it vacated (in the padded numbering), or 0 if every move is blocked.
+    auto stepOne = [&](int i) -> size_t {
+        int row = trajectories.latticeRow(currentFrame, i);
+        int col = trajectories.latticeCol(currentFrame, i);
+        size_t site = (size_t)(row + 1) * paddedCols + col + 1;
+        uint8_t& code = steps[site];
+        if (code == UNKNOWN_STEPS) {
+            int shortest[2][2];
+            code = stepCode(shortest, neighbourhood.shortestSteps(COM_y - row, COM_x - col, shortest));
+        }
+        unsigned window = code != 0 ? grid.window(row, col) : 0;
+        for (unsigned moves = code; moves != 0; moves >>= 4) {
+            int move = (int)(moves & 15) - 1;
+            if ((window >> move) & 1) continue;
+            int nextRow = row + move / 3 - 1;
+            int nextCol = col + move % 3 - 1;
+            trajectories.latticeRow(currentFrame + 1, i) = nextRow;
+            trajectories.latticeCol(currentFrame + 1, i) = nextCol;
+            grid.move(row, col, nextRow, nextCol);
+            atomAt[site] = -1;
+            atomAt[site + (move / 3 - 1) * paddedCols + move % 3 - 1] = i;
+            return site;
+        }
+        return 0;
+    };
+
+    // While most tweezers move in every frame, they are all stepped in turn; once few do, only the active ones are.
+    bool sparse = false;
+    // The store holds maxTime lattice frames, so routing stops once the last one has been filled.
+    while (currentFrame + 1 < maxTime) {
+        // Every tweezer stays where it is unless it moves below.
+        std::copy_n(&trajectories.latticeRow(currentFrame, 0), numTweezers, &trajectories.latticeRow(currentFrame + 1, 0));
+        std::copy_n(&trajectories.latticeCol(currentFrame, 0), numTweezers, &trajectories.latticeCol(currentFrame + 1, 0));
+        int numMoves = 0;
+        if (!sparse) {
+            for (int i = 0; i < numTweezers; i++) numMoves += stepOne(i) != 0;
+        }
+        for (int w = 0; sparse && w < numWords; w++) {
+            // A move can wake tweezers further on in the same word, so the word is read again after every tweezer.
+            for (int bit = 0; bit < 64;) {
+                uint64_t pending = active[w] >> bit << bit;
+                if (pending == 0) break;
+                bit = lowestBit64(pending);
+                int i = w * 64 + bit++;
+                size_t vacated = stepOne(i);
+                if (vacated == 0) {
+                    active[w] &= ~((uint64_t)1 << (i & 63));
+                    continue;
+                }
+                numMoves++;
+                // Wake the tweezers next to the vacated site that would step into it.
+                for (int k = 0; k < neighbourhood.numNeighbours; k++) {
+                    size_t from = vacated - neighbourDelta[k];
+                    int j = atomAt[from];
+                    if (j >= 0 && ((steps[from] & 15) == neighbourInto[k] || steps[from] >> 4 == neighbourInto[k])) {
+                        active[j >> 6] |= (uint64_t)1 << (j & 63);
+                    }
+                }
+            }
+        }
+        if (numMoves == 0) break;
+        // The active set starts out holding every tweezer, which is never too few.
+        if (numMoves * SPARSE_FRACTION < numTweezers) sparse = true;
+        currentFrame++;
+    }
+
+    // Leave the final positions in tweezerPositions.
+    for (int i = 0; i < numTweezers; i++) tweezerPositions[trajectories.latticeRow(0, i)][trajectories.latticeCol(0, i)] = 0;
+    for (int i = 0; i < numTweezers; i++) {
+        tweezerPositions[trajectories.latticeRow(currentFrame, i)][trajectories.latticeCol(currentFrame, i)] = 1;
+    }
+    return currentFrame + 1;
+}
+
+int generateFrames(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories, int N,
+                   const LatticeGeometry& lattice, int maxTime, RoutingMethod method, AssignmentWorkspace* workspace,
+                   ReservationWorkspace* reservation, CenterOfMassWorkspace* centerOfMass, const uint8_t* targetPattern) {
+    trajectories.reserve(numTweezers, N, maxTime);
+    int numFrames = 0;
+    if (method == RoutingMethod::Reservation) {
+        AssignmentWorkspace temporary;
+        ReservationWorkspace temporaryReservation;
+        numFrames = routeReservation(numTweezers, occupancyRows, occupancyCols, tweezerPositions, trajectories, maxTime,
+                                     workspace ? *workspace : temporary, reservation ? *reservation : temporaryReservation,
+                                     lattice.topology, targetPattern);
+    }
+    else if (method == RoutingMethod::Assignment || targetPattern != nullptr) {
+        AssignmentWorkspace temporary;
+        numFrames = routeAssignment(numTweezers, occupancyRows, occupancyCols, tweezerPositions, trajectories, maxTime,
+                                    workspace ? *workspace : temporary, lattice.topology, targetPattern);
+    }
+    else {
+        numFrames = routeCenterOfMass(numTweezers, occupancyRows, occupancyCols, tweezerPositions, trajectories, maxTime,
+                                      lattice.topology, centerOfMass);
+    }
+    smoothTrajectories(trajectories, numTweezers, numFrames, occupancyRows, occupancyCols, N, lattice);
+    return numFrames;
+}
+
+long long countLatticeMoves(TrajectoryStore& trajectories, int numTweezers, int numFrames, LatticeTopology topology) {
+    const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+    long long moves = 0;
+    for (int frame = 1; frame < numFrames; frame++) {
+        for (int i = 0; i < numTweezers; i++) {
+            moves += neighbourhood.distance(trajectories.latticeRow(frame, i) - trajectories.latticeRow(frame - 1, i),
+                                            trajectories.latticeCol(frame, i) - trajectories.latticeCol(frame - 1, i));
+        }
+    }
+    return moves;
+}
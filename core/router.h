@@ -0,0 +1,84 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assignment_router.h"
+#include "occupancy_grid.h"
+#include "reservation_router.h"
+#include "trajectory_smoothing.h"
+#include "trajectory_store.h"
+
+// RoutingMethod: how generateFrames routes the tweezers.
+enum class RoutingMethod {
+    CenterOfMass = 0,    // step every tweezer greedily towards the center of mass (routeCenterOfMass)
+    Assignment = 1,      // fill the sites closest to the center of mass by a minimum-cost assignment (routeAssignment)
+    Reservation = 2      // as Assignment, then shorten the plan by space-time search on a reservation table (routeReservation)
+};
+
+// CenterOfMassWorkspace: the buffers used by routeCenterOfMass, kept between shots (see FrameContext) so that routing does not allocate
+// once they have been sized.
+struct CenterOfMassWorkspace {
+    OccupancyGrid occupancy;
+    std::vector<uint8_t> steps;    // per site, the moves that begin a shortest path to the center of mass, packed as window bits
+    std::vector<int> atomAt;       // the tweezer on each site, or -1
+    std::vector<uint64_t> active;  // one bit per tweezer, set while it may be able to move
+
+    size_t capacityBytes() const {
+        return occupancy.capacityBytes() + steps.capacity() + atomAt.capacity() * sizeof(int) + active.capacity() * sizeof(uint64_t);
+    }
+};
+
+// routeCenterOfMass: routes every tweezer towards the center of mass of the occupancy matrix, one lattice site per frame, and returns
+// the number of lattice frames (stored in the lattice stage of "trajectories"). Each tweezer first takes the move that leaves the most
+// even remainder towards the center of mass (on a square lattice, the move along the axis on which it is further from the center of
+// mass), and falls back to the other move on a shortest path when that site is occupied. Routing stops once no tweezer can move, or
+// once maxTime lattice frames have been filled.
+// The occupancy is kept in an OccupancyGrid, loaded together with the first frame and the center of mass in a single scan. As the center
+// of mass does not move, the moves from a site are worked out the first time a tweezer stands on it and then reused, so that each step
+// only gathers the 3 x 3 block of bits around the tweezer and tests the bits of its moves. Once fewer than half the tweezers moved in a
+// frame, a tweezer whose moves are all blocked is not looked at again until a neighbouring site it would step into is vacated: the
+// tweezers that may move are kept as a bitset, walked a word at a time in tweezer order, which moves them exactly as a full pass over
+// all the tweezers would.
+// Inputs:
+//      numTweezers: the total number of tweezers (i.e. the number of "1" values in tweezerPositions)
+//      occupancyRows, occupancyCols: the dimensions of the occupancy matrix
+//      tweezerPositions: the occupancy matrix, addressed as tweezerPositions[row][col]; updated in place as the tweezers move
+//      trajectories: the store receiving the lattice moves, reserved for at least numTweezers tweezers and maxTime frames
+//      maxTime: the maximum number of lattice frames
+//      topology: the moves a tweezer can make between lattice frames
+//      workspace: buffers reused between calls, or null to use temporary ones
+int routeCenterOfMass(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories,
+                      int maxTime, LatticeTopology topology = LatticeTopology::Square, CenterOfMassWorkspace* workspace = nullptr);
+
+// generateFrames: Generates binary frames (stored in the moves stage of "trajectories") and returns the total number generated.
+// Inputs:
+//      numTweezers: the total number of tweezers for which moves are to be computed
+//      occupancyRows: the number of rows in the occupancy matrix (i.e. the height of the lattice, in sites)
+//      occupancyCols: the number of columns in the occupancy matrix (i.e. the width of the lattice, in sites)
+//      tweezerPositions: a 2D matrix consisting of the initial positions of the tweezers (i.e. the occupancy matrix)
+//      trajectories: a reusable store holding the series of tweezer moves in lattice space, in DMD space, and the final series of
+//                    moves in DMD space (i.e. a smoothed version of the DMD-space moves); it is sized here for numTweezers and N
+//      N: the smoothing factor, or the number of frames to generate to smooth between consecutive lattice sites
+//      lattice: the lattice coordinate system in DMD space, whose topology the tweezers are routed on
+//      maxTime: the maximum number of lattice frames
+//      method: the routing method
+//      workspace: buffers for RoutingMethod::Assignment and Reservation, reused between calls (see FrameContext), or null to use
+//                 temporary ones
+//      reservation: buffers for RoutingMethod::Reservation, reused between calls, or null to use temporary ones
+//      centerOfMass: buffers for RoutingMethod::CenterOfMass, reused between calls, or null to use temporary ones
+//      targetPattern: a row-major occupancyRows * occupancyCols matrix of TargetSite values to route the tweezers onto instead of the
+//                     center of mass, or null; as it is filled by assignment, RoutingMethod::CenterOfMass routes as Assignment with it
+int generateFrames(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, TrajectoryStore& trajectories, int N,
+                   const LatticeGeometry& lattice, int maxTime, RoutingMethod method = RoutingMethod::CenterOfMass,
+                   AssignmentWorkspace* workspace = nullptr, ReservationWorkspace* reservation = nullptr,
+                   CenterOfMassWorkspace* centerOfMass = nullptr, const uint8_t* targetPattern = nullptr);
+
+// countLatticeMoves: the total number of single-site steps taken by the tweezers over the first numFrames lattice frames, on a lattice
+// of the given topology.
+long long countLatticeMoves(TrajectoryStore& trajectories, int numTweezers, int numFrames,
+                            LatticeTopology topology = LatticeTopology::Square);
+
+#endif
@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int numThreads) {
+    resize(numThreads);
+}
+
+ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+void ThreadPool::resize(int numThreads) {
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads == size()) return;
+    stopWorkers();
+    stopping = false;
+    for (int i = 1; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, generation);
+    }
+}
+
+void ThreadPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+}
+
+void ThreadPool::run(int count, TaskFunction function, void* context) {
+    if (workers.empty() || count <= 1) {
+        for (int i = 0; i < count; i++) function(context, i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->function = function;
+        this->context = context;
+        this->count = count;
+        nextTask.store(0, std::memory_order_relaxed);
+        busyWorkers = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    work();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void ThreadPool::work() {
+    while (true) {
+        int i = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (i >= count) return;
+        function(context, i);
+    }
+}
+
+void ThreadPool::workerLoop(long long seenGeneration) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        work();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        done.notify_one();
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ThreadPool: a fixed set of threads for splitting one piece of work into independent tasks.
+// parallelFor() hands out task indices from a shared counter, so faster threads simply take more tasks, and the calling thread works
+// alongside the pool until every task is done. Only one parallelFor() may run at a time.
+class ThreadPool {
+public:
+    // numThreads: the total number of threads working on a parallelFor(), including the caller.
+    explicit ThreadPool(int numThreads = 1);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // resize: changes the number of threads. Must not be called while a parallelFor() is running.
+    void resize(int numThreads);
+
+    int size() const { return (int)workers.size() + 1; }
+
+    // parallelFor: calls task(i) for every i in [0, count) and returns once all calls have finished.
+    template <typename Task>
+    void parallelFor(int count, Task&& task) {
+        run(count, [](void* context, int i) { (*static_cast<typename std::remove_reference<Task>::type*>(context))(i); }, &task);
+    }
+
+private:
+    typedef void (*TaskFunction)(void* context, int i);
+
+    void run(int count, TaskFunction function, void* context);
+    void work();
+    void workerLoop(long long seenGeneration);
+    void stopWorkers();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    long long generation = 0;
+    int busyWorkers = 0;
+    bool stopping = false;
+
+    TaskFunction function = nullptr;
+    void* context = nullptr;
+    int count = 0;
+    std::atomic<int> nextTask{ 0 };
+};
+
+#endif
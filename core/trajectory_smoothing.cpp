@@ -0,0 +1,34 @@
+#include "trajectory_smoothing.h"
+
+int smoothTrajectories(TrajectoryStore& trajectories, int numTweezers, int numFrames, int occupancyRows, int occupancyCols, int N,
+                       const LatticeGeometry& lattice) {
+    for (int j = 0; j < numFrames; j++) {
+        for (int i = 0; i < numTweezers; i++) {
+            int& row = trajectories.latticeRow(j, i);
+            int& col = trajectories.latticeCol(j, i);
+            row -= occupancyRows / 2;
+            col -= occupancyCols / 2;
+            trajectories.dmdX(j, i) = lattice.centerX + (row * lattice.vec1X) + (col * lattice.vec2X);
+            trajectories.dmdY(j, i) = lattice.centerY + (row * lattice.vec1Y) + (col * lattice.vec2Y);
+        }
+    }
+
+    for (int j = 0; j < numFrames - 1; j++) {
+        for (int i = 0; i < numTweezers; i++) {
+            float startX = trajectories.dmdX(j, i);
+            float startY = trajectories.dmdY(j, i);
+            float xDif = (trajectories.dmdX(j + 1, i) - startX) / (float)N;
+            float yDif = (trajectories.dmdY(j + 1, i) - startY) / (float)N;
+            for (int k = 0; k < N; k++) {
+                trajectories.moveX(j * N + k, i) = startX + xDif * k;
+                trajectories.moveY(j * N + k, i) = startY + yDif * k;
+            }
+        }
+    }
+    for (int i = 0; i < numTweezers; i++) {
+        trajectories.moveX((numFrames - 1) * N, i) = trajectories.dmdX(numFrames - 1, i);
+        trajectories.moveY((numFrames - 1) * N, i) = trajectories.dmdY(numFrames - 1, i);
+    }
+
+    return N * (numFrames - 1) + 1;
+}
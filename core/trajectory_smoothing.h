@@ -0,0 +1,31 @@
+#ifndef TRAJECTORY_SMOOTHING_H
+#define TRAJECTORY_SMOOTHING_H
+
+#include "lattice_topology.h"
+#include "trajectory_store.h"
+
+// LatticeGeometry: the lattice coordinate system in DMD space. Site (row, col), counted from the center of the occupancy matrix, lies
+// at center + row * vec1 + col * vec2.
+struct LatticeGeometry {
+    LatticeTopology topology = LatticeTopology::Square;   // the moves the routers may make between lattice frames
+    float vec1X = 0.0f;
+    float vec1Y = 0.0f;
+    float vec2X = 0.0f;
+    float vec2Y = 0.0f;
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+};
+
+// smoothTrajectories: converts the routed lattice moves into DMD space and interpolates N smoothed moves between consecutive lattice
+// frames. Returns the number of smoothed moves, N * (numFrames - 1) + 1.
+// Inputs:
+//      trajectories: the store holding the routed lattice moves (see routeCenterOfMass); the lattice stage is recentered in place
+//      numTweezers: the number of tweezers that were routed
+//      numFrames: the number of lattice frames that were routed
+//      occupancyRows, occupancyCols: the dimensions of the occupancy matrix
+//      N: the smoothing factor, or the number of frames to generate to smooth between consecutive lattice sites
+//      lattice: the lattice coordinate system in DMD space
+int smoothTrajectories(TrajectoryStore& trajectories, int numTweezers, int numFrames, int occupancyRows, int occupancyCols, int N,
+                       const LatticeGeometry& lattice);
+
+#endif
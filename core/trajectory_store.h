@@ -0,0 +1,84 @@
+#ifndef TRAJECTORY_STORE_H
+#define TRAJECTORY_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// TrajectoryStore: contiguous storage for the three stages of a rearrangement (lattice moves, DMD-space moves and smoothed moves).
+// Each stage is kept as a structure of arrays (one block of x values and one block of y values), laid out frame-major so that the
+// positions of every tweezer in a given frame are adjacent in memory:
+//      stage[frame * numTweezers + tweezer]
+// Buffers only ever grow, so once the store has been sized for the largest load it is reused between calls without allocating.
+class TrajectoryStore {
+public:
+    // reserve: sizes the store for the given number of tweezers, smoothing factor and maximum number of lattice moves.
+    // Memory is only reallocated when one of the stages needs more room than it currently has.
+    void reserve(int numTweezers, int N, int maxTime) {
+        this->numTweezers = numTweezers;
+        this->N = N;
+        this->maxTime = maxTime;
+
+        grow(latticeRows, (size_t)numTweezers * maxTime);
+        grow(latticeCols, (size_t)numTweezers * maxTime);
+        grow(dmdXs, (size_t)numTweezers * maxTime);
+        grow(dmdYs, (size_t)numTweezers * maxTime);
+        grow(moveXs, (size_t)numTweezers * maxMoveFrames());
+        grow(moveYs, (size_t)numTweezers * maxMoveFrames());
+    }
+
+    // copyFrom: sizes the store for the tweezers and smoothing factor of other and numFrames lattice frames, and copies the first
+    // numFrames lattice frames of other with the smoothed moves between them.
+    void copyFrom(const TrajectoryStore& other, int numFrames) {
+        reserve(other.numTweezers, other.N, numFrames);
+        size_t sites = (size_t)numTweezers * numFrames;
+        size_t moves = (size_t)numTweezers * maxMoveFrames();
+        std::copy_n(other.latticeRows.begin(), sites, latticeRows.begin());
+        std::copy_n(other.latticeCols.begin(), sites, latticeCols.begin());
+        std::copy_n(other.dmdXs.begin(), sites, dmdXs.begin());
+        std::copy_n(other.dmdYs.begin(), sites, dmdYs.begin());
+        std::copy_n(other.moveXs.begin(), moves, moveXs.begin());
+        std::copy_n(other.moveYs.begin(), moves, moveYs.begin());
+    }
+
+    // maxMoveFrames: the number of smoothed frames that fit in the store for the current smoothing factor.
+    int maxMoveFrames() const { return N * (maxTime - 1) + 1; }
+
+    // Lattice-space positions (row and column of the occupied site).
+    int& latticeRow(int frame, int tweezer) { return latticeRows[(size_t)frame * numTweezers + tweezer]; }
+    int& latticeCol(int frame, int tweezer) { return latticeCols[(size_t)frame * numTweezers + tweezer]; }
+    int latticeRow(int frame, int tweezer) const { return latticeRows[(size_t)frame * numTweezers + tweezer]; }
+    int latticeCol(int frame, int tweezer) const { return latticeCols[(size_t)frame * numTweezers + tweezer]; }
+
+    // DMD-space positions of the lattice sites visited by each tweezer.
+    float& dmdX(int frame, int tweezer) { return dmdXs[(size_t)frame * numTweezers + tweezer]; }
+    float& dmdY(int frame, int tweezer) { return dmdYs[(size_t)frame * numTweezers + tweezer]; }
+
+    // Smoothed DMD-space positions; moveX/moveY return the start of a frame, i.e. the positions of all tweezers in that frame.
+    float& moveX(int frame, int tweezer) { return moveXs[(size_t)frame * numTweezers + tweezer]; }
+    float& moveY(int frame, int tweezer) { return moveYs[(size_t)frame * numTweezers + tweezer]; }
+    const float* moveX(int frame) const { return moveXs.data() + (size_t)frame * numTweezers; }
+    const float* moveY(int frame) const { return moveYs.data() + (size_t)frame * numTweezers; }
+
+    // capacityBytes: the total amount of memory currently held by the store.
+    size_t capacityBytes() const {
+        return (latticeRows.capacity() + latticeCols.capacity()) * sizeof(int) +
+               (dmdXs.capacity() + dmdYs.capacity() + moveXs.capacity() + moveYs.capacity()) * sizeof(float);
+    }
+
+    int numTweezers = 0;
+    int N = 0;
+    int maxTime = 0;
+
+private:
+    template <typename T>
+    static void grow(std::vector<T>& buffer, size_t size) {
+        if (buffer.size() < size) buffer.resize(size);
+    }
+
+    std::vector<int> latticeRows, latticeCols;
+    std::vector<float> dmdXs, dmdYs;
+    std::vector<float> moveXs, moveYs;
+};
+
+#endif
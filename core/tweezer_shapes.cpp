@@ -0,0 +1,116 @@
+#include "tweezer_shapes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+void TweezerShapeRegistry::setPattern(const int (*offsets)[2], int count) {
+    patternOffsets.assign(&offsets[0][0], &offsets[0][0] + 2 * count);
+    // Drop any stamp compiled from a previous pattern.
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].shape == TweezerShape::Pattern) {
+            entries.erase(entries.begin() + i);
+            break;
+        }
+    }
+}
+
+const TweezerStamp& TweezerShapeRegistry::get(const TweezerShapeSpec& spec) {
+    // Only the fields that affect a shape take part in the lookup.
+    bool sized = spec.shape != TweezerShape::Pattern && spec.shape != TweezerShape::Custom;
+    int size = sized ? spec.size : 0;
+    float parameter = spec.shape == TweezerShape::Gaussian ? spec.parameter : 0.0f;
+    uint64_t maskHash = spec.shape == TweezerShape::Custom ? hashMask(spec) : 0;
+    int maskRows = spec.shape == TweezerShape::Custom ? spec.maskRows : 0;
+    int maskCols = spec.shape == TweezerShape::Custom ? spec.maskCols : 0;
+
+    // sameMask: whether a custom mask matches the one kept in an entry, pixel for pixel (two masks can share a hash).
+    auto sameMask = [&](const Entry& entry) {
+        for (size_t i = 0; i < entry.mask.size(); i++) {
+            if (entry.mask[i] != (spec.mask[i] != 0)) return false;
+        }
+        return true;
+    };
+    useClock++;
+    for (Entry& entry : entries) {
+        if (entry.shape == spec.shape && entry.size == size && entry.parameter == parameter && entry.maskHash == maskHash &&
+            entry.maskRows == maskRows && entry.maskCols == maskCols && sameMask(entry)) {
+            entry.lastUsed = useClock;
+            return entry.stamp;
+        }
+    }
+
+    // A full registry compiles over its least recently used stamp, reusing its buffers.
+    Entry* entry = nullptr;
+    if (entries.size() < MAX_ENTRIES) {
+        entries.emplace_back();
+        entry = &entries.back();
+    }
+    else {
+        entry = &*std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+    }
+    entry->shape = spec.shape;
+    entry->size = size;
+    entry->parameter = parameter;
+    entry->maskHash = maskHash;
+    entry->maskRows = maskRows;
+    entry->maskCols = maskCols;
+    entry->mask.resize((size_t)maskRows * maskCols);
+    for (size_t i = 0; i < entry->mask.size(); i++) entry->mask[i] = spec.mask[i] != 0;
+    entry->lastUsed = useClock;
+    compile(spec, entry->stamp);
+    return entry->stamp;
+}
+
+// hashMask: FNV-1a over the dimensions and contents of a custom mask.
+uint64_t TweezerShapeRegistry::hashMask(const TweezerShapeSpec& spec) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    mix((uint64_t)spec.maskRows);
+    mix((uint64_t)spec.maskCols);
+    for (int i = 0; i < spec.maskRows * spec.maskCols; i++) {
+        mix(spec.mask[i] != 0);
+    }
+    return hash;
+}
+
+void TweezerShapeRegistry::compile(const TweezerShapeSpec& spec, TweezerStamp& stamp) {
+    int r = spec.size;
+    double threshold = 0.0;
+    if (spec.shape == TweezerShape::Gaussian) {
+        // Pixels are kept where exp(-d^2 / (2 sigma^2)) >= threshold, i.e. within sigma * sqrt(-2 ln(threshold)) of the center.
+        threshold = std::min(std::max((double)spec.parameter, 1e-6), 1.0);
+        r = (int)std::floor(spec.size * std::sqrt(-2.0 * std::log(threshold)));
+    }
+    int side = 2 * r + 1;
+    switch (spec.shape) {
+    case TweezerShape::Square:
+        stamp.makeSquare(r);
+        return;
+    case TweezerShape::Pattern:
+        stamp.makeFromOffsets(reinterpret_cast<const int (*)[2]>(patternOffsets.data()), (int)patternOffsets.size() / 2);
+        return;
+    case TweezerShape::Custom:
+        stamp.makeFromMask(spec.mask, spec.maskRows, spec.maskCols);
+        return;
+    case TweezerShape::Diamond:
+    case TweezerShape::Disc:
+    case TweezerShape::Gaussian:
+        break;
+    }
+
+    scratchMask.assign((size_t)side * side, 0);
+    for (int dx = -r; dx <= r; dx++) {
+        for (int dy = -r; dy <= r; dy++) {
+            bool covered;
+            if (spec.shape == TweezerShape::Diamond) covered = abs(dx) + abs(dy) <= r;
+            else if (spec.shape == TweezerShape::Disc) covered = dx * dx + dy * dy <= r * r;
+            else covered = spec.size > 0 ? std::exp(-(dx * dx + dy * dy) / (2.0 * spec.size * spec.size)) >= threshold : dx == 0 && dy == 0;
+            scratchMask[(size_t)(dx + r) * side + (dy + r)] = covered;
+        }
+    }
+    stamp.makeFromMask(scratchMask.data(), side, side);
+}
@@ -0,0 +1,67 @@
+#ifndef TWEEZER_SHAPES_H
+#define TWEEZER_SHAPES_H
+
+#include <cstdint>
+#include <vector>
+
+#include "tweezer_stamp.h"
+
+// TweezerShape: the shapes that can be drawn for a tweezer. The numeric values are the codes accepted from MATLAB.
+enum class TweezerShape {
+    Square = 0,     // every pixel within size of the center in both directions
+    Diamond = 1,    // every pixel within a Manhattan distance of size of the center
+    Disc = 2,       // every pixel within a Euclidean distance of size of the center
+    Gaussian = 3,   // every pixel where a Gaussian spot of width size is at least parameter times its peak
+    Pattern = 4,    // the fixed offset list TWEEZER_PATTERN
+    Custom = 5      // a user-supplied mask, centered on the tweezer
+};
+
+// TweezerShapeSpec: a complete description of a tweezer shape.
+struct TweezerShapeSpec {
+    TweezerShape shape = TweezerShape::Square;
+    int size = 0;               // half-width, radius or Gaussian sigma, in pixels
+    float parameter = 0.0f;     // Gaussian threshold, as a fraction of the peak
+    // Custom masks: maskRows * maskCols values, row-major, nonzero where the tweezer is drawn.
+    const uint8_t* mask = nullptr;
+    int maskRows = 0;
+    int maskCols = 0;
+};
+
+// TweezerShapeRegistry: compiles each requested shape into a TweezerStamp the first time it is seen and keeps it, so choosing a shape
+// on later calls is a lookup with no shape evaluation and no allocation. At most MAX_ENTRIES stamps are kept: beyond that, the least
+// recently used one is compiled over, so that a session sweeping Gaussian parameters or custom masks does not grow without bound.
+class TweezerShapeRegistry {
+public:
+    static constexpr size_t MAX_ENTRIES = 16;
+
+    // setPattern: sets the offset list used for TweezerShape::Pattern.
+    void setPattern(const int (*offsets)[2], int count);
+
+    // get: returns the compiled stamp for the given shape. The reference stays valid until the next call to get() or setPattern().
+    const TweezerStamp& get(const TweezerShapeSpec& spec);
+
+    // size: the number of compiled stamps held by the registry.
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        TweezerShape shape;
+        int size;
+        float parameter;
+        uint64_t maskHash;
+        int maskRows, maskCols;
+        std::vector<uint8_t> mask;      // a custom mask, as 0 or 1 per pixel, compared in full once the hash matches
+        uint64_t lastUsed;
+        TweezerStamp stamp;
+    };
+
+    static uint64_t hashMask(const TweezerShapeSpec& spec);
+    void compile(const TweezerShapeSpec& spec, TweezerStamp& stamp);
+
+    std::vector<Entry> entries;
+    uint64_t useClock = 0;
+    std::vector<int> patternOffsets;
+    std::vector<uint8_t> scratchMask;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "tweezer_stamp.h"
+
+#include <algorithm>
+
+void TweezerStamp::makeSquare(int halfWidth) {
+    spans.clear();
+    for (int row = -halfWidth; row <= halfWidth; row++) {
+        spans.push_back({ row, -halfWidth, halfWidth + 1 });
+    }
+    updateBounds();
+}
+
+void TweezerStamp::makeFromOffsets(const int (*offsets)[2], int count) {
+    spans.clear();
+    for (int i = 0; i < count; i++) {
+        spans.push_back({ offsets[i][0], offsets[i][1], offsets[i][1] + 1 });
+    }
+
+    // Sort the single-pixel spans by row and column, then merge neighbouring pixels of the same row into longer spans.
+    std::sort(spans.begin(), spans.end(), [](const StampSpan& a, const StampSpan& b) {
+        return a.row != b.row ? a.row < b.row : a.colBegin < b.colBegin;
+    });
+    size_t merged = 0;
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (merged > 0 && spans[merged - 1].row == spans[i].row && spans[merged - 1].colEnd >= spans[i].colBegin) {
+            spans[merged - 1].colEnd = std::max(spans[merged - 1].colEnd, spans[i].colEnd);
+        }
+        else {
+            spans[merged++] = spans[i];
+        }
+    }
+    spans.resize(merged);
+    updateBounds();
+}
+
+void TweezerStamp::makeFromMask(const uint8_t* mask, int rows, int cols) {
+    spans.clear();
+    for (int i = 0; i < rows; i++) {
+        int j = 0;
+        while (j < cols) {
+            if (!mask[(size_t)i * cols + j]) {
+                j++;
+                continue;
+            }
+            int begin = j;
+            while (j < cols && mask[(size_t)i * cols + j]) j++;
+            spans.push_back({ i - rows / 2, begin - cols / 2, j - cols / 2 });
+        }
+    }
+    updateBounds();
+}
+
+void TweezerStamp::updateBounds() {
+    if (spans.empty()) {
+        rowMin = 0;
+        rowMax = -1;
+        colMin = 0;
+        colMax = 0;
+        return;
+    }
+    rowMin = spans.front().row;
+    rowMax = spans.front().row;
+    colMin = spans.front().colBegin;
+    colMax = spans.front().colEnd;
+    for (const StampSpan& span : spans) {
+        rowMin = std::min(rowMin, span.row);
+        rowMax = std::max(rowMax, span.row);
+        colMin = std::min(colMin, span.colBegin);
+        colMax = std::max(colMax, span.colEnd);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef TWEEZER_STAMP_H
+#define TWEEZER_STAMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// StampSpan: one horizontal run of pixels of a tweezer shape, given as offsets from the tweezer center.
+struct StampSpan {
+    int row;        // row offset
+    int colBegin;   // first column offset
+    int colEnd;     // one past the last column offset
+};
+
+// TweezerStamp: a tweezer shape stored as horizontal spans, so that drawing a tweezer costs one clip and one run of stores per row
+// of the shape regardless of how the shape was described.
+class TweezerStamp {
+public:
+    // makeSquare: a square covering every pixel within halfWidth of the center in both directions (the shape set by tweezerSize).
+    void makeSquare(int halfWidth);
+
+    // makeFromOffsets: a shape given as a list of {row, column} deviations from the center, such as TWEEZER_PATTERN.
+    void makeFromOffsets(const int (*offsets)[2], int count);
+
+    // makeFromMask: a shape given as a rows x cols mask (row-major, nonzero where the tweezer is drawn) centered on the tweezer.
+    void makeFromMask(const uint8_t* mask, int rows, int cols);
+
+    // draw: ORs mask into every pixel of the shape centered on (x, y), clipped to rows [rowBegin, rowEnd) and columns [0, width).
+    void draw(uint32_t* frame, int width, int rowBegin, int rowEnd, int x, int y, uint32_t mask) const {
+        if (x + rowMax < rowBegin || x + rowMin >= rowEnd || y + colMax <= 0 || y + colMin >= width) return;
+        bool inside = x + rowMin >= rowBegin && x + rowMax < rowEnd && y + colMin >= 0 && y + colMax <= width;
+        for (const StampSpan& span : spans) {
+            int row = x + span.row;
+            int colBegin = y + span.colBegin;
+            int colEnd = y + span.colEnd;
+            if (!inside) {
+                if (row < rowBegin || row >= rowEnd) continue;
+                if (colBegin < 0) colBegin = 0;
+                if (colEnd > width) colEnd = width;
+            }
+            uint32_t* pixels = frame + (size_t)row * width;
+            for (int col = colBegin; col < colEnd; col++) {
+                pixels[col] |= mask;
+            }
+        }
+    }
+
+    std::vector<StampSpan> spans;
+    // Bounding box of the shape: rows rowMin..rowMax and columns colMin..colMax - 1 relative to the center.
+    int rowMin = 0, rowMax = -1;
+    int colMin = 0, colMax = 0;
+
+private:
+    void updateBounds();
+};
+
+#endif
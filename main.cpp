@@ -1,4 +1,6 @@
-/* To compile: mex -O main.cpp glad.c glfw3.lib -IC:\Users\qmspc\documents\MATLAB\DMD\Externals\include -LC:\Users\qmspc\documents\MATLAB\DMD\Externals\lib
+/* To compile: mex -O main.cpp core/router.cpp core/assignment.cpp core/assignment_router.cpp core/lattice_topology.cpp core/occupancy_grid.cpp core/plan_cache.cpp core/replan_router.cpp core/reservation_router.cpp core/trajectory_smoothing.cpp core/dmd_remap.cpp core/bitplane_rasterizer.cpp core/tweezer_stamp.cpp core/tweezer_shapes.cpp core/frame_pacing.cpp core/frame_pipeline.cpp core/latency_trace.cpp core/thread_pool.cpp render/gl_extensions.cpp render/texture_uploader.cpp render/gpu_rasterizer.cpp render/presentation_monitor.cpp render/frame_capture.cpp render/glfw_backend.cpp render/egl_backend.cpp render/dmd_renderer.cpp glad.c glfw3.lib -IC:\Users\qmspc\documents\MATLAB\DMD\Externals\include -LC:\Users\qmspc\documents\MATLAB\DMD\Externals\lib
+   On Linux, or with MATLAB on the CMake path, the MEX function can also be built with CMake (see CMakeLists.txt), along with the
+standalone command-line driver in cli/.
    To invoke: after compiling, run the testing script, and then call main repeatedly with apporpriate arguments (ex: main(200, 20, 20, array, 3, 50, 8.66, 5, 8.66, -5, 570, 456, 1)). Note that init
 should be set to 1 for the first call to main() and to 0 for all subsequent calls. The first call will initialize the window and not dipslay any frames.
    To halt: run the "clear mex" command; this will close the window. */
@@ -6,29 +8,18 @@ should be set to 1 for the first call to main() and to 0 for all subsequent call
 #include "mex.hpp"
 #include "mexAdapter.hpp"
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <shader_s.h>
+#include <chrono>
+#include <cmath>
 #include <iostream>
-#include <fstream>
+#include <sstream>
 #include <string>
-#include <cstdlib>
-#include <math.h>
-#include <cmath>
-#include <ctime>
-#include <chrono>
+#include <vector>
+
+#include "render/dmd_renderer.h"
 
 using namespace matlab::data;
 using matlab::mex::ArgumentList;
 
-void framebuffer_size_callback(GLFWwindow * window, int width, int height);
-void processInput(GLFWwindow* window);
-int rowAlgorithm(int DMDRow, int DMDCol);
-int columnAlgorithm(int DMDRow, int DMDCol);
-int generateFrames(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, int*** lTweezers, float*** dTweezers, float*** moves, int N);
-void freeFrames(int** tweezerPositions, int*** lTweezers, float*** dTweezers, float*** moves);
-GLFWwindow* setUpWindow();
-
 /* Configuration Variables */
 
 // Configure DMD screen size:
@@ -37,20 +28,104 @@ GLFWwindow* setUpWindow();
 const unsigned int SCR_WIDTH = 1140;
 const unsigned int SCR_HEIGHT = 912;
 
+// Configure the DMD coordinate system:
+    // DMD_ROW_OFFSET: the offset added to rowAlgorithm() when mapping DMD pixels back onto the generated image.
+const int DMD_ROW_OFFSET = 607;
+
 // Configure several modes of operation:
     // DMD_MODE: Requires a secondary monitor to be connected and sends frames to this monitor.
     // WHITE_COLOR_MODE: Performs all computations as normal, but displays white when frames would normally be displayed.
     // INVERTED_COLOR_MODE: For each binary frame, flip all black pixels to white and all white pixels to black.
+    // GPU_REMAP_MODE: Uploads frames in the image coordinate system and lets the fragment shader remap them into the DMD coordinate
+    //                 system, instead of remapping them on the CPU.
+    // GPU_RASTER_MODE: Uploads only the tweezer positions of each frame and draws the tweezers on the GPU (with a compute shader where
+    //                  OpenGL 4.3 is available, and instanced quads otherwise); the remap is then always done by the fragment shader.
+    // GPU_RASTER_PATH: With GPU_RASTER_MODE, how the tweezers are drawn: Automatic, Compute or Instanced (one quad per tweezer and
+    //                  subframe, combined with glLogicOp(GL_OR), which only needs OpenGL 3.3).
 const bool DMD_MODE = true;
 const bool WHITE_COLOR_MODE = false;
 const bool INVERTED_COLOR_MODE = true;
+const bool GPU_REMAP_MODE = false;
+const bool GPU_RASTER_MODE = false;
+const GpuRasterPath GPU_RASTER_PATH = GpuRasterPath::Automatic;
+
+// Configure the display backend:
+    // HEADLESS_MODE: Renders into an offscreen framebuffer through EGL instead of opening a window, so that the renderer can be run and
+    //                profiled on a machine without a display (requires building with -DDMD_USE_EGL and linking against EGL). DMD_MODE is
+    //                ignored.
+    // CAPTURE_DIRECTORY: If not empty, every displayed frame is read back and written to this directory as shot_SSSS_frame_FFFF.ppm.
+const bool HEADLESS_MODE = false;
+const char* const CAPTURE_DIRECTORY = "";
+
+// Configure latency tracing:
+    // TRACE_CAPACITY: The number of timestamps kept from the most recent shots (see LatencyTrace): one at entry, argument parsing and
+    //                 routing, and per RGB frame when it has been rasterized, remapped, uploaded and presented. 0 disables tracing.
+    // TRACE_FILE: If not empty, the trace is written to this file as Chrome-trace JSON after every shot (for chrome://tracing or
+    //             Perfetto).
+const int TRACE_CAPACITY = 16384;
+const char* const TRACE_FILE = "";
+
+// Configure frame pacing:
+    // REFRESH_RATE: The refresh rate of the DMD's video input, in Hz, against which every present is checked (0 to use the refresh
+    //               rate that GLFW reports for the monitor). A present more than 1.5 refresh periods after the previous one means that
+    //               frame was shown twice; one less than half a period after it means the frame was never shown.
+    // PACING_ACTION: What to do when a frame is late or dropped: Report (only count it), Abort (stop the shot and clear the DMD) or
+    //                Reissue (present a late frame again and go on from there, at most MAX_REISSUES times before aborting; a dropped
+    //                frame aborts).
+const double REFRESH_RATE = 0.0;
+const PacingAction PACING_ACTION = PacingAction::Report;
+const int MAX_REISSUES = 2;
+
+// Configure frame production:
+    // PIPELINE_WORKERS: The number of threads that rasterize and remap frames ahead of the display. With 0, each frame is rendered on
+    //                   the MATLAB thread just before it is displayed.
+    // PIPELINE_RING_SIZE: The number of finished frames that can be queued ahead of the display.
+    // RASTER_THREADS: The number of threads that rasterize and remap a single frame together, splitting it into horizontal tiles.
+    //                 Used for every frame when PIPELINE_WORKERS is 0, and otherwise for the first frame of each shot.
+const int PIPELINE_WORKERS = 2;
+const int PIPELINE_RING_SIZE = 4;
+const int RASTER_THREADS = 4;
+
+// Configure texture upload:
+    // UPLOAD_RING_SIZE: The number of pixel buffer objects used to stream frames to the GPU; while one is being transferred into the
+    //                   texture, the next frame is written into another.
+const int UPLOAD_RING_SIZE = 3;
+
+// Configure shader location:
+    // SHADER_DIRECTORY: The directory holding texture.vs, texture.fs and the tweezer shaders, ending in a separator (empty for the
+    //                   working directory). For Mac: "/Users/samir/Desktop/DMD/"
+const char* const SHADER_DIRECTORY = "";
 
 // Configure memory allocation:
     // MAX_TIME: The expected maximum number of total moves between lattice sites (defines the amouunt of memory to allocate for frame generation):
 const int MAX_TIME = 40;
 
+// Configure the plan cache:
+    // PLAN_CACHE_ENTRIES: The number of plans (routed and smoothed moves) kept for occupancy matrices seen before with the same lattice,
+    //                     smoothing factor, routing method and target pattern; a shot found in the cache is displayed without routing.
+    //                     0 disables the cache.
+    // PLAN_CACHE_BYTES: The memory the cached plans may hold; the least recently used plans are dropped beyond it.
+    // CACHE_RGB_FRAMES: Also keep the RGB frames of every cached plan (width * height * 4 bytes each), so that a repeated shot is not
+    //                   rasterized again either (not with GPU_RASTER_MODE, which draws the frames on the GPU).
+const int PLAN_CACHE_ENTRIES = 64;
+const size_t PLAN_CACHE_BYTES = (size_t)256 << 20;
+const bool CACHE_RGB_FRAMES = false;
+
+// Configure routing:
+    // DEFAULT_ROUTING_METHOD: How the tweezers are routed when no method is passed to main() (see RoutingMethod): CenterOfMass steps
+    //                         each tweezer greedily towards the center of mass; Assignment fills the sites closest to the center of
+    //                         mass by a minimum-cost assignment, which usually takes fewer moves and frames; Reservation routes as
+    //                         Assignment, then replans the tweezers arriving last around the paths of the others to save frames.
+    // DEFAULT_LATTICE_TOPOLOGY: The moves the tweezers may make when no topology is passed to main() (see LatticeTopology): Square
+    //                           moves along vec1 or vec2 only; Triangular also moves along vec1 - vec2, for lattice vectors of equal
+    //                           length 60 degrees apart, which shortens diagonal paths.
+const RoutingMethod DEFAULT_ROUTING_METHOD = RoutingMethod::CenterOfMass;
+const LatticeTopology DEFAULT_LATTICE_TOPOLOGY = LatticeTopology::Square;
+
 // Configure tweezer pattern:
+    // DEFAULT_TWEEZER_SHAPE: The shape drawn for each tweezer when no shape is passed to main() (see TweezerShape).
     // TWEEZER_PATTERN: A 2D array specifying the shape of a tweezer for drawing on the screen based on deviations from the center in the x- and y- directions.
+const TweezerShape DEFAULT_TWEEZER_SHAPE = TweezerShape::Square;
 const int TWEEZER_PATTERN[13][2] = {
                        {0, 2},
              {-1, 1},  {0, 1},  {1, 1},
@@ -59,334 +134,58 @@ const int TWEEZER_PATTERN[13][2] = {
                        {0, -2}
 };
 
-/* Functions for window creation and frame generation */
-
-// generateFrames: Generates binary frames (stored in "moves" variable) and returns the total number generated.
-// Inputs:
-//      numTweezers: the total number of tweezers for which moves are to be computed
-//      occupancyRows: the number of rows in the occupancy matrix (i.e. the height of the lattice, in sites)
-//      occupancyCols: the number of columns in the occupancy matrix (i.e. the width of the lattice, in sites)
-//      tweezerPositions: a 2D matrix consisting of the initial positions of the tweezers (i.e. the occupancy matrix)
-//      lTweezers: a buffer of allocated memory used to store the series of tweezer moves in lattice space
-//      dTweezers: a buffer of allocated memory used to store the series of tweezer moves in DMD space
-//      moves: a buffer of allocated memory used to store the final series of moves in DMD space (i.e. a smoothed version of dTweezers)
-//      N: the smoothing factor, or the number of frames to generate to smooth between consecutive lattice sites
-//      vec1X, vec1Y, vec2X, vec2Y, centerX, centerY: parameters describing the lattice coordinate system in DMD space
-
-int generateFrames(int numTweezers, int occupancyRows, int occupancyCols, int** tweezerPositions, int*** lTweezers, float*** dTweezers, float*** moves, int N,
-                   float vec1X, float vec1Y, float vec2X, float vec2Y, float centerX, float centerY) {
-    // Initialize lTweezers
-    for (int i = 0; i < numTweezers; i++) {
-        lTweezers[i] = new int* [MAX_TIME];
-        for (int j = 0; j < MAX_TIME; j++) {
-            lTweezers[i][j] = new int[2];
-        }
-    }
-
-    // Initialize dTweezers
-    for (int i = 0; i < numTweezers; i++) {
-        dTweezers[i] = new float* [MAX_TIME];
-        for (int j = 0; j < MAX_TIME; j++) {
-            dTweezers[i][j] = new float[2];
-        }
-    }
-
-    // Initialize moves
-    for (int i = 0; i < numTweezers; i++) {
-        moves[i] = new float* [N * (MAX_TIME - 1) + 1];
-        for (int j = 0; j < N * (MAX_TIME - 1) + 1; j++) {
-            moves[i][j] = new float[2];
-        }
-    }
-
-    // Populate lTweezers with initial positions of tweezers, based on tweezerPositions.
-    int count = 0;
-    for (int i = 0; i < occupancyRows; i++) {
-        for (int j = 0; j < occupancyCols; j++) {
-            if (tweezerPositions[i][j] == 1) {
-                lTweezers[count][0][0] = i;
-                lTweezers[count][0][1] = j;
-                count++;
-            }
-        }
-    }
-
-    // Compute center-of-mass in x- and y- directions.
-    int COM_x = 0;
-    int COM_y = 0;
-    for (int i = 0; i < occupancyRows; i++) {
-        for (int j = 0; j < occupancyCols; j++) {
-            if (tweezerPositions[i][j] == 1) {
-                COM_x += i;
-                COM_y += j;
-            }
-        }
-    }
-    COM_x /= numTweezers;
-    COM_y /= numTweezers;
-
-    int currentFrame = 0;
-    while (true) {
-        int numMoves = 0;
-        for (int i = 0; i < numTweezers; i++) {
-            int row = lTweezers[i][currentFrame][0];
-            int col = lTweezers[i][currentFrame][1];
-            if (row != COM_y && abs(row - COM_y) >= abs(col - COM_x)) {
-                if (row > COM_y && tweezerPositions[row - 1][col] == 0) {
-                    lTweezers[i][currentFrame + 1][0] = row - 1;
-                    lTweezers[i][currentFrame + 1][1] = col;
-                    tweezerPositions[row - 1][col] = 1;
-                    tweezerPositions[row][col] = 0;
-                    numMoves++;
-                    continue;
-                }
-                else if (row < COM_y && tweezerPositions[row + 1][col] == 0) {
-                    lTweezers[i][currentFrame + 1][0] = row + 1;
-                    lTweezers[i][currentFrame + 1][1] = col;
-                    tweezerPositions[row + 1][col] = 1;
-                    tweezerPositions[row][col] = 0;
-                    numMoves++;
-                    continue;
-                }
-            }
-            if (col != COM_x) {
-                if (col > COM_x && tweezerPositions[row][col - 1] == 0) {
-                    lTweezers[i][currentFrame + 1][0] = row;
-                    lTweezers[i][currentFrame + 1][1] = col - 1;
-                    tweezerPositions[row][col - 1] = 1;
-                    tweezerPositions[row][col] = 0;
-                    numMoves++;
-                    continue;
-                }
-                else if (col < COM_x && tweezerPositions[row][col + 1] == 0) {
-                    lTweezers[i][currentFrame + 1][0] = row;
-                    lTweezers[i][currentFrame + 1][1] = col + 1;
-                    tweezerPositions[row][col + 1] = 1;
-                    tweezerPositions[row][col] = 0;
-                    numMoves++;
-                    continue;
-                }
-            }
-            if (row != COM_y) {
-                if (row > COM_y && tweezerPositions[row - 1][col] == 0) {
-                    lTweezers[i][currentFrame + 1][0] = row - 1;
-                    lTweezers[i][currentFrame + 1][1] = col;
-                    tweezerPositions[row - 1][col] = 1;
-                    tweezerPositions[row][col] = 0;
-                    numMoves++;
-                    continue;
-                }
-                else if (row < COM_y && tweezerPositions[row + 1][col] == 0) {
-                    lTweezers[i][currentFrame + 1][0] = row + 1;
-                    lTweezers[i][currentFrame + 1][1] = col;
-                    tweezerPositions[row + 1][col] = 1;
-                    tweezerPositions[row][col] = 0;
-                    numMoves++;
-                    continue;
-                }
-            }
-            lTweezers[i][currentFrame + 1][0] = row;
-            lTweezers[i][currentFrame + 1][1] = col;
-        }
-        if (numMoves == 0) break;
-        currentFrame++;
-    }
-    int numFrames = currentFrame + 1;
-
-    for (int i = 0; i < numTweezers; i++) {
-        for (int j = 0; j < numFrames; j++) {
-            lTweezers[i][j][0] -= occupancyRows / 2;
-            lTweezers[i][j][1] -= occupancyCols / 2;
-            dTweezers[i][j][0] = centerX + (lTweezers[i][j][0] * vec1X) + (lTweezers[i][j][1] * vec2X);
-            dTweezers[i][j][1] = centerY + (lTweezers[i][j][0] * vec1Y) + (lTweezers[i][j][1] * vec2Y);
-        }
-    }
-
-    for (int i = 0; i < numTweezers; i++) {
-        for (int j = 0; j < numFrames - 1; j++) {
-            float xDif = (dTweezers[i][j + 1][0] - dTweezers[i][j][0]) / (float)N;
-            float yDif = (dTweezers[i][j + 1][1] - dTweezers[i][j][1]) / (float)N;
-            for (int k = 0; k < N; k++) {
-                moves[i][j * N + k][0] = dTweezers[i][j][0] + xDif * k;
-                moves[i][j * N + k][1] = dTweezers[i][j][1] + yDif * k;
-            }
-            moves[i][(j + 1) * N][0] = dTweezers[i][numFrames - 1][0];
-            moves[i][(j + 1) * N][1] = dTweezers[i][numFrames - 1][1];
-        }
-    }
-
-    return numFrames;
-}
-
-// freeFrames: Frees the memory associated with frame generation.
-void freeFrames(int numTweezers, int N, int occupancyRows, int occupancyCols, int** tweezerPositions, int*** lTweezers, float*** dTweezers, float*** moves) {
-    for (int i = 0; i < occupancyRows; i++) {
-        delete[] tweezerPositions[i];
-    }
-    delete[] tweezerPositions;
-    
-    for (int i = 0; i < numTweezers; i++) {
-        for (int j = 0; j < MAX_TIME; j++) {
-            delete[] lTweezers[i][j];
-        }
-        delete[] lTweezers[i];
-    }
-    delete[] lTweezers;
-
-    for (int i = 0; i < numTweezers; i++) {
-        for (int j = 0; j < MAX_TIME; j++) {
-            delete[] dTweezers[i][j];
-        }
-        delete[] dTweezers[i];
-    }
-    delete[] dTweezers;
-
-    for (int i = 0; i < numTweezers; i++) {
-        for (int j = 0; j < N * (MAX_TIME - 1) + 1; j++) {
-            delete[] moves[i][j];
-        }
-        delete[] moves[i];
-    }
-    delete[] moves;
-}
-
-// setUpWindow: sets up a window using GLFW and returns a pointer to the window. Returns NULL on failure.
-GLFWwindow* setUpWindow() {
-    // GLFW Setup
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
-
-    GLFWwindow* window;
-    if (DMD_MODE) {
-        int count;
-        GLFWmonitor** monitors = glfwGetMonitors(&count);
-        if (count < 2) {
-            std::cout << "DMD Not Connected" << std::endl;
-            return NULL;
-        }
-        glfwWindowHint(GLFW_AUTO_ICONIFY, GLFW_FALSE);
-        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "DMD Test Window", monitors[1], NULL);
-    }
-    else window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "DMD Test Window", NULL, NULL);
-
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return NULL;
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    return window;
-}
-
-// processInput: closes window if the escape key is being pressed.
-void processInput(GLFWwindow* window)
-{
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-}
-
-// framebuffer_size_callback: resizes viewport on resizing of window
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
-{
-    glViewport(0, 0, width, height);
-}
-
-int rowAlgorithm(int DMDRow, int DMDCol) {
-    return -DMDCol + (int)(DMDRow / 2);
-}
-
-int columnAlgorithm(int DMDRow, int DMDCol) {
-    return ((int)((DMDRow + 1) / 2)) + DMDCol;
-}
-
 class MexFunction : public matlab::mex::Function {
-    //    Instance variables (mostly to do with OpenGL and GLFW functionality).
-    GLFWwindow* window;
-    unsigned int VBO, VAO, EBO;
-    float vertices[32] = {
-        1.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // top right
-        1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // bottom right
-       -1.0f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // bottom left
-       -1.0f,  1.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // top left
-    };
-    unsigned int indices[6] = {
-        0, 1, 3,
-        1, 2, 3
-    };
-    unsigned int texture;
-    Shader* ourShader;
+    //    The renderer, which owns the window, every OpenGL object and the frame-production threads.
+    DmdRenderer renderer;
+    //    Buffers used to convert the occupancy matrix and custom masks passed from MATLAB.
+    std::vector<uint8_t> occupancy;
+    std::vector<uint8_t> customMask;
+    std::vector<uint8_t> targetPattern;
+    std::vector<int8_t> replanDelta;
+    //    The result of the last shot, for the routing cost output.
+    ShotResult lastResult;
     
 public:
     MexFunction() {
-        window = setUpWindow();
-        if (window == NULL) {
-            std::cout << "Failed to create window." << std::endl;
-        }
-        
-        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-        {
-            std::cout << "Failed to initialize GLAD." << std::endl;
-        }
-
-        //    For Windows:
-        ourShader = new Shader("texture.vs", "texture.fs");
-
-        //    For Mac:
-        //    ourShader = new Shader("/Users/samir/Desktop/DMD/texture.vs", "/Users/samir/Desktop/DMD/texture.fs");
-        
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
-    
-    ~MexFunction() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
-
-        glfwTerminate();
+        DmdRendererConfig config;
+        config.width = SCR_WIDTH;
+        config.height = SCR_HEIGHT;
+        config.rowOffset = DMD_ROW_OFFSET;
+        config.headless = HEADLESS_MODE;
+        config.useSecondMonitor = DMD_MODE;
+        config.whiteColor = WHITE_COLOR_MODE;
+        config.inverted = INVERTED_COLOR_MODE;
+        config.gpuRemap = GPU_REMAP_MODE;
+        config.gpuRaster = GPU_RASTER_MODE;
+        config.gpuRasterPath = GPU_RASTER_PATH;
+        config.pipelineWorkers = PIPELINE_WORKERS;
+        config.pipelineRingSize = PIPELINE_RING_SIZE;
+        config.rasterThreads = RASTER_THREADS;
+        config.uploadRingSize = UPLOAD_RING_SIZE;
+        config.maxTime = MAX_TIME;
+        config.shaderDirectory = SHADER_DIRECTORY;
+        config.captureDirectory = CAPTURE_DIRECTORY;
+        config.traceCapacity = TRACE_CAPACITY;
+        config.refreshRate = REFRESH_RATE;
+        config.pacingAction = PACING_ACTION;
+        config.maxReissues = MAX_REISSUES;
+        config.planCacheEntries = PLAN_CACHE_ENTRIES;
+        config.planCacheBytes = PLAN_CACHE_BYTES;
+        config.cacheFrames = CACHE_RGB_FRAMES;
+        renderer.init(config);
+        renderer.setPattern(TWEEZER_PATTERN, sizeof(TWEEZER_PATTERN) / sizeof(TWEEZER_PATTERN[0]));
     }
     
-    /* The MEX function operator() is invoked by calling main() in MATLAB with the following parameters:
-            (int) numTweezers: the total number of tweezers (i.e. the number of "1" values in the occupancy matrix
+    /* The MEX function operator() is invoked by calling main() in MATLAB with the following parameters (a tweezerShape,
+       routingMethod or latticeTopology outside the values listed raises an error):
+            (int) numTweezers: the total number of tweezers (i.e. the number of "1" values in the occupancy matrix); kept for
+                        compatibility, as the tweezers are counted from the occupancy matrix
             (int) occupancyRows: the number of rows in the occupancy matrix
             (int) occupancyCols: the number of columns in the occupancy matrix
             (int array) occupancyMatrix: a one-dimensional matrix consisting of values "0" and "1"; converted to a 2D
                         matrix using the values specified by occupancyRows and occupancyCols
-            (int) tweezerSize: the side length of the square defining the size of a tweezer, in pixels
+            (int) tweezerSize: the size of a tweezer, in pixels: the half-width of the square (which is 2 * tweezerSize + 1 pixels wide),
+                        the radius of the diamond or disc, or the sigma of the Gaussian spot
             (int) N: the smoothing factor specifying how many frames should be included between consecutive lattice sites
             (float) vec1X: the x-component of the first vector specifying the lattice orientation in DMD space
             (float) vec1Y: the y-component of the first vector specifying the lattice orientation in DMD space
@@ -395,10 +194,52 @@ public:
             (float) centerX: the x-component of the center of the lattice in DMD space
             (float) centerY: the y-component of the center of the lattice in DMD space
             (int) init: should be set to 1 for the first call to operator and to 0 for all subsequent calls
+            (int, optional) tweezerShape: 0 = square, 1 = diamond, 2 = disc, 3 = Gaussian, 4 = TWEEZER_PATTERN, 5 = custom mask
+            (optional) shapeParameter: for Gaussian spots, the fraction of the peak intensity at which the spot is cut off (float);
+                        for custom masks, a 2D matrix that is nonzero where the tweezer is drawn, centered on the tweezer
+                        (pass 0 when a routing method follows and the shape takes no parameter)
+            (int, optional) routingMethod: 0 = center of mass, 1 = minimum-cost assignment, 2 = assignment shortened on a
+                        reservation table (see DEFAULT_ROUTING_METHOD)
+            (int, optional) latticeTopology: 0 = square (four neighbours), 1 = triangular (six neighbours, also moving along
+                        vec1 - vec2) (see DEFAULT_LATTICE_TOPOLOGY)
+            (int array, optional) targetPattern: a one-dimensional matrix laid out as occupancyMatrix, giving the role of every site:
+                        0 = free, 1 = target (to be filled), 2 = reservoir (where atoms left over once the targets are filled are
+                        parked, e.g. an ejection zone); the tweezers are then routed onto the targets by minimum-cost assignment instead
+                        of towards the center of mass, with routingMethod 0 taken as 1 (pass [] for no pattern)
+            (int array, optional) replanDelta: a one-dimensional matrix laid out as occupancyMatrix, found by an image taken during the
+                        last shot: -1 where an atom was lost, 1 where an extra atom was found and 0 elsewhere; the plan of the last shot
+                        is then repaired from replanFrame and the rest of it displayed, instead of routing occupancyMatrix, which is
+                        only used (with the delta applied) if there is no plan to repair (see DmdRenderer::replanShot)
+            (int, optional) replanFrame: the lattice frame of the last shot in which the image was taken, 0 being its initial
+                        configuration; -1 (or omitted) for the frame the last shot was held at, or 0 if it was not held. A held shot
+                        is continued from the frame it is held at, and any other replanFrame raises an error
+            (int, optional) holdFrame: the lattice frame to stop this shot (or the rest of a repaired one) at, leaving it displayed
+                        for an image whose delta the next call passes as replanDelta; -1 (or omitted) plays it to the end
+       Optional outputs:
+            (double) the high-water memory usage of the per-shot buffers, in bytes
+            (double array) texture upload statistics for the shot: [uploads, mean CPU time, max CPU time, mean GPU time, max GPU time,
+                        fence waits], with times in microseconds
+            (double array) frame pipeline statistics for the shot: [frames, underruns, total underrun wait, first frame wait,
+                        mean queue depth, min queue depth, max queue depth], with times in microseconds (zeros when PIPELINE_WORKERS is 0)
+            (struct) the latency trace of the last shot, with one column vector per field: event (0 = entry, 1 = arguments parsed,
+                        2 = route done, 3 = raster done, 4 = remap done, 5 = upload done, 6 = present done, 7 = shot done), frame
+                        (the RGB frame, or -1), thread, and time (microseconds since entry); empty when TRACE_CAPACITY is 0
+            (double array) frame pacing for the shot: [presents, expected refresh period, mean interval, min interval, max interval,
+                        late frames, repeated refreshes, dropped frames, late GPU frames, GPU backlog frames, first faulty frame
+                        (-1 if none), reissues, aborted], with times in microseconds; the shot played exactly as planned when late
+                        frames, dropped frames and aborted are all 0
+            (double array) the routing cost of the shot: [lattice frames, site steps (single-site moves of all the tweezers),
+                        assignment cost (the total lattice distance of the optimal assignment), target sites, target sites filled,
+                        atoms parked on reservoir sites]; the last four are 0 when routing towards the center of mass
+            (double array) the plan cache: [lookups, hits, hit rate, plans cached, bytes held, evictions, plan of this shot cached (0 or
+                        1), frames of this shot cached (0 or 1), shots whose frames did not fit in the cache], counted since the
+                        first call
+            (double array) the repair of the shot, with replanDelta: [atoms lost, extra atoms, paths searched again (-1 if the plan
+                        could not be repaired and the occupancy found by the image was routed from scratch)]; zeros otherwise
      */
 
     void operator() (matlab::mex::ArgumentList outputs, matlab::mex::ArgumentList inputs) {
-        int numTweezers = inputs[0][0];
+        std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now();
         int occupancyRows = inputs[1][0];
         int occupancyCols = inputs[2][0];
         matlab::data::Array occupancyMatrix = inputs[3];
@@ -412,121 +253,226 @@ public:
         float centerY = inputs[11][0];
         int init = inputs[12][0];
 
-        if (init == 1) return;
-       
-        int** tweezerPositions = new int* [occupancyRows];
-        int*** lTweezers = new int** [numTweezers];
-        float*** dTweezers = new float** [numTweezers];
-        float*** moves = new float** [numTweezers];
-        
-        for (int i = 0; i < occupancyRows; i++) {
-            tweezerPositions[i] = new int[occupancyCols];
-            for (int j = 0; j < occupancyCols; j++) {
-                tweezerPositions[i][j] = occupancyMatrix[i * occupancyCols + j];
-            }
+        if (init == 1) {
+            lastResult = ShotResult();
+            reportStats(outputs);
+            return;
+        }
+
+        occupancy.resize((size_t)occupancyRows * occupancyCols);
+        for (size_t i = 0; i < occupancy.size(); i++) {
+            occupancy[i] = (double)occupancyMatrix[i] == 1.0;
         }
-        
-        int numFrames = generateFrames(numTweezers, occupancyRows, occupancyCols, tweezerPositions, lTweezers, dTweezers, moves, N,
-                                       vec1X, vec1Y, vec2X, vec2Y, centerX, centerY);
-
-        GLubyte* textureArray = new GLubyte[SCR_WIDTH * SCR_HEIGHT * 3];
-        GLubyte* dmdTextureArray = new GLubyte[SCR_WIDTH * SCR_HEIGHT * 3];
-
-        int iter = 0;
-        
-        while (!glfwWindowShouldClose(window)) {
-            if (iter * 24 > (N * (numFrames - 1) + 1)) {
-                freeFrames(numTweezers, N, occupancyRows, occupancyCols, tweezerPositions, lTweezers, dTweezers, moves);
-                glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                glfwSwapBuffers(window);
-                return;
+
+        ShotRequest request;
+        request.occupancy = occupancy.data();
+        request.occupancyRows = occupancyRows;
+        request.occupancyCols = occupancyCols;
+        request.N = N;
+        request.lattice.vec1X = vec1X;
+        request.lattice.vec1Y = vec1Y;
+        request.lattice.vec2X = vec2X;
+        request.lattice.vec2Y = vec2Y;
+        request.lattice.centerX = centerX;
+        request.lattice.centerY = centerY;
+        request.lattice.topology = parseEnum(inputs, 16, LatticeTopology::Triangular, DEFAULT_LATTICE_TOPOLOGY, "latticeTopology");
+        request.shape = parseTweezerShape(inputs, tweezerSize);
+        request.routing = parseEnum(inputs, 15, RoutingMethod::Reservation, DEFAULT_ROUTING_METHOD, "routingMethod");
+        request.targetPattern = parseTargetPattern(inputs, occupancy.size());
+        request.holdFrame = inputs.size() > 20 ? (int)inputs[20][0] : -1;
+        request.received = received;
+        request.parsed = std::chrono::steady_clock::now();
+
+        const int8_t* delta = parseReplanDelta(inputs, occupancy.size());
+        if (delta != nullptr) {
+            int fromFrame = inputs.size() > 19 ? (int)inputs[19][0] : -1;
+            if (renderer.heldFrame() >= 0 && fromFrame >= 0 && fromFrame != renderer.heldFrame()) {
+                std::ostringstream message;
+                message << "main: invalid replanFrame " << fromFrame << " (the last shot is held at frame " << renderer.heldFrame() << ")";
+                raiseError(message.str());
             }
-            else {
-                GLubyte defaultPixelColor = INVERTED_COLOR_MODE ? 255 : 0;
-
-                for (int i = 0; i < SCR_HEIGHT; i++)
-                {
-                    for (int j = 0; j < SCR_WIDTH; j++) {
-                        textureArray[i * SCR_WIDTH * 3 + j * 3] = defaultPixelColor;
-                        textureArray[i * SCR_WIDTH * 3 + j * 3 + 1] = defaultPixelColor;
-                        textureArray[i * SCR_WIDTH * 3 + j * 3 + 2] = defaultPixelColor;
-                        dmdTextureArray[i * SCR_WIDTH * 3 + j * 3] = defaultPixelColor;
-                        dmdTextureArray[i * SCR_WIDTH * 3 + j * 3 + 1] = defaultPixelColor;
-                        dmdTextureArray[i * SCR_WIDTH * 3 + j * 3 + 2] = defaultPixelColor;
-                    }
-                }
+            lastResult = renderer.replanShot(request, fromFrame, delta);
+        }
+        else {
+            lastResult = renderer.runShot(request);
+        }
+        if (TRACE_FILE[0] != '\0') renderer.latencyTrace().writeChromeTrace(TRACE_FILE);
+        reportStats(outputs);
+    }
 
-                // Take the next 24 binary frames and generate an RGB image.
-                for (int i = 0; i < numTweezers; i++) {
-                    for (int j = 0; j < 24 && (iter * 24) + j < (N * (numFrames - 1) + 1); j++) {
-                        int x = (int)moves[i][(iter * 24) + j][0];
-                        int y = (int)moves[i][(iter * 24) + j][1];
-                        /*
-                        for (int i = 0; i < sizeof(TWEEZER_PATTERN)/sizeof(int*); i++) {
-                            int dx = TWEEZER_PATTERN[i][0];
-                            int dy = TWEEZER_PATTERN[i][1];
-                            if (x + dx < 0 || y + dy < 0 || x + dx > SCR_HEIGHT || y + dy > SCR_WIDTH) {
-                                continue;
-                            }
-                            GLubyte flipped = INVERTED_COLOR_MODE ? -1 : 1;
-                            if (j < 8) textureArray[(x + dx) * SCR_WIDTH * 3 + (y + dy) * 3] += (GLubyte)pow(2, 7 - (j % 8)) * flipped;
-                            else if (j < 16) textureArray[(x + dx) * SCR_WIDTH * 3 + (y + dy) * 3 + 1] += (GLubyte)pow(2, 7 - (j % 8)) * flipped;
-                            else textureArray[(x + dx) * SCR_WIDTH * 3 + (y + dy) * 3 + 2] += (GLubyte)pow(2, 7 - (j % 8)) * flipped;
-                        }
-                        */
-                        
-                        for (int dx = -tweezerSize; dx <= tweezerSize; dx++) {
-                            if (x + dx < 0 || x + dx > SCR_HEIGHT) continue;
-                            for (int dy = -tweezerSize; dy <= tweezerSize; dy++) {
-                                if (y + dy < 0 || y + dy > SCR_WIDTH) continue;
-                                GLubyte flipped = INVERTED_COLOR_MODE ? -1 : 1;
-                                if (j < 8) textureArray[(x + dx) * SCR_WIDTH * 3 + (y + dy) * 3] += (GLubyte)pow(2, 7 - (j % 8)) * flipped;
-                                else if (j < 16) textureArray[(x + dx) * SCR_WIDTH * 3 + (y + dy) * 3 + 1] += (GLubyte)pow(2, 7 - (j % 8)) * flipped;
-                                else textureArray[(x + dx) * SCR_WIDTH * 3 + (y + dy) * 3 + 2] += (GLubyte)pow(2, 7 - (j % 8)) * flipped;
-                            }
-                        }    
-                    }
-                }
+private:
+    // parseEnum: reads the optional argument at index as a value of Enum, from 0 to last, or returns fallback if it was not passed. Any
+    // other value raises a MATLAB error, which ends the call, rather than being drawn or routed as something it is not.
+    template <typename Enum>
+    Enum parseEnum(matlab::mex::ArgumentList& inputs, size_t index, Enum last, Enum fallback, const char* name) {
+        if (inputs.size() <= index) return fallback;
+        double value = inputs[index][0];
+        if (value != std::floor(value) || value < 0.0 || value > (double)(int)last) {
+            std::ostringstream message;
+            message << "main: invalid " << name << " " << value << " (expected an integer from 0 to " << (int)last << ")";
+            raiseError(message.str());
+        }
+        return (Enum)(int)value;
+    }
 
-                // Populate dmdTextureArray with textureArray in DMD coordinate system by using rowAlgorithm() and columnAlgorithm().
-                for (int i = 0; i < SCR_HEIGHT; i++) {
-                    for (int j = 0; j < SCR_WIDTH; j++) {
-                        int x = 607 + rowAlgorithm(i, j);
-                        int y = columnAlgorithm(i, j);
-                        if (x < SCR_HEIGHT && y < SCR_WIDTH) {
-                            dmdTextureArray[i * SCR_WIDTH * 3 + j * 3] = textureArray[x * SCR_WIDTH * 3 + y * 3];
-                            dmdTextureArray[i * SCR_WIDTH * 3 + j * 3 + 1] = textureArray[x * SCR_WIDTH * 3 + y * 3 + 1];
-                            dmdTextureArray[i * SCR_WIDTH * 3 + j * 3 + 2] = textureArray[x * SCR_WIDTH * 3 + y * 3 + 2];
-                        }
-                    }
-                }
-                
-                if (WHITE_COLOR_MODE) {
-                    if (iter * 24 > (N * (numFrames - 1) + 1)) {
-                        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-                    }
-                    else {
-                        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-                    }
-                    glClear(GL_COLOR_BUFFER_BIT);
-                }
-                
-                else {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, dmdTextureArray);
-                    glGenerateMipmap(GL_TEXTURE_2D);
-                    ourShader->use();
-                    glBindVertexArray(VAO);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                }
-                
-                glfwSwapBuffers(window);
+    // raiseError: raises a MATLAB error with the given message; the call ends there.
+    void raiseError(const std::string& message) {
+        matlab::data::ArrayFactory factory;
+        getEngine()->feval(u"error", 0, std::vector<matlab::data::Array>({ factory.createScalar(message) }));
+    }
 
-                iter++;
+    // parseTweezerShape: reads the optional tweezerShape and shapeParameter arguments.
+    TweezerShapeSpec parseTweezerShape(matlab::mex::ArgumentList& inputs, int tweezerSize) {
+        TweezerShapeSpec spec;
+        spec.shape = parseEnum(inputs, 13, TweezerShape::Custom, DEFAULT_TWEEZER_SHAPE, "tweezerShape");
+        spec.size = tweezerSize;
+        if (spec.shape == TweezerShape::Gaussian && inputs.size() > 14) {
+            spec.parameter = inputs[14][0];
+        }
+        else if (spec.shape == TweezerShape::Custom && inputs.size() > 14) {
+            // MATLAB stores matrices column-major; the registry expects row-major masks.
+            matlab::data::Array mask = inputs[14];
+            std::vector<size_t> dimensions = mask.getDimensions();
+            spec.maskRows = (int)dimensions[0];
+            spec.maskCols = (int)dimensions[1];
+            customMask.resize((size_t)spec.maskRows * spec.maskCols);
+            for (int i = 0; i < spec.maskRows; i++) {
+                for (int j = 0; j < spec.maskCols; j++) {
+                    customMask[(size_t)i * spec.maskCols + j] = (double)mask[(size_t)j * spec.maskRows + i] != 0.0;
+                }
             }
+            spec.mask = customMask.data();
+        }
+        return spec;
+    }
+
+    // parseTargetPattern: reads the optional targetPattern argument, or returns null if it is missing or does not hold one value per
+    // site.
+    const uint8_t* parseTargetPattern(matlab::mex::ArgumentList& inputs, size_t numSites) {
+        if (inputs.size() <= 17 || inputs[17].getNumberOfElements() != numSites) return nullptr;
+        matlab::data::Array pattern = inputs[17];
+        targetPattern.resize(numSites);
+        for (size_t i = 0; i < numSites; i++) {
+            double value = pattern[i];
+            TargetSite site = value == 1.0 ? TargetSite::Target : value == 2.0 ? TargetSite::Reservoir : TargetSite::Free;
+            targetPattern[i] = (uint8_t)site;
+        }
+        return targetPattern.data();
+    }
+
+    // parseReplanDelta: reads the optional replanDelta argument, or returns null if it is missing or does not hold one value per site.
+    const int8_t* parseReplanDelta(matlab::mex::ArgumentList& inputs, size_t numSites) {
+        if (inputs.size() <= 18 || inputs[18].getNumberOfElements() != numSites) return nullptr;
+        matlab::data::Array delta = inputs[18];
+        replanDelta.resize(numSites);
+        for (size_t i = 0; i < numSites; i++) {
+            double value = delta[i];
+            AtomChange change = value < 0.0 ? AtomChange::Lost : value > 0.0 ? AtomChange::Extra : AtomChange::Unchanged;
+            replanDelta[i] = (int8_t)change;
+        }
+        return replanDelta.data();
+    }
+
+    // reportStats: returns the high-water memory usage of the frame-generation buffers, the upload and pipeline statistics, the
+    // latency trace, the frame pacing and the routing cost of the shot, the plan cache statistics and the repair of the shot, for as
+    // many outputs as were requested.
+    void reportStats(matlab::mex::ArgumentList& outputs) {
+        if (outputs.size() == 0) return;
+        matlab::data::ArrayFactory factory;
+        outputs[0] = factory.createScalar<double>((double)renderer.context().highWaterBytes);
+        if (outputs.size() > 1) {
+            const TextureUploader::UploadStats& stats = renderer.uploadStats();
+            double uploads = (double)stats.uploads;
+            double gpuSamples = (double)stats.gpuSamples;
+            outputs[1] = factory.createArray<double>({ 1, 6 }, {
+                uploads,
+                uploads > 0 ? stats.totalCpuMicroseconds / uploads : 0.0,
+                stats.maxCpuMicroseconds,
+                gpuSamples > 0 ? stats.totalGpuMicroseconds / gpuSamples : 0.0,
+                stats.maxGpuMicroseconds,
+                (double)stats.fenceWaits });
+        }
+        if (outputs.size() > 2) {
+            const FramePipeline::PipelineStats& stats = renderer.pipelineStats();
+            double frames = (double)stats.framesConsumed;
+            outputs[2] = factory.createArray<double>({ 1, 7 }, {
+                frames,
+                (double)stats.underruns,
+                stats.underrunWaitMicroseconds,
+                stats.firstFrameWaitMicroseconds,
+                frames > 0 ? stats.totalQueueDepth / frames : 0.0,
+                (double)stats.minQueueDepth,
+                (double)stats.maxQueueDepth });
+        }
+        if (outputs.size() > 3) outputs[3] = traceStruct(factory);
+        if (outputs.size() > 4) {
+            const PacingReport& pacing = renderer.pacingReport();
+            outputs[4] = factory.createArray<double>({ 1, 13 }, {
+                (double)pacing.presents,
+                pacing.expectedPeriodMicroseconds,
+                pacing.meanIntervalMicroseconds(),
+                pacing.minIntervalMicroseconds,
+                pacing.maxIntervalMicroseconds,
+                (double)pacing.lateFrames,
+                (double)pacing.repeatedRefreshes,
+                (double)pacing.droppedFrames,
+                (double)pacing.gpuLateFrames,
+                (double)pacing.gpuBacklogFrames,
+                (double)pacing.firstFaultFrame,
+                (double)pacing.reissues,
+                pacing.aborted ? 1.0 : 0.0 });
+        }
+        if (outputs.size() > 5) {
+            outputs[5] = factory.createArray<double>({ 1, 6 }, {
+                (double)lastResult.numLatticeFrames,
+                (double)lastResult.siteSteps,
+                (double)lastResult.assignmentCost,
+                (double)lastResult.numTargets,
+                (double)lastResult.targetsFilled,
+                (double)lastResult.parkedAtoms });
+        }
+        if (outputs.size() > 6) {
+            const PlanCache& cache = renderer.planCache();
+            outputs[6] = factory.createArray<double>({ 1, 9 }, {
+                (double)cache.stats().lookups,
+                (double)cache.stats().hits,
+                cache.stats().hitRate(),
+                (double)cache.size(),
+                (double)cache.capacityBytes(),
+                (double)cache.stats().evictions,
+                lastResult.planCached ? 1.0 : 0.0,
+                lastResult.framesCached ? 1.0 : 0.0,
+                (double)cache.stats().framesSkipped });
+        }
+        if (outputs.size() > 7) {
+            outputs[7] = factory.createArray<double>({ 1, 3 }, {
+                (double)lastResult.lostAtoms,
+                (double)lastResult.extraAtoms,
+                (double)lastResult.repairedPaths });
+        }
+    }
 
-            glfwPollEvents();
-            processInput(window);
+    // traceStruct: the records of the most recent shot in the latency trace, as a struct of column vectors.
+    matlab::data::StructArray traceStruct(matlab::data::ArrayFactory& factory) {
+        std::vector<TraceRecord> records = renderer.latencyTrace().snapshot();
+        int shot = renderer.latencyTrace().currentShot();
+        std::vector<double> event, frame, thread, time;
+        int64_t entry = 0;
+        for (const TraceRecord& record : records) {
+            if (record.shot != shot) continue;
+            if (record.event == TraceEvent::ShotReceived) entry = record.time;
+            event.push_back((double)record.event);
+            frame.push_back((double)record.frame);
+            thread.push_back((double)record.thread);
+            time.push_back((double)record.time);
         }
+        for (double& t : time) t = (t - (double)entry) / 1000.0;
+
+        matlab::data::StructArray trace = factory.createStructArray({ 1, 1 }, { "event", "frame", "thread", "time" });
+        trace[0]["event"] = factory.createArray<double>({ event.size(), 1 }, event.begin(), event.end());
+        trace[0]["frame"] = factory.createArray<double>({ frame.size(), 1 }, frame.begin(), frame.end());
+        trace[0]["thread"] = factory.createArray<double>({ thread.size(), 1 }, thread.begin(), thread.end());
+        trace[0]["time"] = factory.createArray<double>({ time.size(), 1 }, time.begin(), time.end());
+        return trace;
     }
 };
@@ -0,0 +1,54 @@
+#ifndef DISPLAY_BACKEND_H
+#define DISPLAY_BACKEND_H
+
+#include <glad/glad.h>
+
+#include "frame_capture.h"
+
+// DisplayBackend: owns the OpenGL context that frames are drawn into and the surface they are presented on. The renderer only draws
+// into targetFramebuffer() and calls present(), so the same code drives the DMD window (GlfwBackend) and an offscreen framebuffer on a
+// machine without a display (EglBackend).
+class DisplayBackend {
+public:
+    virtual ~DisplayBackend() {}
+
+    // init: creates the context and its surface and makes the context current. Returns false on failure.
+    // Inputs:
+    //      width, height: the size of the surface, in pixels
+    virtual bool init(int width, int height) = 0;
+
+    // release: destroys the surface and the context.
+    virtual void release() = 0;
+
+    // procLoader: the function used to look up OpenGL entry points for this context (for glad and loadGLExtensions).
+    virtual GLADloadproc procLoader() const = 0;
+
+    // targetFramebuffer: the framebuffer that frames are drawn into; 0 for a window. Code that binds its own framebuffers restores it.
+    virtual GLuint targetFramebuffer() const { return 0; }
+
+    // present: shows the frame drawn into the target framebuffer.
+    virtual void present() = 0;
+
+    // refreshRate: the refresh rate of the surface, in Hz, or 0 if it has none or it is unknown.
+    virtual double refreshRate() const { return 0.0; }
+
+    // shouldClose: whether the user or the system asked for the display to be closed.
+    virtual bool shouldClose() { return false; }
+
+    // pollEvents: processes window events (and closes the window on escape).
+    virtual void pollEvents() {}
+
+    // captureFrame: reads back the frame drawn into the target framebuffer, before it is presented, into capture.
+    void captureFrame() {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, targetFramebuffer());
+        capture.grab(width, height);
+    }
+
+    FrameCapture capture;
+
+protected:
+    int width = 0;
+    int height = 0;
+};
+
+#endif
@@ -0,0 +1,433 @@
+#include "dmd_renderer.h"
+#include "egl_backend.h"
+#include "gl_extensions.h"
+#include "glfw_backend.h"
+
+#include <shader_s.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "../core/bitplane_rasterizer.h"
+#include "../core/router.h"
+
+// The full-screen quad that every frame is drawn on: position, color and texture coordinates per vertex.
+static const float QUAD_VERTICES[32] = {
+    1.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // top right
+    1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // bottom right
+   -1.0f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // bottom left
+   -1.0f,  1.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // top left
+};
+static const unsigned int QUAD_INDICES[6] = {
+    0, 1, 3,
+    1, 2, 3
+};
+
+DmdRenderer::DmdRenderer() {
+}
+
+DmdRenderer::~DmdRenderer() {
+    release();
+}
+
+bool DmdRenderer::init(const DmdRendererConfig& config) {
+    release();
+    this->config = config;
+
+    if (config.headless) displayBackend = new EglBackend();
+    else displayBackend = new GlfwBackend(config.useSecondMonitor);
+    if (!displayBackend->init(config.width, config.height)) {
+        std::cout << "Failed to create window." << std::endl;
+        return false;
+    }
+    displayBackend->capture.directory = config.captureDirectory;
+    displayBackend->capture.toMemory = config.captureToMemory;
+
+    if (!gladLoadGLLoader(displayBackend->procLoader()))
+    {
+        std::cout << "Failed to initialize GLAD." << std::endl;
+        return false;
+    }
+    loadGLExtensions(displayBackend->procLoader());
+
+    ourShader = new Shader((config.shaderDirectory + "texture.vs").c_str(), (config.shaderDirectory + "texture.fs").c_str());
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    dmdRemap.build(config.width, config.height, config.rowOffset);
+
+    gpuRaster = false;
+    if (config.gpuRaster) {
+        gpuRaster = gpuRasterizer.init(config.width, config.height, config.gpuRasterPath, VBO, EBO, config.shaderDirectory);
+        if (!gpuRaster) std::cout << "Failed to set up GPU rasterization; frames will be drawn on the CPU." << std::endl;
+    }
+
+    float backgroundColor = config.inverted ? 1.0f : 0.0f;
+    ourShader->use();
+    ourShader->setInt("texture1", 0);
+    ourShader->setInt("packedTexture", 1);
+    ourShader->setBool("packedInput", gpuRaster);
+    ourShader->setBool("invertPacked", config.inverted);
+    ourShader->setBool("gpuRemap", config.gpuRemap || gpuRaster);
+    ourShader->setInt("rowOffset", config.rowOffset);
+    ourShader->setIVec2("screenSize", config.width, config.height);
+    ourShader->setVec3("backgroundColor", backgroundColor, backgroundColor, backgroundColor);
+
+    textureUploader.init(config.width, config.height, config.uploadRingSize);
+    trace.reserve(config.traceCapacity);
+    presentationMonitor.init();
+    rasterPool.resize(config.rasterThreads);
+    if (config.pipelineWorkers > 0) framePipeline.start(config.pipelineWorkers, config.pipelineRingSize, config.width, config.height);
+    plans.configure(config.planCacheEntries, config.planCacheBytes);
+    currentPlan = nullptr;
+    held = -1;
+    return true;
+}
+
+void DmdRenderer::release() {
+    framePipeline.stop();
+    if (displayBackend == nullptr) return;
+    if (ourShader != nullptr) {
+        textureUploader.release();
+        gpuRasterizer.release();
+        presentationMonitor.release();
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteProgram(ourShader->ID);
+        delete ourShader;
+        ourShader = nullptr;
+        VAO = VBO = EBO = 0;
+    }
+    displayBackend->release();
+    delete displayBackend;
+    displayBackend = nullptr;
+}
+
+void DmdRenderer::setPattern(const int (*offsets)[2], int count) {
+    tweezerShapes.setPattern(offsets, count);
+    patternVersion++;
+}
+
+uint64_t DmdRenderer::frameKey(const TweezerShapeSpec& shape) const {
+    int parameters[] = { (int)shape.shape, shape.size, shape.maskRows, shape.maskCols, patternVersion };
+    uint64_t hash = hashBytes(FNV_OFFSET_BASIS, parameters, sizeof(parameters));
+    hash = hashBytes(hash, &shape.parameter, sizeof(shape.parameter));
+    if (shape.mask != nullptr) hash = hashBytes(hash, shape.mask, (size_t)shape.maskRows * shape.maskCols);
+    // 0 marks a plan without frames.
+    return hash != 0 ? hash : 1;
+}
+
+ShotResult DmdRenderer::planShot(const ShotRequest& request) {
+    ShotResult result;
+    int occupancyRows = request.occupancyRows;
+    int occupancyCols = request.occupancyCols;
+    for (int i = 0; i < occupancyRows * occupancyCols; i++) {
+        if (request.occupancy[i] == 1) result.numTweezers++;
+    }
+    currentPlan = nullptr;
+    planRows = occupancyRows;
+    planCols = occupancyCols;
+    planFrames = 0;
+    if (result.numTweezers == 0) return result;
+
+    frameContext.prepare(occupancyRows, occupancyCols, result.numTweezers, request.N, config.maxTime);
+    if (plans.enabled()) {
+        currentPlan = plans.find(request.occupancy, occupancyRows, occupancyCols, request.N, request.lattice, config.maxTime,
+                                 request.routing, request.targetPattern);
+        if (currentPlan != nullptr) {
+            frameContext.trajectories.copyFrom(currentPlan->trajectories, currentPlan->numLatticeFrames);
+            result.numLatticeFrames = currentPlan->numLatticeFrames;
+            result.numMoves = request.N * (result.numLatticeFrames - 1) + 1;
+            result.siteSteps = currentPlan->siteSteps;
+            result.assignmentCost = currentPlan->assignmentCost;
+            result.numTargets = currentPlan->numTargets;
+            result.targetsFilled = currentPlan->targetsFilled;
+            result.parkedAtoms = currentPlan->parkedAtoms;
+            result.planCached = true;
+            planFrames = result.numLatticeFrames;
+            return result;
+        }
+    }
+
+    int** tweezerPositions = frameContext.tweezerPositions();
+    for (int i = 0; i < occupancyRows; i++) {
+        for (int j = 0; j < occupancyCols; j++) {
+            tweezerPositions[i][j] = request.occupancy[i * occupancyCols + j];
+        }
+    }
+
+    result.numLatticeFrames = generateFrames(result.numTweezers, occupancyRows, occupancyCols, tweezerPositions, frameContext.trajectories,
+                                             request.N, request.lattice, config.maxTime, request.routing, &frameContext.routing,
+                                             &frameContext.reservation, &frameContext.centerOfMass, request.targetPattern);
+    result.numMoves = request.N * (result.numLatticeFrames - 1) + 1;
+    result.siteSteps = countLatticeMoves(frameContext.trajectories, result.numTweezers, result.numLatticeFrames, request.lattice.topology);
+    planFrames = result.numLatticeFrames;
+    if (request.routing != RoutingMethod::CenterOfMass || request.targetPattern != nullptr) {
+        result.assignmentCost = frameContext.routing.assignmentCost;
+        result.numTargets = frameContext.routing.numTargets;
+        result.targetsFilled = frameContext.routing.targetsFilled;
+        result.parkedAtoms = frameContext.routing.parkedAtoms;
+    }
+
+    if (plans.enabled()) {
+        currentPlan = &plans.insert(frameContext.trajectories, result.numTweezers, result.numLatticeFrames);
+        currentPlan->siteSteps = result.siteSteps;
+        currentPlan->assignmentCost = result.assignmentCost;
+        currentPlan->numTargets = result.numTargets;
+        currentPlan->targetsFilled = result.targetsFilled;
+        currentPlan->parkedAtoms = result.parkedAtoms;
+        plans.trim();
+    }
+    return result;
+}
+
+ShotResult DmdRenderer::runShot(const ShotRequest& request) {
+    trace.beginShot(request.received);
+    if (request.parsed != std::chrono::steady_clock::time_point()) trace.record(TraceEvent::ArgumentsParsed, -1, request.parsed);
+    ShotResult result = planShot(request);
+    trace.record(TraceEvent::RouteDone);
+    return displayShot(request, result);
+}
+
+ShotResult DmdRenderer::replanShot(const ShotRequest& request, int fromFrame, const int8_t* delta) {
+    trace.beginShot(request.received);
+    if (request.parsed != std::chrono::steady_clock::time_point()) trace.record(TraceEvent::ArgumentsParsed, -1, request.parsed);
+    int occupancyRows = request.occupancyRows;
+    int occupancyCols = request.occupancyCols;
+    ReplanWorkspace& workspace = frameContext.replan;
+    int numFrames = 0;
+    // The atoms of a held shot are where it stopped, whatever frame the image was said to be taken in.
+    if (held >= 0) fromFrame = held;
+    else if (fromFrame < 0) fromFrame = 0;
+    if (planFrames > 0 && planRows == occupancyRows && planCols == occupancyCols) {
+        // The plan is moved out of the way, so that the repaired one takes its place without copying it.
+        std::swap(frameContext.trajectories, workspace.previous);
+        numFrames = replanFrames(workspace.previous, planFrames, fromFrame, delta, occupancyRows, occupancyCols, frameContext.trajectories,
+                                 request.N, request.lattice, config.maxTime, workspace, frameContext.reservation, request.targetPattern);
+    }
+    else {
+        // Without a plan of this lattice, the image is taken to have been of the occupancy of the request.
+        workspace.observed.assign(request.occupancy, request.occupancy + occupancyRows * occupancyCols);
+        workspace.lostAtoms = workspace.extraAtoms = 0;
+        for (size_t i = 0; i < workspace.observed.size(); i++) {
+            if (delta[i] == (int8_t)AtomChange::Lost && workspace.observed[i] == 1) workspace.lostAtoms++;
+            else if (delta[i] == (int8_t)AtomChange::Extra && workspace.observed[i] != 1) workspace.extraAtoms++;
+            else continue;
+            workspace.observed[i] = delta[i] == (int8_t)AtomChange::Extra;
+        }
+    }
+
+    ShotResult result;
+    if (numFrames > 0) {
+        result.numTweezers = frameContext.trajectories.numTweezers;
+        result.numLatticeFrames = numFrames;
+        result.numMoves = request.N * (numFrames - 1) + 1;
+        result.siteSteps = countLatticeMoves(frameContext.trajectories, result.numTweezers, numFrames, request.lattice.topology);
+        result.repairedPaths = workspace.repairedPaths;
+        frameContext.prepare(occupancyRows, occupancyCols, result.numTweezers, request.N, config.maxTime);
+        currentPlan = nullptr;
+        planFrames = result.numTweezers > 0 ? numFrames : 0;
+    }
+    else {
+        ShotRequest observed = request;
+        observed.occupancy = workspace.observed.data();
+        result = planShot(observed);
+        result.repairedPaths = -1;
+    }
+    result.lostAtoms = workspace.lostAtoms;
+    result.extraAtoms = workspace.extraAtoms;
+    trace.record(TraceEvent::RouteDone);
+    return displayShot(request, result);
+}
+
+ShotResult DmdRenderer::displayShot(const ShotRequest& request, ShotResult result) {
+    textureUploader.resetStats();
+    double refreshRate = config.refreshRate > 0.0 ? config.refreshRate : displayBackend->refreshRate();
+    presentationMonitor.beginShot(refreshRate > 0.0 ? 1e6 / refreshRate : 0.0);
+    held = -1;
+    if (result.numTweezers == 0) {
+        trace.record(TraceEvent::ShotDone);
+        result.completed = true;
+        return result;
+    }
+
+    if (!framePipeline.running() && !gpuRaster) frameContext.prepareTextures(config.width, config.height, !config.gpuRemap);
+    const TweezerStamp& tweezerStamp = tweezerShapes.get(request.shape);
+
+    // Each RGB frame shows the next 24 binary frames.
+    FrameJob job;
+    job.trajectories = &frameContext.trajectories;
+    job.numMoves = result.numMoves;
+    job.stamp = &tweezerStamp;
+    job.inverted = config.inverted;
+    job.remap = config.gpuRemap ? nullptr : &dmdRemap;
+    job.width = config.width;
+    job.height = config.height;
+    job.pool = &rasterPool;
+    job.trace = trace.enabled() ? &trace : nullptr;
+    // A held shot ends on the move of its hold frame, which its last RGB frame then shows.
+    int holdFrame = request.holdFrame >= 0 ? std::min(request.holdFrame, result.numLatticeFrames - 1) : -1;
+    if (holdFrame >= 0) job.numMoves = request.N * holdFrame + 1;
+    result.numRgbFrames = job.numRgbFrames();
+
+    if (gpuRaster) gpuRasterizer.setStamp(tweezerStamp);
+
+    // With cacheFrames, a cached plan keeps the frames it was last displayed with, which are replayed while the shape is the same.
+    // A held shot shows only some of them, so it neither replays nor keeps any.
+    const uint32_t* cachedFrames = nullptr;
+    uint32_t* recordFrames = nullptr;
+    uint64_t shotFrameKey = 0;
+    if (currentPlan != nullptr && config.cacheFrames && !gpuRaster && holdFrame < 0) {
+        shotFrameKey = frameKey(request.shape);
+        if (currentPlan->frameKey == shotFrameKey) {
+            cachedFrames = currentPlan->frames.data();
+            result.framesCached = true;
+        }
+        else {
+            currentPlan->frameKey = 0;
+            if (plans.reserveFrames(*currentPlan, (size_t)config.width * config.height * result.numRgbFrames)) {
+                recordFrames = currentPlan->frames.data();
+            }
+        }
+    }
+
+    Playback playback = playFrames(job, cachedFrames, recordFrames, holdFrame >= 0);
+    PacingReport& pacing = presentationMonitor.report();
+    if (recordFrames != nullptr && playback == Playback::Completed) {
+        currentPlan->frameKey = shotFrameKey;
+        plans.trim();
+    }
+    presentationMonitor.endShot();
+    pacing.aborted = playback == Playback::PacingFault;
+    result.completed = playback == Playback::Completed || playback == Playback::Held;
+    result.held = playback == Playback::Held;
+    if (result.held) held = holdFrame;
+    trace.record(TraceEvent::ShotDone);
+    return result;
+}
+
+DmdRenderer::Playback DmdRenderer::playFrames(const FrameJob& job, const uint32_t* cachedFrames, uint32_t* recordFrames, bool hold) {
+    bool pipelined = framePipeline.running() && !gpuRaster && cachedFrames == nullptr;
+    size_t frameSize = (size_t)config.width * config.height;
+    uint32_t* textureArray = frameContext.textureArray.data();
+    uint32_t* dmdTextureArray = frameContext.dmdTextureArray.data();
+    int numRgbFrames = job.numRgbFrames();
+
+    int iter = 0;
+    if (pipelined) framePipeline.beginShot(job);
+    DisplayBackend* display = displayBackend;
+    if (display->capture.enabled()) display->capture.beginShot();
+
+    // present: draws and presents the current frame from the texture it was uploaded to (or the packed texture), so that a reissue need not upload it again.
+    auto present = [&]() {
+        if (config.whiteColor) {
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        else {
+            ourShader->use();
+            glBindVertexArray(VAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
+        if (display->capture.enabled()) display->captureFrame();
+        presentationMonitor.beforePresent(iter);
+        display->present();
+        trace.record(TraceEvent::PresentDone, iter);
+        return presentationMonitor.afterPresent(iter);
+    };
+
+    while (!display->shouldClose()) {
+        if (iter >= numRgbFrames) {
+            if (pipelined) framePipeline.endShot();
+            if (hold) return Playback::Held;
+            clearDisplay();
+            return Playback::Completed;
+        }
+        else {
+            const uint32_t* frame = nullptr;
+            if (cachedFrames != nullptr) {
+                frame = cachedFrames + frameSize * iter;
+            }
+            else if (gpuRaster) {
+                int firstMove = iter * SUBFRAMES_PER_FRAME;
+                gpuRasterizer.rasterize(*job.trajectories, firstMove, std::min(SUBFRAMES_PER_FRAME, job.numMoves - firstMove));
+                trace.record(TraceEvent::RasterDone, iter);
+            }
+            else if (pipelined) {
+                frame = framePipeline.acquire(iter);
+            }
+            else {
+                // DMD pixels outside the remapped image never change, so they are only filled when the buffer is first created.
+                if (!config.gpuRemap && !frameContext.dmdBorderFilled) {
+                    dmdRemap.fillOutside(dmdTextureArray, config.inverted ? ALL_SUBFRAMES_MASK : 0);
+                    frameContext.dmdBorderFilled = true;
+                }
+                frame = renderFrame(job, iter, textureArray, dmdTextureArray);
+            }
+            if (recordFrames != nullptr) std::copy_n(frame, frameSize, recordFrames + frameSize * iter);
+
+            if (!config.whiteColor) {
+                if (gpuRaster) {
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_2D, gpuRasterizer.packedTexture);
+                    glActiveTexture(GL_TEXTURE0);
+                }
+                else {
+                    textureUploader.upload(frame);
+                    trace.record(TraceEvent::UploadDone, iter);
+                }
+            }
+
+            // The frame has been copied into a PBO, so its slot can go back to the producers.
+            if (pipelined) framePipeline.release(iter);
+
+            // The atoms have followed the tweezers up to a late frame, so a reissue shows that frame again, for as long as it comes
+            // late and the budget lasts, and the shot goes on from there; going back to the first frame, or clearing the display, would
+            // lose them. A dropped frame is the one before, which the texture no longer holds, so it cannot be reissued.
+            PacingFault fault = present();
+            PacingReport& pacing = presentationMonitor.report();
+            bool reissue = config.pacingAction == PacingAction::Reissue && fault == PacingFault::Late;
+            while (reissue && fault != PacingFault::None && pacing.reissues < config.maxReissues) {
+                pacing.reissues++;
+                fault = present();
+            }
+            if (fault != PacingFault::None && config.pacingAction != PacingAction::Report) {
+                if (pipelined) framePipeline.endShot();
+                clearDisplay();
+                return Playback::PacingFault;
+            }
+
+            iter++;
+        }
+
+        display->pollEvents();
+    }
+    if (pipelined) framePipeline.endShot();
+    return Playback::Closed;
+}
+
+void DmdRenderer::clearDisplay() {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    displayBackend->present();
+}
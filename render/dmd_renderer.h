@@ -0,0 +1,200 @@
+#ifndef DMD_RENDERER_H
+#define DMD_RENDERER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../core/dmd_remap.h"
+#include "../core/frame_context.h"
+#include "../core/frame_pacing.h"
+#include "../core/frame_pipeline.h"
+#include "../core/latency_trace.h"
+#include "../core/plan_cache.h"
+#include "../core/router.h"
+#include "../core/thread_pool.h"
+#include "../core/trajectory_smoothing.h"
+#include "../core/tweezer_shapes.h"
+#include "display_backend.h"
+#include "gpu_rasterizer.h"
+#include "presentation_monitor.h"
+#include "texture_uploader.h"
+
+class Shader;
+
+// DmdRendererConfig: the modes of operation of a DmdRenderer. The defaults are those used with the DMD.
+struct DmdRendererConfig {
+    int width = 1140;                      // the size of the DMD screen, in pixels
+    int height = 912;
+    int rowOffset = 607;                   // the offset added to rowAlgorithm() when remapping (see DmdRemap)
+    bool headless = false;                 // render offscreen through EGL instead of opening a window (see EglBackend)
+    bool useSecondMonitor = true;          // open the window full screen on the second monitor (the DMD)
+    bool whiteColor = false;               // display white in place of every frame
+    bool inverted = true;                  // flip every pixel of every binary frame
+    bool gpuRemap = false;                 // remap in the fragment shader instead of on the CPU
+    bool gpuRaster = false;                // draw the tweezers on the GPU (see GpuRasterizer)
+    GpuRasterPath gpuRasterPath = GpuRasterPath::Automatic;
+    int pipelineWorkers = 2;               // threads producing frames ahead of the display (see FramePipeline); 0 to render in line
+    int pipelineRingSize = 4;
+    int rasterThreads = 4;                 // threads splitting a single frame into tiles (see rasterizeFrame)
+    int uploadRingSize = 3;                // pixel buffer objects used to stream frames (see TextureUploader)
+    int maxTime = 40;                      // the maximum number of lattice moves in a shot
+    std::string shaderDirectory;           // the directory holding the .vs, .fs and .cs files (empty for the working directory)
+    std::string captureDirectory;          // write every displayed frame here as a PPM file, if not empty (see FrameCapture)
+    bool captureToMemory = false;          // keep every displayed frame of the last shot in display()->capture
+    int traceCapacity = 0;                 // the number of timestamps kept in latencyTrace() (0 to disable tracing)
+    double refreshRate = 0.0;              // the refresh rate frames are paced against, in Hz (0 for the display's own, if known)
+    PacingAction pacingAction = PacingAction::Report;
+    int maxReissues = 2;                   // with PacingAction::Reissue, the presents of late frames repeated in a shot before it is
+                                           // aborted; a frame late again when repeated is repeated again, out of the same budget
+    int planCacheEntries = 0;              // the number of plans kept for shots seen before (see PlanCache); 0 disables the cache
+    size_t planCacheBytes = (size_t)256 << 20;  // the memory the plan cache may hold, evicting the least recently used plans beyond it
+    bool cacheFrames = false;              // also keep the RGB frames of cached plans, so that a repeated shot is not rasterized again
+};
+
+// ShotRequest: one rearrangement: the occupancy matrix, how to route and smooth it, and the shape to draw for each tweezer.
+struct ShotRequest {
+    const uint8_t* occupancy = nullptr;    // row-major occupancyRows * occupancyCols matrix, 1 where a site holds an atom
+    int occupancyRows = 0;
+    int occupancyCols = 0;
+    int N = 1;                             // the smoothing factor
+    LatticeGeometry lattice;
+    TweezerShapeSpec shape;
+    RoutingMethod routing = RoutingMethod::CenterOfMass;
+    const uint8_t* targetPattern = nullptr;  // row-major matrix of TargetSite values to route onto, or null for the center of mass
+    // The lattice frame to stop the shot at (the last one if beyond it), leaving it on the display for an image and replanShot to
+    // continue from; -1 plays the shot to the end and clears the display.
+    int holdFrame = -1;
+    // When the request arrived and when its arguments had been parsed, for the latency trace (left at the clock's epoch, the shot is
+    // traced from the call to runShot and without an ArgumentsParsed event).
+    std::chrono::steady_clock::time_point received;
+    std::chrono::steady_clock::time_point parsed;
+};
+
+// ShotResult: what a shot produced.
+struct ShotResult {
+    int numTweezers = 0;
+    int numLatticeFrames = 0;              // lattice frames routed, including the initial configuration
+    int numMoves = 0;                      // smoothed moves, one per binary subframe
+    int numRgbFrames = 0;                  // RGB frames displayed
+    long long siteSteps = 0;               // single-site steps taken by the tweezers over all lattice frames
+    // With assignment or reservation routing, or a target pattern: the total lattice distance of the optimal assignment, the number
+    // of target sites, those holding an atom in the last lattice frame, and the surplus atoms sent to reservoir sites.
+    long long assignmentCost = 0;
+    int numTargets = 0;
+    int targetsFilled = 0;
+    int parkedAtoms = 0;
+    // With replanShot: the atoms found lost and extra by the image, and the paths searched again to repair the plan (-1 if it could not
+    // be repaired, and the occupancy found by the image was routed from scratch).
+    int lostAtoms = 0;
+    int extraAtoms = 0;
+    int repairedPaths = 0;
+    bool planCached = false;               // the plan was taken from the plan cache, without routing
+    bool framesCached = false;             // the RGB frames were taken from the plan cache, without rasterizing
+    bool completed = false;                // false if the display was closed, or the shot aborted on a pacing fault, before the end
+    bool held = false;                     // the shot stopped at ShotRequest::holdFrame, which is left on the display
+};
+
+// DmdRenderer: turns occupancy matrices into the RGB frames shown on the DMD, independently of MATLAB. It owns the display, every
+// OpenGL object and the frame-production threads, and reuses all of them from shot to shot. Requests are served one at a time on the
+// thread that called init(), which holds the OpenGL context.
+class DmdRenderer {
+public:
+    DmdRenderer();
+    ~DmdRenderer();
+
+    // init: opens the display and sets up rendering. Returns false if the display or the shaders could not be set up.
+    bool init(const DmdRendererConfig& config);
+
+    // release: frees every resource and closes the display.
+    void release();
+
+    // setPattern: sets the shape drawn for TweezerShape::Pattern (see TweezerShapeRegistry::setPattern).
+    void setPattern(const int (*offsets)[2], int count);
+
+    // planShot: routes and smooths a shot without displaying it; the moves are left in context().trajectories.
+    ShotResult planShot(const ShotRequest& request);
+
+    // runShot: plans a shot and displays all of its frames, then clears the display, or, with request.holdFrame, displays them up to
+    // that lattice frame and leaves it there. Every present is timed (see pacingReport()), and a late or dropped frame is handled as
+    // configured by pacingAction.
+    ShotResult runShot(const ShotRequest& request);
+
+    // replanShot: repairs the plan of the last shot from one of its lattice frames, after an image taken there, and displays the rest of
+    // it. Only the paths affected by the atoms found lost or extra are planned again (see replanFrames), so that the display continues
+    // from that frame; if the plan cannot be repaired, or there is none for this lattice, the occupancy found by the image is routed
+    // from scratch as by runShot. A shot held at a frame (see ShotRequest::holdFrame) is continued from it without the display going
+    // dark, and repairs can follow one another, each holding a frame of the plan left by the last.
+    // Inputs:
+    //      request: the shot being repaired: its lattice, smoothing factor, shape and target pattern; its occupancy is only read when
+    //               there is no plan to repair, and the delta is then applied to it
+    //      fromFrame: the lattice frame of the last plan in which the image was taken (0 being its initial configuration), or -1 for
+    //                 the frame it is held at (0 if it is not held); while a frame is held, the atoms are there, and it is used whatever
+    //                 fromFrame is
+    //      delta: a row-major matrix of AtomChange values with the dimensions of the occupancy matrix
+    ShotResult replanShot(const ShotRequest& request, int fromFrame, const int8_t* delta);
+
+    const DmdRendererConfig& configuration() const { return config; }
+    DisplayBackend* display() { return displayBackend; }
+    const FrameContext& context() const { return frameContext; }
+    const TextureUploader::UploadStats& uploadStats() const { return textureUploader.stats; }
+    const FramePipeline::PipelineStats& pipelineStats() const { return framePipeline.stats; }
+    bool usingGpuRaster() const { return gpuRaster; }
+    const LatencyTrace& latencyTrace() const { return trace; }
+    const PacingReport& pacingReport() const { return presentationMonitor.report(); }
+    const PlanCache& planCache() const { return plans; }
+    int heldFrame() const { return held; }
+
+private:
+    enum class Playback { Completed, Held, Closed, PacingFault };
+
+    // displayShot: displays all of the frames of the planned shot, then clears the display (see runShot), and completes its result.
+    ShotResult displayShot(const ShotRequest& request, ShotResult result);
+
+    // playFrames: displays the frames of a job from the first, stopping early if the display is closed or, unless faults are only
+    // reported, at the first pacing fault that is not reissued. With cachedFrames, the frames are uploaded from there instead of
+    // being rendered; with recordFrames, every rendered frame is also copied there. With hold, the last frame is left on the display.
+    Playback playFrames(const FrameJob& job, const uint32_t* cachedFrames = nullptr, uint32_t* recordFrames = nullptr,
+                        bool hold = false);
+
+    // frameKey: the key of the frames of a shot drawn with the given shape, under which they are kept in a CachedPlan.
+    uint64_t frameKey(const TweezerShapeSpec& shape) const;
+
+    // clearDisplay: presents a black frame.
+    void clearDisplay();
+
+    DmdRendererConfig config;
+    DisplayBackend* displayBackend = nullptr;
+    Shader* ourShader = nullptr;
+    unsigned int VBO = 0, VAO = 0, EBO = 0;
+    TextureUploader textureUploader;
+    GpuRasterizer gpuRasterizer;
+    bool gpuRaster = false;
+    //    Precomputed transform from the generated image into the DMD coordinate system.
+    DmdRemap dmdRemap;
+    //    Compiled tweezer shapes.
+    TweezerShapeRegistry tweezerShapes;
+    //    Worker threads producing frames for the display loop, and threads that split a single frame into tiles.
+    FramePipeline framePipeline;
+    ThreadPool rasterPool;
+    //    Per-shot buffers, kept between calls so that frame generation does not allocate once they have been sized.
+    FrameContext frameContext;
+    //    Timestamps of the hot path of recent shots.
+    LatencyTrace trace;
+    //    Timing of every present against the refresh of the display.
+    PresentationMonitor presentationMonitor;
+    //    Plans of shots seen before, and the one of the current shot (null if the cache is disabled).
+    PlanCache plans;
+    CachedPlan* currentPlan = nullptr;
+    //    The lattice and lattice frames of the plan in frameContext.trajectories, for replanShot (no frames if there is none).
+    int planRows = 0, planCols = 0, planFrames = 0;
+    //    The lattice frame of that plan left on the display by the last shot, or -1 if it was cleared.
+    int held = -1;
+    //    Incremented by setPattern, so that frames drawn with an earlier pattern are not reused.
+    int patternVersion = 0;
+};
+
+#endif
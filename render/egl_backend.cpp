@@ -0,0 +1,118 @@
+#include "egl_backend.h"
+
+#include <iostream>
+
+#ifdef DMD_USE_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+EglBackend::~EglBackend() {
+    release();
+}
+
+// createContext: creates a core profile context of the given version, or returns EGL_NO_CONTEXT.
+static EGLContext createContext(EGLDisplay display, int majorVersion, int minorVersion) {
+    const EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    return eglCreateContext(display, (EGLConfig)0, EGL_NO_CONTEXT, attributes);
+}
+
+bool EglBackend::init(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay == NULL) {
+        std::cout << "EGL_EXT_platform_base is not supported" << std::endl;
+        return false;
+    }
+    EGLDisplay eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, NULL, NULL)) {
+        std::cout << "Failed to initialize the surfaceless EGL display" << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+    eglBindAPI(EGL_OPENGL_API);
+
+    // Fall back to the 3.3 core profile that the windowed backend uses.
+    EGLContext eglContext = createContext(eglDisplay, majorVersion, minorVersion);
+    if (eglContext == EGL_NO_CONTEXT) eglContext = createContext(eglDisplay, 3, 3);
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+        std::cout << "Failed to create an EGL context" << std::endl;
+        release();
+        return false;
+    }
+    context = eglContext;
+
+    // The target framebuffer needs the OpenGL entry points, which are only loaded once the context is current.
+    if (!gladLoadGLLoader(procLoader())) {
+        std::cout << "Failed to initialize GLAD." << std::endl;
+        release();
+        return false;
+    }
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Failed to create the offscreen framebuffer" << std::endl;
+        release();
+        return false;
+    }
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+void EglBackend::release() {
+    if (context != nullptr) {
+        if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
+        if (colorBuffer) glDeleteRenderbuffers(1, &colorBuffer);
+        framebuffer = colorBuffer = 0;
+        eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+        context = nullptr;
+    }
+    if (display != nullptr) {
+        eglTerminate((EGLDisplay)display);
+        display = nullptr;
+    }
+}
+
+GLADloadproc EglBackend::procLoader() const {
+    return (GLADloadproc)eglGetProcAddress;
+}
+
+// present: there is nothing to swap, so wait for the frame instead; this keeps per-frame timings comparable with a real swap.
+void EglBackend::present() {
+    glFinish();
+}
+
+#else
+
+EglBackend::~EglBackend() {
+}
+
+bool EglBackend::init(int width, int height) {
+    std::cout << "Headless rendering is not available: build with DMD_USE_EGL and link against EGL" << std::endl;
+    return false;
+}
+
+void EglBackend::release() {
+}
+
+GLADloadproc EglBackend::procLoader() const {
+    return NULL;
+}
+
+void EglBackend::present() {
+}
+
+#endif
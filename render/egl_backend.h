@@ -0,0 +1,30 @@
+#ifndef EGL_BACKEND_H
+#define EGL_BACKEND_H
+
+#include "display_backend.h"
+
+// EglBackend: renders without any display, through a surfaceless EGL context (EGL_MESA_platform_surfaceless, which Mesa provides on any
+// Linux machine, with llvmpipe when there is no GPU). Frames are drawn into an RGBA8 framebuffer object of the DMD's size, and presenting
+// waits for the frame to finish, in place of a swap. Built only when DMD_USE_EGL is defined; otherwise init always fails.
+class EglBackend : public DisplayBackend {
+public:
+    ~EglBackend();
+
+    bool init(int width, int height) override;
+    void release() override;
+    GLADloadproc procLoader() const override;
+    GLuint targetFramebuffer() const override { return framebuffer; }
+    void present() override;
+
+    // The OpenGL version requested; 4.3 enables the compute shader paths.
+    int majorVersion = 4;
+    int minorVersion = 3;
+
+private:
+    void* display = nullptr;
+    void* context = nullptr;
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+};
+
+#endif
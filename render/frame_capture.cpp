@@ -0,0 +1,65 @@
+#include "frame_capture.h"
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <cstring>
+
+void FrameCapture::beginShot() {
+    shot++;
+    numFrames = 0;
+    frames.clear();
+}
+
+void FrameCapture::grab(int width, int height) {
+    this->width = width;
+    this->height = height;
+    frameBytes = (size_t)width * height * 3;
+    readBack.resize(frameBytes);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, readBack.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    // OpenGL returns the bottom row first.
+    uint8_t* dst = readBack.data();
+    if (toMemory) {
+        frames.resize((size_t)(numFrames + 1) * frameBytes);
+        dst = frames.data() + (size_t)numFrames * frameBytes;
+    }
+    size_t rowBytes = (size_t)width * 3;
+    if (dst != readBack.data()) {
+        for (int row = 0; row < height; row++) {
+            memcpy(dst + row * rowBytes, readBack.data() + (size_t)(height - 1 - row) * rowBytes, rowBytes);
+        }
+    }
+    else {
+        for (int row = 0; row < height / 2; row++) {
+            uint8_t* top = dst + row * rowBytes;
+            uint8_t* bottom = dst + (size_t)(height - 1 - row) * rowBytes;
+            for (size_t k = 0; k < rowBytes; k++) {
+                uint8_t t = top[k];
+                top[k] = bottom[k];
+                bottom[k] = t;
+            }
+        }
+    }
+
+    if (!directory.empty()) {
+        char name[64];
+        snprintf(name, sizeof(name), "/shot_%04d_frame_%04d.ppm", shot < 0 ? 0 : shot, numFrames);
+        if (!writePPM(directory + name, dst, width, height)) {
+            fprintf(stderr, "Failed to write %s%s\n", directory.c_str(), name);
+        }
+    }
+    numFrames++;
+}
+
+bool FrameCapture::writePPM(const std::string& path, const uint8_t* rgb, int width, int height) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL) return false;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    size_t bytes = (size_t)width * height * 3;
+    bool written = fwrite(rgb, 1, bytes, file) == bytes;
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,42 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// FrameCapture: copies displayed frames back from the GPU, as 8-bit RGB with the top row first (the way the DMD shows them), either
+// into memory or into one binary PPM file per frame. Used to regression-test and profile the renderer without looking at the DMD.
+class FrameCapture {
+public:
+    // enabled: whether any output is configured. Capturing costs a full read back per frame, so it is off by default.
+    bool enabled() const { return toMemory || !directory.empty(); }
+
+    // beginShot: starts numbering frames from zero and drops the frames kept from the previous shot.
+    void beginShot();
+
+    // grab: reads the width * height frame from the bound read framebuffer. Requires a current OpenGL context.
+    void grab(int width, int height);
+
+    // frame: the RGB pixels of the i-th frame kept in memory in the current shot.
+    const uint8_t* frame(int i) const { return frames.data() + (size_t)i * frameBytes; }
+
+    // writePPM: writes width * height RGB pixels (top row first) as a binary PPM. Returns false if the file could not be written.
+    static bool writePPM(const std::string& path, const uint8_t* rgb, int width, int height);
+
+    bool toMemory = false;       // keep every frame of the current shot in frames
+    std::string directory;       // write shot_SSSS_frame_FFFF.ppm files here, if not empty
+
+    int shot = -1;
+    int numFrames = 0;
+    int width = 0;
+    int height = 0;
+    size_t frameBytes = 0;
+    std::vector<uint8_t> frames;
+
+private:
+    std::vector<uint8_t> readBack;
+};
+
+#endif
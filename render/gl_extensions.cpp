@@ -0,0 +1,41 @@
+#include "gl_extensions.h"
+
+#include <cstring>
+
+GLExtensions glExtensions;
+
+bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static bool atLeast(int major, int minor) {
+    return glExtensions.majorVersion > major || (glExtensions.majorVersion == major && glExtensions.minorVersion >= minor);
+}
+
+void loadGLExtensions(GLADloadproc load) {
+    glExtensions = GLExtensions();
+    glGetIntegerv(GL_MAJOR_VERSION, &glExtensions.majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &glExtensions.minorVersion);
+
+    if (atLeast(4, 2) || hasGLExtension("GL_ARB_texture_storage")) {
+        glExtensions.TexStorage2D = (PFNGLTEXSTORAGE2DEXTPROC)load("glTexStorage2D");
+        glExtensions.textureStorage = glExtensions.TexStorage2D != nullptr;
+    }
+    if (atLeast(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+        glExtensions.BufferStorage = (PFNGLBUFFERSTORAGEEXTPROC)load("glBufferStorage");
+        glExtensions.bufferStorage = glExtensions.BufferStorage != nullptr;
+    }
+    if (atLeast(4, 3) || (hasGLExtension("GL_ARB_compute_shader") && hasGLExtension("GL_ARB_shader_image_load_store") &&
+                          hasGLExtension("GL_ARB_shader_storage_buffer_object"))) {
+        glExtensions.DispatchCompute = (PFNGLDISPATCHCOMPUTEEXTPROC)load("glDispatchCompute");
+        glExtensions.MemoryBarrier = (PFNGLMEMORYBARRIEREXTPROC)load("glMemoryBarrier");
+        glExtensions.BindImageTexture = (PFNGLBINDIMAGETEXTUREEXTPROC)load("glBindImageTexture");
+        glExtensions.computeShader = glExtensions.DispatchCompute && glExtensions.MemoryBarrier && glExtensions.BindImageTexture;
+    }
+}
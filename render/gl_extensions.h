@@ -0,0 +1,70 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// The bundled glad loader only covers OpenGL 3.3 core. Entry points from later versions (or the equivalent ARB extensions) are
+// loaded here when the driver provides them, and each group is flagged so that callers can fall back to 3.3 behaviour otherwise.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DEXTPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEEXTPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEEXTPROC)(GLuint numGroupsX, GLuint numGroupsY, GLuint numGroupsZ);
+typedef void (APIENTRYP PFNGLMEMORYBARRIEREXTPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREEXTPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+                                                      GLenum access, GLenum format);
+
+// GLExtensions: optional entry points beyond OpenGL 3.3.
+struct GLExtensions {
+    int majorVersion = 3;
+    int minorVersion = 3;
+
+    // GL 4.2 / ARB_texture_storage: immutable texture storage.
+    bool textureStorage = false;
+    PFNGLTEXSTORAGE2DEXTPROC TexStorage2D = nullptr;
+
+    // GL 4.4 / ARB_buffer_storage: immutable buffer storage, which allows persistently mapped buffers.
+    bool bufferStorage = false;
+    PFNGLBUFFERSTORAGEEXTPROC BufferStorage = nullptr;
+
+    // GL 4.3 / ARB_compute_shader with ARB_shader_image_load_store and ARB_shader_storage_buffer_object: compute shaders.
+    bool computeShader = false;
+    PFNGLDISPATCHCOMPUTEEXTPROC DispatchCompute = nullptr;
+    PFNGLMEMORYBARRIEREXTPROC MemoryBarrier = nullptr;
+    PFNGLBINDIMAGETEXTUREEXTPROC BindImageTexture = nullptr;
+};
+
+extern GLExtensions glExtensions;
+
+// loadGLExtensions: fills in glExtensions for the current context. Must be called after gladLoadGLLoader().
+void loadGLExtensions(GLADloadproc load);
+
+// hasGLExtension: whether the current context advertises the named extension.
+bool hasGLExtension(const char* name);
+
+#endif
@@ -0,0 +1,114 @@
+#include "glfw_backend.h"
+
+#include <iostream>
+
+#ifndef DMD_NO_GLFW
+
+#include <GLFW/glfw3.h>
+
+// framebuffer_size_callback: resizes viewport on resizing of window
+static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+GlfwBackend::GlfwBackend(bool useSecondMonitor) : useSecondMonitor(useSecondMonitor) {
+}
+
+bool GlfwBackend::init(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    // GLFW Setup
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    if (useSecondMonitor) {
+        int count;
+        GLFWmonitor** monitors = glfwGetMonitors(&count);
+        if (count < 2) {
+            std::cout << "DMD Not Connected" << std::endl;
+            return false;
+        }
+        monitor = monitors[1];
+        glfwWindowHint(GLFW_AUTO_ICONIFY, GLFW_FALSE);
+        window = glfwCreateWindow(width, height, "DMD Test Window", monitor, NULL);
+    }
+    else window = glfwCreateWindow(width, height, "DMD Test Window", NULL, NULL);
+
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // Every RGB frame must be shown for exactly one refresh, so swaps wait for vertical sync.
+    glfwSwapInterval(1);
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    monitorRefreshRate = mode ? mode->refreshRate : 0.0;
+
+    return true;
+}
+
+void GlfwBackend::release() {
+    window = nullptr;
+    glfwTerminate();
+}
+
+GLADloadproc GlfwBackend::procLoader() const {
+    return (GLADloadproc)glfwGetProcAddress;
+}
+
+void GlfwBackend::present() {
+    glfwSwapBuffers(window);
+}
+
+bool GlfwBackend::shouldClose() {
+    return window == nullptr || glfwWindowShouldClose(window);
+}
+
+// pollEvents: processes window events, and closes the window if the escape key is being pressed.
+void GlfwBackend::pollEvents() {
+    glfwPollEvents();
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+}
+
+#else
+
+GlfwBackend::GlfwBackend(bool useSecondMonitor) : useSecondMonitor(useSecondMonitor) {
+}
+
+bool GlfwBackend::init(int, int) {
+    std::cout << "Windowed display is not available: built with DMD_NO_GLFW" << std::endl;
+    return false;
+}
+
+void GlfwBackend::release() {
+}
+
+GLADloadproc GlfwBackend::procLoader() const {
+    return NULL;
+}
+
+void GlfwBackend::present() {
+}
+
+bool GlfwBackend::shouldClose() {
+    return true;
+}
+
+void GlfwBackend::pollEvents() {
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef GLFW_BACKEND_H
+#define GLFW_BACKEND_H
+
+#include "display_backend.h"
+
+struct GLFWwindow;
+
+// GlfwBackend: presents frames in a GLFW window, either full screen on the second monitor (the DMD) or as an ordinary window. Builds
+// without GLFW (on servers with only EGL) define DMD_NO_GLFW, in which case init always fails.
+class GlfwBackend : public DisplayBackend {
+public:
+    // Inputs:
+    //      useSecondMonitor: whether to open the window full screen on the second monitor, failing if only one is connected
+    explicit GlfwBackend(bool useSecondMonitor);
+
+    bool init(int width, int height) override;
+    void release() override;
+    GLADloadproc procLoader() const override;
+    void present() override;
+    double refreshRate() const override { return monitorRefreshRate; }
+    bool shouldClose() override;
+    void pollEvents() override;
+
+    GLFWwindow* window = nullptr;
+
+private:
+    bool useSecondMonitor;
+    double monitorRefreshRate = 0.0;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "gpu_rasterizer.h"
+#include "gl_extensions.h"
+#include "compute_shader.h"
+
+#include <shader_s.h>
+
+#include <cstring>
+
+const int COMPUTE_GROUP_SIZE = 64;
+
+GpuRasterizer::GpuRasterizer() {
+}
+
+GpuRasterizer::~GpuRasterizer() {
+    delete computeShader;
+    delete instancedShader;
+}
+
+bool GpuRasterizer::init(int width, int height, GpuRasterPath path, GLuint quadVBO, GLuint quadEBO, const std::string& shaderDirectory) {
+    this->width = width;
+    this->height = height;
+
+    glGenTextures(1, &packedTexture);
+    glBindTexture(GL_TEXTURE_2D, packedTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    if (glExtensions.textureStorage) glExtensions.TexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+    else glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+    // The framebuffer is used to clear the packed texture on both paths, and as the render target of the instanced path.
+    GLint displayFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &displayFramebuffer);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, packedTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, displayFramebuffer);
+    if (!complete) return false;
+
+    glGenTextures(1, &stampTexture);
+    glBindTexture(GL_TEXTURE_2D, stampTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glGenBuffers(1, &positionBuffer);
+
+    usingCompute = false;
+    if (path != GpuRasterPath::Instanced && glExtensions.computeShader) {
+        computeShader = new ComputeShader((shaderDirectory + "tweezer.cs").c_str());
+        usingCompute = computeShader->valid;
+        if (usingCompute) return true;
+        delete computeShader;
+        computeShader = nullptr;
+    }
+
+    instancedShader = new Shader((shaderDirectory + "tweezer.vs").c_str(), (shaderDirectory + "tweezer.fs").c_str());
+    glGenVertexArrays(1, &quadVAO);
+    glBindVertexArray(quadVAO);
+    if (quadVBO == 0 || quadEBO == 0) {
+        // Same layout as the display quad: position, color and texture coordinates per vertex.
+        const float vertices[32] = {
+            1.0f, 1.0f, 0.0f,   0.0f, 0.0f, 0.0f,   1.0f, 1.0f,
+            1.0f, 0.0f, 0.0f,   0.0f, 0.0f, 0.0f,   1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f,   0.0f, 0.0f, 0.0f,   0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f,   0.0f, 0.0f, 0.0f,   0.0f, 1.0f
+        };
+        const unsigned int indices[6] = { 0, 1, 3,   1, 2, 3 };
+        glGenBuffers(1, &quadVBO);
+        glGenBuffers(1, &quadEBO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        this->quadVBO = quadVBO;
+        this->quadEBO = quadEBO;
+        ownsQuad = true;
+    }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+    }
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLint linked = 0;
+    glGetProgramiv(instancedShader->ID, GL_LINK_STATUS, &linked);
+    return linked != 0;
+}
+
+void GpuRasterizer::release() {
+    if (quadVAO) glDeleteVertexArrays(1, &quadVAO);
+    if (ownsQuad) {
+        glDeleteBuffers(1, &quadVBO);
+        glDeleteBuffers(1, &quadEBO);
+    }
+    ownsQuad = false;
+    quadEBO = 0;
+    if (positionBuffer) glDeleteBuffers(1, &positionBuffer);
+    if (stampTexture) glDeleteTextures(1, &stampTexture);
+    if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
+    if (packedTexture) glDeleteTextures(1, &packedTexture);
+    quadVAO = quadVBO = positionBuffer = stampTexture = framebuffer = packedTexture = 0;
+    positionCapacity = 0;
+    delete computeShader;
+    computeShader = nullptr;
+    if (instancedShader) glDeleteProgram(instancedShader->ID);
+    delete instancedShader;
+    instancedShader = nullptr;
+}
+
+void GpuRasterizer::setStamp(const TweezerStamp& stamp) {
+    int rows = stamp.rowMax - stamp.rowMin + 1;
+    int cols = stamp.colMax - stamp.colMin;
+    if (rows <= 0 || cols <= 0) {
+        rows = cols = 1;
+        stampMask.assign(1, 0);
+    }
+    else {
+        stampMask.assign((size_t)rows * cols, 0);
+        for (const StampSpan& span : stamp.spans) {
+            uint8_t* row = stampMask.data() + (size_t)(span.row - stamp.rowMin) * cols;
+            memset(row + (span.colBegin - stamp.colMin), 1, span.colEnd - span.colBegin);
+        }
+    }
+    stampOriginRow = stamp.rowMin;
+    stampOriginCol = stamp.colMin;
+
+    glBindTexture(GL_TEXTURE_2D, stampTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, cols, rows, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, stampMask.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void GpuRasterizer::rasterize(const TrajectoryStore& trajectories, int firstMove, int numSubframes) {
+    int numTweezers = trajectories.numTweezers;
+    size_t count = (size_t)numTweezers * numSubframes;
+
+    // The moves of consecutive subframes are adjacent in the store, so each frame's x and y coordinates are two contiguous blocks.
+    size_t blockBytes = count * sizeof(float);
+    lastUploadBytes = 2 * blockBytes;
+    GLenum target = usingCompute ? GL_SHADER_STORAGE_BUFFER : GL_ARRAY_BUFFER;
+    glBindBuffer(target, positionBuffer);
+    if (lastUploadBytes > positionCapacity) {
+        positionCapacity = lastUploadBytes;
+        glBufferData(target, positionCapacity, NULL, GL_STREAM_DRAW);
+    }
+    if (count > 0) {
+        glBufferSubData(target, 0, blockBytes, trajectories.moveX(firstMove));
+        glBufferSubData(target, blockBytes, blockBytes, trajectories.moveY(firstMove));
+    }
+    glBindBuffer(target, 0);
+
+    // The display may draw into a framebuffer object of its own (see display_backend.h), so the previous binding is restored after.
+    GLint viewport[4], displayFramebuffer = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &displayFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    const GLuint zero[4] = { 0, 0, 0, 0 };
+    glClearBufferuiv(GL_COLOR, 0, zero);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, stampTexture);
+
+    if (count > 0 && usingCompute) {
+        computeShader->use();
+        computeShader->setInt("stampMask", 0);
+        computeShader->setIVec2("stampOrigin", stampOriginCol, stampOriginRow);
+        computeShader->setInt("numTweezers", numTweezers);
+        computeShader->setInt("numSubframes", numSubframes);
+        computeShader->setIVec2("screenSize", width, height);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionBuffer);
+        glExtensions.BindImageTexture(0, packedTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+        glExtensions.DispatchCompute((GLuint)((count + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE), 1, 1);
+        glExtensions.MemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    else if (count > 0) {
+        instancedShader->use();
+        instancedShader->setInt("stampMask", 0);
+        instancedShader->setIVec2("stampOrigin", stampOriginCol, stampOriginRow);
+        instancedShader->setInt("numTweezers", numTweezers);
+        instancedShader->setIVec2("screenSize", width, height);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(count * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glEnable(GL_COLOR_LOGIC_OP);
+        glLogicOp(GL_OR);
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)count);
+        glDisable(GL_COLOR_LOGIC_OP);
+        glBindVertexArray(0);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, displayFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,78 @@
+#ifndef GPU_RASTERIZER_H
+#define GPU_RASTERIZER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../core/trajectory_store.h"
+#include "../core/tweezer_stamp.h"
+
+class ComputeShader;
+class Shader;
+
+// GpuRasterPath: the way GpuRasterizer draws the tweezers. Automatic uses the compute shader when the context supports it.
+enum class GpuRasterPath {
+    Automatic = 0,
+    Compute = 1,
+    Instanced = 2
+};
+
+// GpuRasterizer: draws the packed 24-bit-plane frames (see bitplane_rasterizer.h) on the GPU, so that only the tweezer positions of each
+// frame are uploaded instead of its pixels. The result is an R32UI texture, packedTexture, which texture.fs unpacks (and remaps) when
+// displaying it.
+// With OpenGL 4.3 a compute shader (tweezer.cs) stamps every (subframe, tweezer) pair with atomic ORs. Otherwise every pair is drawn as
+// an instanced quad over the bounding box of the tweezer shape (tweezer.vs, tweezer.fs), and the subframe bits are combined by
+// glLogicOp(GL_OR) in an offscreen framebuffer.
+class GpuRasterizer {
+public:
+    GpuRasterizer();
+    ~GpuRasterizer();
+
+    // init: creates the packed texture and compiles the shaders. Returns false if no path could be set up. A compute path that is not
+    // supported falls back to the instanced one.
+    // Inputs:
+    //      width, height: the size of the frame, in pixels
+    //      path: the way the tweezers are drawn
+    //      quadVBO, quadEBO: an existing textured quad (the display quad: position, color and texture coordinates per vertex, and six
+    //                        indices) whose texture coordinates are reused as the corners of every instance; 0 to create one
+    //      shaderDirectory: the directory holding tweezer.cs, tweezer.vs and tweezer.fs (empty for the working directory)
+    bool init(int width, int height, GpuRasterPath path = GpuRasterPath::Automatic, GLuint quadVBO = 0, GLuint quadEBO = 0,
+              const std::string& shaderDirectory = "");
+
+    // release: deletes every OpenGL object owned by the rasterizer.
+    void release();
+
+    // setStamp: uploads the shape drawn for each tweezer.
+    void setStamp(const TweezerStamp& stamp);
+
+    // rasterize: draws numSubframes consecutive smoothed moves, starting at firstMove, into packedTexture. Inversion is left to the
+    // display shader.
+    void rasterize(const TrajectoryStore& trajectories, int firstMove, int numSubframes);
+
+    GLuint packedTexture = 0;
+    bool usingCompute = false;
+    size_t lastUploadBytes = 0;
+
+private:
+    int width = 0;
+    int height = 0;
+    GLuint framebuffer = 0;
+    GLuint stampTexture = 0;
+    int stampOriginCol = 0;
+    int stampOriginRow = 0;
+    GLuint positionBuffer = 0;
+    size_t positionCapacity = 0;
+    GLuint quadVAO = 0;
+    GLuint quadVBO = 0;
+    GLuint quadEBO = 0;
+    bool ownsQuad = false;
+    ComputeShader* computeShader = nullptr;
+    Shader* instancedShader = nullptr;
+    std::vector<uint8_t> stampMask;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "presentation_monitor.h"
+#include "gl_extensions.h"
+
+#include <chrono>
+
+void PresentationMonitor::init() {
+    // GL_TIMESTAMP queries are core in OpenGL 3.3, and otherwise come with ARB_timer_query.
+    timerQueries = GLAD_GL_VERSION_3_3 || hasGLExtension("GL_ARB_timer_query");
+    if (timerQueries) glGenQueries(QUERY_RING_SIZE, queries);
+    issued = collected = 0;
+    previousFence = 0;
+}
+
+void PresentationMonitor::release() {
+    if (previousFence) glDeleteSync(previousFence);
+    previousFence = 0;
+    if (timerQueries) glDeleteQueries(QUERY_RING_SIZE, queries);
+    timerQueries = false;
+}
+
+void PresentationMonitor::beginShot(double expectedPeriodMicroseconds) {
+    pacing.beginShot(expectedPeriodMicroseconds);
+    issued = collected = 0;
+}
+
+void PresentationMonitor::collect(bool wait) {
+    while (collected < issued) {
+        int slot = collected % QUERY_RING_SIZE;
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+        }
+        GLuint64 timestamp = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &timestamp);
+        pacing.gpuFinished(queryFrames[slot], timestamp / 1000.0);
+        collected++;
+    }
+}
+
+void PresentationMonitor::beforePresent(int frame) {
+    // If the previous frame's commands are still executing, the GPU is falling behind the display.
+    if (previousFence) {
+        if (glClientWaitSync(previousFence, 0, 0) == GL_TIMEOUT_EXPIRED) pacing.backlog(frame);
+        glDeleteSync(previousFence);
+        previousFence = 0;
+    }
+    if (!timerQueries) return;
+    // A full ring means the oldest query must be read before its object can be reused; it is QUERY_RING_SIZE frames old, so the wait
+    // is normally short.
+    if (issued - collected == QUERY_RING_SIZE) collect(true);
+    int slot = issued % QUERY_RING_SIZE;
+    queryFrames[slot] = frame;
+    glQueryCounter(queries[slot], GL_TIMESTAMP);
+    issued++;
+}
+
+PacingFault PresentationMonitor::afterPresent(int frame) {
+    double now = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    PacingFault fault = pacing.presented(frame, now);
+    previousFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (timerQueries) collect(false);
+    return fault;
+}
+
+void PresentationMonitor::endShot() {
+    if (previousFence) {
+        glDeleteSync(previousFence);
+        previousFence = 0;
+    }
+    if (timerQueries) collect(true);
+}
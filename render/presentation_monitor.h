@@ -0,0 +1,52 @@
+#ifndef PRESENTATION_MONITOR_H
+#define PRESENTATION_MONITOR_H
+
+#include <glad/glad.h>
+
+#include "../core/frame_pacing.h"
+
+// PresentationMonitor: times every present of a shot to check that each RGB frame reached the DMD for exactly one refresh (see
+// FramePacing). The CPU time at which each present returns is always recorded; where timer queries are available a GL_TIMESTAMP
+// query marks when the GPU finished each frame, and a fence per frame shows whether the GPU was still busy with the previous frame
+// when the next one was submitted. Query results are collected without blocking, a few frames behind, and in full at endShot().
+class PresentationMonitor {
+public:
+    static constexpr int QUERY_RING_SIZE = 8;
+
+    // init: creates the queries. Requires a current OpenGL context.
+    void init();
+
+    // release: deletes every OpenGL object owned by the monitor.
+    void release();
+
+    // beginShot: clears the report of the previous shot.
+    // Inputs:
+    //      expectedPeriodMicroseconds: the refresh period of the display, or 0 if it is unknown
+    void beginShot(double expectedPeriodMicroseconds);
+
+    // beforePresent: marks the end of the GPU work of RGB frame number frame; call just before presenting it.
+    void beforePresent(int frame);
+
+    // afterPresent: records the return of the present of RGB frame number frame and returns the fault it reveals.
+    PacingFault afterPresent(int frame);
+
+    // endShot: waits for the outstanding GPU timestamps and adds them to the report.
+    void endShot();
+
+    const PacingReport& report() const { return pacing.report; }
+    PacingReport& report() { return pacing.report; }
+
+    bool timerQueries = false;
+
+private:
+    void collect(bool wait);
+
+    FramePacing pacing;
+    GLuint queries[QUERY_RING_SIZE] = {};
+    int queryFrames[QUERY_RING_SIZE] = {};
+    int issued = 0;       // timestamps issued in the current playback
+    int collected = 0;    // timestamps whose results have been read
+    GLsync previousFence = 0;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "texture_uploader.h"
+#include "gl_extensions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+void TextureUploader::init(int width, int height, int ringSize) {
+    this->width = width;
+    this->height = height;
+    this->ringSize = std::min(std::max(ringSize, 1), MAX_RING_SIZE);
+    next = 0;
+    frameBytes = (size_t)width * height * sizeof(uint32_t);
+    stats = UploadStats();
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    if (glExtensions.textureStorage) {
+        glExtensions.TexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+    }
+
+    persistent = glExtensions.bufferStorage;
+    glGenBuffers(this->ringSize, pbos);
+    glGenQueries(this->ringSize, queries);
+    for (int i = 0; i < this->ringSize; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i]);
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glExtensions.BufferStorage(GL_PIXEL_UNPACK_BUFFER, frameBytes, NULL, flags);
+            mapped[i] = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameBytes, flags);
+        }
+        else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, frameBytes, NULL, GL_STREAM_DRAW);
+            mapped[i] = nullptr;
+        }
+        fences[i] = 0;
+        queryPending[i] = false;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureUploader::release() {
+    for (int i = 0; i < ringSize; i++) {
+        if (fences[i]) glDeleteSync(fences[i]);
+        fences[i] = 0;
+        if (persistent && mapped[i]) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i]);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        mapped[i] = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (ringSize > 0) {
+        glDeleteBuffers(ringSize, pbos);
+        glDeleteQueries(ringSize, queries);
+    }
+    if (texture) glDeleteTextures(1, &texture);
+    texture = 0;
+    ringSize = 0;
+}
+
+void TextureUploader::collectGpuTime(int slot, bool wait) {
+    if (!queryPending[slot]) return;
+    GLint available = 0;
+    if (!wait) {
+        glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+    }
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+    queryPending[slot] = false;
+
+    double microseconds = elapsed / 1000.0;
+    stats.gpuSamples++;
+    stats.totalGpuMicroseconds += microseconds;
+    stats.maxGpuMicroseconds = std::max(stats.maxGpuMicroseconds, microseconds);
+}
+
+void TextureUploader::upload(const uint32_t* pixels) {
+    auto start = std::chrono::steady_clock::now();
+    int slot = next;
+    next = (next + 1) % ringSize;
+
+    // Wait until the GPU has finished reading this PBO the last time it was used.
+    if (fences[slot]) {
+        GLenum status = glClientWaitSync(fences[slot], 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            stats.fenceWaits++;
+            glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        glDeleteSync(fences[slot]);
+        fences[slot] = 0;
+    }
+    collectGpuTime(slot, true);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[slot]);
+    if (persistent) {
+        memcpy(mapped[slot], pixels, frameBytes);
+    }
+    else {
+        void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (target) {
+            memcpy(target, pixels, frameBytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, (void*)0);
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[slot] = true;
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Pick up any other GPU timings that have completed without blocking on them.
+    for (int i = 0; i < ringSize; i++) {
+        if (i != slot) collectGpuTime(i, false);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    stats.uploads++;
+    stats.lastCpuMicroseconds = microseconds;
+    stats.totalCpuMicroseconds += microseconds;
+    stats.maxCpuMicroseconds = std::max(stats.maxCpuMicroseconds, microseconds);
+}
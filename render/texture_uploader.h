@@ -0,0 +1,65 @@
+#ifndef TEXTURE_UPLOADER_H
+#define TEXTURE_UPLOADER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// TextureUploader: streams packed frames (see bitplane_rasterizer.h) into a display texture through a ring of pixel buffer objects.
+// The texture has fixed (immutable, where supported) RGBA8 storage, so frames are written with glTexSubImage2D instead of reallocating
+// it. Each frame is copied into the next PBO of the ring and the transfer to the texture is queued from there, so the call returns
+// while the GPU is still copying and the CPU can go on to prepare the next frame. A fence per PBO keeps the CPU from overwriting a
+// buffer that is still being read. Where ARB_buffer_storage is available the PBOs are mapped once, persistently.
+class TextureUploader {
+public:
+    static constexpr int MAX_RING_SIZE = 4;
+
+    // init: creates the texture and the PBO ring. Requires a current OpenGL context.
+    // Inputs:
+    //      width, height: the size of the texture, in pixels
+    //      ringSize: the number of PBOs to cycle through (at most MAX_RING_SIZE)
+    void init(int width, int height, int ringSize);
+
+    // release: deletes every OpenGL object owned by the uploader.
+    void release();
+
+    // upload: queues a width * height packed frame for transfer into the texture, which stays bound to GL_TEXTURE_2D.
+    void upload(const uint32_t* pixels);
+
+    // UploadStats: timings of the upload path. cpu* times cover waiting for a free PBO, copying the frame and queueing the transfer;
+    // gpu* times are measured with GL_TIME_ELAPSED queries and lag the CPU times by up to ringSize frames.
+    struct UploadStats {
+        long long uploads = 0;
+        double lastCpuMicroseconds = 0.0;
+        double totalCpuMicroseconds = 0.0;
+        double maxCpuMicroseconds = 0.0;
+        long long gpuSamples = 0;
+        double totalGpuMicroseconds = 0.0;
+        double maxGpuMicroseconds = 0.0;
+        long long fenceWaits = 0;    // uploads that had to wait for the GPU to release a PBO
+    };
+
+    // resetStats: clears the upload statistics (e.g. at the start of a shot).
+    void resetStats() { stats = UploadStats(); }
+
+    GLuint texture = 0;
+    UploadStats stats;
+    bool persistent = false;
+
+private:
+    void collectGpuTime(int slot, bool wait);
+
+    int width = 0;
+    int height = 0;
+    int ringSize = 0;
+    int next = 0;
+    size_t frameBytes = 0;
+    GLuint pbos[MAX_RING_SIZE] = {};
+    void* mapped[MAX_RING_SIZE] = {};
+    GLsync fences[MAX_RING_SIZE] = {};
+    GLuint queries[MAX_RING_SIZE] = {};
+    bool queryPending[MAX_RING_SIZE] = {};
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <set>
+#include <vector>
+
+#include "core/assignment.h"
+
+namespace {
+
+// bruteForce: the minimum total cost over every assignment of rows to distinct columns.
+long long bruteForce(const std::vector<int>& cost, int rows, int cols) {
+    std::vector<int> columns(cols);
+    std::iota(columns.begin(), columns.end(), 0);
+    long long best = -1;
+    do {
+        long long total = 0;
+        for (int r = 0; r < rows; r++) total += cost[(size_t)r * cols + columns[r]];
+        if (best < 0 || total < best) best = total;
+    } while (std::next_permutation(columns.begin(), columns.end()));
+    return best;
+}
+
+TEST(AssignmentTest, MatchesBruteForce) {
+    srand(3);
+    AssignmentSolver solver;
+    for (int trial = 0; trial < 200; trial++) {
+        int cols = 1 + rand() % 7;
+        int rows = 1 + rand() % cols;
+        std::vector<int> cost((size_t)rows * cols);
+        for (int& c : cost) c = rand() % 20;
+        std::vector<int> assignment(rows, -1);
+        long long total = solver.solve(cost.data(), rows, cols, assignment.data());
+
+        std::set<int> used;
+        long long check = 0;
+        for (int r = 0; r < rows; r++) {
+            ASSERT_TRUE(assignment[r] >= 0 && assignment[r] < cols);
+            EXPECT_TRUE(used.insert(assignment[r]).second) << "column assigned twice";
+            check += cost[(size_t)r * cols + assignment[r]];
+        }
+        EXPECT_EQ(total, check);
+        EXPECT_EQ(total, bruteForce(cost, rows, cols)) << rows << " x " << cols << ", trial " << trial;
+    }
+}
+
+TEST(AssignmentTest, IdentityIsFree) {
+    const int n = 50;
+    std::vector<int> cost((size_t)n * n);
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) cost[(size_t)r * n + c] = abs(r - c);
+    }
+    std::vector<int> assignment(n);
+    AssignmentSolver solver;
+    EXPECT_EQ(solver.solve(cost.data(), n, n, assignment.data()), 0);
+    for (int r = 0; r < n; r++) EXPECT_EQ(assignment[r], r);
+}
+
+}
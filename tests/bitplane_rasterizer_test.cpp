@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "core/bitplane_rasterizer.h"
+#include "core/tweezer_shapes.h"
+
+namespace {
+
+const int WIDTH = 1140;
+const int HEIGHT = 912;
+
+// fillMoves: scatters numTweezers tweezers over the frame (some partly off screen) for numMoves moves.
+void fillMoves(TrajectoryStore& trajectories, int numTweezers, int numMoves, unsigned seed) {
+    srand(seed);
+    trajectories.reserve(numTweezers, numMoves, 2);
+    for (int move = 0; move < numMoves; move++) {
+        for (int i = 0; i < numTweezers; i++) {
+            trajectories.moveX(move, i) = (float)(rand() % (HEIGHT + 20) - 10) + 0.4f;
+            trajectories.moveY(move, i) = (float)(rand() % (WIDTH + 20) - 10) + 0.7f;
+        }
+    }
+}
+
+// referenceFrame: the frame as the original per-pixel loop drew it: each subframe adds its bit weight to one RGB byte, for every
+// pixel of a square tweezer, starting from white and subtracting in inverted mode.
+std::vector<uint8_t> referenceFrame(const TrajectoryStore& trajectories, int numSubframes, int halfWidth, bool inverted) {
+    std::vector<uint8_t> rgb((size_t)WIDTH * HEIGHT * 3, inverted ? 255 : 0);
+    std::vector<uint32_t> covered((size_t)WIDTH * HEIGHT);
+    for (int j = 0; j < numSubframes; j++) {
+        std::fill(covered.begin(), covered.end(), 0);
+        for (int i = 0; i < trajectories.numTweezers; i++) {
+            int x = (int)trajectories.moveX(j)[i];
+            int y = (int)trajectories.moveY(j)[i];
+            for (int dx = -halfWidth; dx <= halfWidth; dx++) {
+                for (int dy = -halfWidth; dy <= halfWidth; dy++) {
+                    if (x + dx < 0 || x + dx >= HEIGHT || y + dy < 0 || y + dy >= WIDTH) continue;
+                    covered[(size_t)(x + dx) * WIDTH + y + dy] = 1;
+                }
+            }
+        }
+        uint8_t weight = (uint8_t)std::pow(2, 7 - j % 8);
+        for (size_t p = 0; p < covered.size(); p++) {
+            if (covered[p]) rgb[p * 3 + j / 8] += inverted ? -weight : weight;
+        }
+    }
+    return rgb;
+}
+
+void expectMatchesReference(const std::vector<uint32_t>& frame, const std::vector<uint8_t>& rgb) {
+    long mismatches = 0;
+    for (size_t p = 0; p < frame.size(); p++) {
+        if (rgb[p * 3] != ((frame[p] >> 16) & 255) || rgb[p * 3 + 1] != ((frame[p] >> 8) & 255) || rgb[p * 3 + 2] != (frame[p] & 255)) {
+            mismatches++;
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(BitplaneRasterizerTest, SubframeMasksFollowTheRedGreenBlueOrder) {
+    EXPECT_EQ(subframeMask(0), 0x00800000u);
+    EXPECT_EQ(subframeMask(7), 0x00010000u);
+    EXPECT_EQ(subframeMask(8), 0x00008000u);
+    EXPECT_EQ(subframeMask(23), 0x00000001u);
+}
+
+TEST(BitplaneRasterizerTest, MatchesPerPixelReference) {
+    TrajectoryStore trajectories;
+    fillMoves(trajectories, 200, SUBFRAMES_PER_FRAME, 1);
+    TweezerStamp stamp;
+    stamp.makeSquare(3);
+    std::vector<uint32_t> frame((size_t)WIDTH * HEIGHT);
+    for (bool inverted : { false, true }) {
+        for (int numSubframes : { SUBFRAMES_PER_FRAME, 5 }) {
+            rasterizeFrame(trajectories, 0, numSubframes, stamp, inverted, frame.data(), WIDTH, HEIGHT);
+            expectMatchesReference(frame, referenceFrame(trajectories, numSubframes, 3, inverted));
+        }
+    }
+}
+
+TEST(BitplaneRasterizerTest, TiledRasterizationMatchesSerial) {
+    TrajectoryStore trajectories;
+    fillMoves(trajectories, 300, SUBFRAMES_PER_FRAME, 2);
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec spec;
+    spec.shape = TweezerShape::Disc;
+    spec.size = 4;
+    const TweezerStamp& stamp = shapes.get(spec);
+
+    std::vector<uint32_t> serial((size_t)WIDTH * HEIGHT), tiled((size_t)WIDTH * HEIGHT);
+    rasterizeFrame(trajectories, 0, SUBFRAMES_PER_FRAME, stamp, true, serial.data(), WIDTH, HEIGHT);
+    for (int threads : { 1, 2, 3 }) {
+        ThreadPool pool(threads);
+        rasterizeFrame(trajectories, 0, SUBFRAMES_PER_FRAME, stamp, true, tiled.data(), WIDTH, HEIGHT, &pool);
+        EXPECT_EQ(serial, tiled) << threads << " threads";
+    }
+}
+
+TEST(BitplaneRasterizerTest, EmptySubframesLeaveBackground) {
+    TrajectoryStore trajectories;
+    fillMoves(trajectories, 10, 1, 3);
+    TweezerStamp stamp;
+    stamp.makeSquare(1);
+    std::vector<uint32_t> frame((size_t)WIDTH * HEIGHT, 12345);
+    rasterizeFrame(trajectories, 0, 0, stamp, true, frame.data(), WIDTH, HEIGHT);
+    for (uint32_t pixel : frame) ASSERT_EQ(pixel, ALL_SUBFRAMES_MASK);
+}
+
+}
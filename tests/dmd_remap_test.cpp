@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "core/dmd_remap.h"
+
+namespace {
+
+const int WIDTH = 1140;
+const int HEIGHT = 912;
+const int ROW_OFFSET = 607;
+const uint32_t BACKGROUND = 0x00ABCDEF;
+
+std::vector<uint32_t> randomImage() {
+    srand(4);
+    std::vector<uint32_t> image((size_t)WIDTH * HEIGHT);
+    for (uint32_t& pixel : image) pixel = (uint32_t)rand() & 0x00FFFFFF;
+    return image;
+}
+
+TEST(DmdRemapTest, MatchesPerPixelTransform) {
+    std::vector<uint32_t> src = randomImage();
+    std::vector<uint32_t> expected((size_t)WIDTH * HEIGHT, BACKGROUND), dst((size_t)WIDTH * HEIGHT);
+    for (int i = 0; i < HEIGHT; i++) {
+        for (int j = 0; j < WIDTH; j++) {
+            int x = ROW_OFFSET + rowAlgorithm(i, j);
+            int y = columnAlgorithm(i, j);
+            if (x >= 0 && x < HEIGHT && y >= 0 && y < WIDTH) expected[(size_t)i * WIDTH + j] = src[(size_t)x * WIDTH + y];
+        }
+    }
+
+    DmdRemap remap;
+    remap.build(WIDTH, HEIGHT, ROW_OFFSET);
+    remap.fillOutside(dst.data(), BACKGROUND);
+    remap.apply(src.data(), dst.data());
+    EXPECT_EQ(dst, expected);
+}
+
+TEST(DmdRemapTest, BandsCoverTheWholeScreen) {
+    std::vector<uint32_t> src = randomImage();
+    std::vector<uint32_t> whole((size_t)WIDTH * HEIGHT, 0), banded((size_t)WIDTH * HEIGHT, 0);
+    DmdRemap remap;
+    remap.build(WIDTH, HEIGHT, ROW_OFFSET);
+    remap.apply(src.data(), whole.data());
+    const int bands[] = { 0, 1, 100, 455, 456, 911, HEIGHT };
+    for (int b = 0; b + 1 < (int)(sizeof(bands) / sizeof(bands[0])); b++) {
+        remap.apply(src.data(), banded.data(), bands[b], bands[b + 1]);
+    }
+    EXPECT_EQ(whole, banded);
+}
+
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "core/frame_pacing.h"
+
+namespace {
+
+const double PERIOD = 1e6 / 60.0;
+
+TEST(FramePacingTest, SteadyPresentsAreExact) {
+    FramePacing pacing;
+    pacing.beginShot(PERIOD);
+    for (int frame = 0; frame < 10; frame++) {
+        // Jitter well inside the thresholds.
+        double jitter = frame % 2 == 0 ? 300.0 : -300.0;
+        EXPECT_EQ(pacing.presented(frame, 1000.0 + frame * PERIOD + jitter), PacingFault::None);
+    }
+    const PacingReport& report = pacing.report;
+    EXPECT_EQ(report.presents, 10);
+    EXPECT_EQ(report.intervals, 9);
+    EXPECT_NEAR(report.meanIntervalMicroseconds(), PERIOD, 100.0);
+    EXPECT_TRUE(report.exact());
+    EXPECT_EQ(report.firstFaultFrame, -1);
+}
+
+TEST(FramePacingTest, DetectsLateAndDroppedFrames) {
+    FramePacing pacing;
+    pacing.beginShot(PERIOD);
+    double time = 0.0;
+    EXPECT_EQ(pacing.presented(0, time), PacingFault::None);
+    time += PERIOD;
+    EXPECT_EQ(pacing.presented(1, time), PacingFault::None);
+    // Frame 1 stayed up for three refreshes.
+    time += 3 * PERIOD;
+    EXPECT_EQ(pacing.presented(2, time), PacingFault::Late);
+    // Frame 2 was replaced before the next refresh.
+    time += 0.2 * PERIOD;
+    EXPECT_EQ(pacing.presented(3, time), PacingFault::Dropped);
+    time += PERIOD;
+    EXPECT_EQ(pacing.presented(4, time), PacingFault::None);
+
+    const PacingReport& report = pacing.report;
+    EXPECT_EQ(report.lateFrames, 1);
+    EXPECT_EQ(report.repeatedRefreshes, 2);
+    EXPECT_EQ(report.droppedFrames, 1);
+    EXPECT_EQ(report.firstFaultFrame, 2);
+    EXPECT_NEAR(report.maxIntervalMicroseconds, 3 * PERIOD, 1e-6);
+    EXPECT_NEAR(report.minIntervalMicroseconds, 0.2 * PERIOD, 1e-6);
+    EXPECT_FALSE(report.exact());
+}
+
+TEST(FramePacingTest, UnknownPeriodOnlyMeasures) {
+    FramePacing pacing;
+    pacing.beginShot(0.0);
+    EXPECT_EQ(pacing.presented(0, 0.0), PacingFault::None);
+    EXPECT_EQ(pacing.presented(1, 1e6), PacingFault::None);
+    EXPECT_EQ(pacing.presented(2, 1e6 + 1.0), PacingFault::None);
+    EXPECT_EQ(pacing.report.intervals, 2);
+    EXPECT_TRUE(pacing.report.exact());
+}
+
+TEST(FramePacingTest, RestartSkipsTheGapBetweenPlaybacks) {
+    FramePacing pacing;
+    pacing.beginShot(PERIOD);
+    pacing.presented(0, 0.0);
+    pacing.presented(1, PERIOD);
+    pacing.restart();
+    EXPECT_EQ(pacing.presented(0, 100 * PERIOD), PacingFault::None);
+    EXPECT_EQ(pacing.presented(1, 101 * PERIOD), PacingFault::None);
+    EXPECT_EQ(pacing.report.presents, 4);
+    EXPECT_EQ(pacing.report.intervals, 2);
+    EXPECT_TRUE(pacing.report.exact());
+}
+
+TEST(FramePacingTest, GpuTimestampsOfConsecutiveFrames) {
+    FramePacing pacing;
+    pacing.beginShot(PERIOD);
+    pacing.gpuFinished(0, 0.0);
+    pacing.gpuFinished(1, PERIOD);
+    pacing.gpuFinished(2, 4 * PERIOD);
+    // A gap in the frame numbers (a timestamp that was never read) is not an interval.
+    pacing.gpuFinished(5, 20 * PERIOD);
+    pacing.gpuFinished(6, 21 * PERIOD);
+    EXPECT_EQ(pacing.report.gpuLateFrames, 1);
+
+    EXPECT_EQ(pacing.report.firstBacklogFrame, -1);
+    pacing.backlog(6);
+    pacing.backlog(8);
+    EXPECT_EQ(pacing.report.gpuBacklogFrames, 2);
+    EXPECT_EQ(pacing.report.firstBacklogFrame, 6);
+}
+
+}
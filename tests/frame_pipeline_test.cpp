@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "core/bitplane_rasterizer.h"
+#include "core/frame_pipeline.h"
+
+namespace {
+
+const int WIDTH = 1140;
+const int HEIGHT = 912;
+
+class FramePipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        srand(5);
+        int numMoves = 3 * SUBFRAMES_PER_FRAME + 7;
+        trajectories.reserve(150, numMoves, 2);
+        for (int move = 0; move < numMoves; move++) {
+            for (int i = 0; i < 150; i++) {
+                trajectories.moveX(move, i) = (float)(rand() % HEIGHT);
+                trajectories.moveY(move, i) = (float)(rand() % WIDTH);
+            }
+        }
+        stamp.makeSquare(2);
+        remap.build(WIDTH, HEIGHT, 607);
+
+        job.trajectories = &trajectories;
+        job.numMoves = numMoves;
+        job.stamp = &stamp;
+        job.inverted = true;
+        job.remap = &remap;
+        job.width = WIDTH;
+        job.height = HEIGHT;
+    }
+
+    // expectedFrames: every RGB frame of the job, rendered one after the other on this thread.
+    std::vector<std::vector<uint32_t>> expectedFrames() {
+        std::vector<std::vector<uint32_t>> frames;
+        std::vector<uint32_t> packed((size_t)WIDTH * HEIGHT), remapped((size_t)WIDTH * HEIGHT);
+        remap.fillOutside(remapped.data(), ALL_SUBFRAMES_MASK);
+        for (int f = 0; f < job.numRgbFrames(); f++) {
+            const uint32_t* frame = renderFrame(job, f, packed.data(), remapped.data());
+            frames.emplace_back(frame, frame + (size_t)WIDTH * HEIGHT);
+        }
+        return frames;
+    }
+
+    TrajectoryStore trajectories;
+    TweezerStamp stamp;
+    DmdRemap remap;
+    FrameJob job;
+};
+
+TEST_F(FramePipelineTest, CountsPartialLastFrame) {
+    EXPECT_EQ(job.numRgbFrames(), 4);
+}
+
+TEST_F(FramePipelineTest, ProducesTheSameFramesAsSequentialRendering) {
+    std::vector<std::vector<uint32_t>> expected = expectedFrames();
+    ThreadPool pool(2);
+    job.pool = &pool;
+
+    FramePipeline pipeline;
+    pipeline.start(2, 2, WIDTH, HEIGHT);
+    for (int shot = 0; shot < 3; shot++) {
+        pipeline.beginShot(job);
+        for (int f = 0; f < job.numRgbFrames(); f++) {
+            const uint32_t* frame = pipeline.acquire(f);
+            EXPECT_TRUE(std::equal(expected[f].begin(), expected[f].end(), frame)) << "shot " << shot << ", frame " << f;
+            pipeline.release(f);
+        }
+        pipeline.endShot();
+        EXPECT_EQ(pipeline.stats.framesConsumed, job.numRgbFrames());
+    }
+    pipeline.stop();
+    EXPECT_FALSE(pipeline.running());
+}
+
+TEST_F(FramePipelineTest, AbandonedShotCanBeFollowedByAnother) {
+    std::vector<std::vector<uint32_t>> expected = expectedFrames();
+    FramePipeline pipeline;
+    pipeline.start(1, 2, WIDTH, HEIGHT);
+    pipeline.beginShot(job);
+    pipeline.acquire(0);
+    pipeline.release(0);
+    pipeline.endShot();
+
+    pipeline.beginShot(job);
+    for (int f = 0; f < job.numRgbFrames(); f++) {
+        const uint32_t* frame = pipeline.acquire(f);
+        EXPECT_TRUE(std::equal(expected[f].begin(), expected[f].end(), frame)) << "frame " << f;
+        pipeline.release(f);
+    }
+    pipeline.endShot();
+}
+
+}
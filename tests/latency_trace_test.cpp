@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/latency_trace.h"
+
+namespace {
+
+TEST(LatencyTraceTest, DisabledTraceRecordsNothing) {
+    LatencyTrace trace;
+    EXPECT_FALSE(trace.enabled());
+    EXPECT_EQ(trace.beginShot(), 0);
+    trace.record(TraceEvent::RouteDone);
+    EXPECT_EQ(trace.recorded(), 0);
+    EXPECT_TRUE(trace.snapshot().empty());
+}
+
+TEST(LatencyTraceTest, KeepsEventsInOrder) {
+    LatencyTrace trace;
+    trace.reserve(16);
+    LatencyTrace::Clock::time_point received = LatencyTrace::Clock::now();
+    EXPECT_EQ(trace.beginShot(received), 0);
+    trace.record(TraceEvent::RouteDone);
+    trace.record(TraceEvent::RasterDone, 0);
+    trace.record(TraceEvent::PresentDone, 0);
+
+    std::vector<TraceRecord> records = trace.snapshot();
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].event, TraceEvent::ShotReceived);
+    EXPECT_EQ(records[0].time, std::chrono::duration_cast<std::chrono::nanoseconds>(received.time_since_epoch()).count());
+    EXPECT_EQ(records[1].event, TraceEvent::RouteDone);
+    EXPECT_EQ(records[1].frame, -1);
+    EXPECT_EQ(records[2].event, TraceEvent::RasterDone);
+    EXPECT_EQ(records[3].frame, 0);
+    for (size_t i = 0; i < records.size(); i++) {
+        EXPECT_EQ(records[i].shot, 0);
+        if (i > 0) {
+            EXPECT_GE(records[i].time, records[i - 1].time);
+        }
+    }
+}
+
+TEST(LatencyTraceTest, RingKeepsTheMostRecentRecords) {
+    LatencyTrace trace;
+    trace.reserve(8);
+    for (int shot = 0; shot < 5; shot++) {
+        trace.beginShot();
+        trace.record(TraceEvent::ShotDone);
+    }
+    EXPECT_EQ(trace.recorded(), 10);
+    std::vector<TraceRecord> records = trace.snapshot();
+    ASSERT_EQ(records.size(), 8u);
+    EXPECT_EQ(records.front().shot, 1);
+    EXPECT_EQ(records.back().shot, 4);
+    EXPECT_EQ(records.back().event, TraceEvent::ShotDone);
+
+    trace.clear();
+    EXPECT_TRUE(trace.snapshot().empty());
+    EXPECT_TRUE(trace.enabled());
+}
+
+TEST(LatencyTraceTest, RecordsFromSeveralThreads) {
+    LatencyTrace trace;
+    trace.reserve(4096);
+    trace.beginShot();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&trace, t]() {
+            for (int frame = 0; frame < 256; frame++) trace.record(TraceEvent::RasterDone, t * 256 + frame);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    std::vector<TraceRecord> records = trace.snapshot();
+    ASSERT_EQ(records.size(), 1025u);
+    std::vector<int> seen(1024, 0);
+    for (const TraceRecord& record : records) {
+        if (record.event == TraceEvent::RasterDone) seen[record.frame]++;
+    }
+    for (int frame = 0; frame < 1024; frame++) ASSERT_EQ(seen[frame], 1) << "frame " << frame;
+}
+
+TEST(LatencyTraceTest, WritesChromeTrace) {
+    LatencyTrace trace;
+    trace.reserve(16);
+    trace.beginShot();
+    trace.record(TraceEvent::UploadDone, 3);
+    std::string path = ::testing::TempDir() + "latency_trace_test.json";
+    ASSERT_TRUE(trace.writeChromeTrace(path));
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string json = contents.str();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_NE(json.find("\"name\":\"shot received\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"upload done\""), std::string::npos);
+    EXPECT_NE(json.find("\"frame\":3"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"shot 0\",\"cat\":\"dmd\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+    std::remove(path.c_str());
+}
+
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <queue>
+#include <vector>
+
+#include "core/lattice_topology.h"
+
+namespace {
+
+// breadthFirstDistances: the number of moves from the center of a (2 * radius + 1)-wide grid to every site, following the neighbours.
+std::vector<int> breadthFirstDistances(const LatticeNeighbourhood& neighbourhood, int radius) {
+    int width = 2 * radius + 1;
+    std::vector<int> distances((size_t)width * width, -1);
+    std::queue<int> queue;
+    distances[radius * width + radius] = 0;
+    queue.push(radius * width + radius);
+    while (!queue.empty()) {
+        int site = queue.front();
+        queue.pop();
+        for (int k = 0; k < neighbourhood.numNeighbours; k++) {
+            int row = site / width + neighbourhood.offsets[k][0], col = site % width + neighbourhood.offsets[k][1];
+            if (row < 0 || row >= width || col < 0 || col >= width || distances[row * width + col] >= 0) continue;
+            distances[row * width + col] = distances[site] + 1;
+            queue.push(row * width + col);
+        }
+    }
+    return distances;
+}
+
+TEST(LatticeTopologyTest, DistanceCountsTheFewestMoves) {
+    // On a grid twice as wide as the distances checked, no shortest path from the center is cut off by the edges.
+    const int radius = 12, checked = 6;
+    for (LatticeTopology topology : { LatticeTopology::Square, LatticeTopology::Triangular }) {
+        const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+        std::vector<int> distances = breadthFirstDistances(neighbourhood, radius);
+        for (int dRow = -checked; dRow <= checked; dRow++) {
+            for (int dCol = -checked; dCol <= checked; dCol++) {
+                EXPECT_EQ(neighbourhood.distance(dRow, dCol), distances[(radius + dRow) * (2 * radius + 1) + radius + dCol])
+                    << "topology " << (int)topology << ", (" << dRow << ", " << dCol << ")";
+            }
+        }
+    }
+}
+
+TEST(LatticeTopologyTest, TriangularMovesCutDiagonalPaths) {
+    const LatticeNeighbourhood& square = latticeNeighbourhood(LatticeTopology::Square);
+    const LatticeNeighbourhood& triangular = latticeNeighbourhood(LatticeTopology::Triangular);
+    EXPECT_EQ(square.numNeighbours, 4);
+    EXPECT_EQ(triangular.numNeighbours, 6);
+    EXPECT_EQ(square.distance(5, -5), 10);
+    EXPECT_EQ(triangular.distance(5, -5), 5);
+    EXPECT_EQ(triangular.distance(5, 5), 10);
+    EXPECT_EQ(triangular.distance(3, -1), 3);
+}
+
+TEST(LatticeTopologyTest, ShortestStepsHeadForTheTarget) {
+    for (LatticeTopology topology : { LatticeTopology::Square, LatticeTopology::Triangular }) {
+        const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+        for (int dRow = -5; dRow <= 5; dRow++) {
+            for (int dCol = -5; dCol <= 5; dCol++) {
+                int steps[2][2];
+                int numSteps = neighbourhood.shortestSteps(dRow, dCol, steps);
+                int distance = neighbourhood.distance(dRow, dCol);
+                EXPECT_EQ(numSteps == 0, distance == 0);
+                for (int s = 0; s < numSteps; s++) {
+                    EXPECT_EQ(neighbourhood.distance(steps[s][0], steps[s][1]), 1);
+                    EXPECT_EQ(neighbourhood.distance(dRow - steps[s][0], dCol - steps[s][1]), distance - 1);
+                }
+            }
+        }
+    }
+    // On a square lattice the axis with further to go comes first, and rows win ties.
+    int steps[2][2];
+    const LatticeNeighbourhood& square = latticeNeighbourhood(LatticeTopology::Square);
+    ASSERT_EQ(square.shortestSteps(2, -3, steps), 2);
+    EXPECT_EQ(steps[0][0], 0);
+    EXPECT_EQ(steps[0][1], -1);
+    ASSERT_EQ(square.shortestSteps(-3, 3, steps), 2);
+    EXPECT_EQ(steps[0][0], -1);
+    EXPECT_EQ(steps[0][1], 0);
+}
+
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "core/occupancy_grid.h"
+
+namespace {
+
+// loadGrid: loads a row-major matrix into grid through row pointers, as the routers do, and returns the number of atoms.
+int loadGrid(OccupancyGrid& grid, std::vector<int>& occupancy, int rows, int cols, TrajectoryStore& trajectories, long long& rowSum,
+             long long& colSum) {
+    std::vector<int*> rowPointers(rows);
+    for (int i = 0; i < rows; i++) rowPointers[i] = occupancy.data() + (size_t)i * cols;
+    trajectories.reserve(rows * cols, 1, 1);
+    return grid.load(rowPointers.data(), rows, cols, trajectories, rowSum, colSum);
+}
+
+TEST(OccupancyGridTest, LoadFillsPositionsAndSumsInOnePass) {
+    // 70 columns put the border and some sites in a second word of each row.
+    const int rows = 9, cols = 70;
+    srand(3);
+    std::vector<int> occupancy((size_t)rows * cols);
+    for (int& site : occupancy) site = rand() % 3 == 0 ? 1 : 0;
+
+    OccupancyGrid grid;
+    TrajectoryStore trajectories;
+    long long rowSum = 0, colSum = 0;
+    int numAtoms = loadGrid(grid, occupancy, rows, cols, trajectories, rowSum, colSum);
+
+    int expected = 0;
+    long long expectedRowSum = 0, expectedColSum = 0;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            EXPECT_EQ(grid.occupied(i, j), occupancy[i * cols + j] == 1);
+            if (occupancy[i * cols + j] != 1) continue;
+            EXPECT_EQ(trajectories.latticeRow(0, expected), i);
+            EXPECT_EQ(trajectories.latticeCol(0, expected), j);
+            expectedRowSum += i;
+            expectedColSum += j;
+            expected++;
+        }
+    }
+    EXPECT_EQ(numAtoms, expected);
+    EXPECT_EQ(grid.count(), expected);
+    EXPECT_EQ(rowSum, expectedRowSum);
+    EXPECT_EQ(colSum, expectedColSum);
+}
+
+TEST(OccupancyGridTest, WindowReadsTheEdgesAsOccupied) {
+    // 63 columns put the right-hand border in the last bit of the first word, so the window of the last column spans two words.
+    const int rows = 3, cols = 63;
+    OccupancyGrid grid;
+    grid.reset(rows, cols);
+    EXPECT_EQ(grid.count(), 0);
+
+    // Around an empty corner only the sites off the lattice are set.
+    unsigned corner = grid.window(0, 0);
+    for (int dRow = -1; dRow <= 1; dRow++) {
+        for (int dCol = -1; dCol <= 1; dCol++) {
+            bool offLattice = dRow < 0 || dCol < 0;
+            EXPECT_EQ((corner >> OccupancyGrid::windowBit(dRow, dCol)) & 1, offLattice ? 1u : 0u) << dRow << ", " << dCol;
+        }
+    }
+    unsigned lastColumn = grid.window(1, cols - 1);
+    EXPECT_EQ(lastColumn, 1u << OccupancyGrid::windowBit(-1, 1) | 1u << OccupancyGrid::windowBit(0, 1) | 1u << OccupancyGrid::windowBit(1, 1));
+
+    grid.set(2, cols - 2);
+    grid.set(0, cols - 1);
+    lastColumn = grid.window(1, cols - 1);
+    EXPECT_TRUE((lastColumn >> OccupancyGrid::windowBit(1, -1)) & 1);
+    EXPECT_TRUE((lastColumn >> OccupancyGrid::windowBit(-1, 0)) & 1);
+    EXPECT_FALSE((lastColumn >> OccupancyGrid::windowBit(0, -1)) & 1);
+
+    grid.move(0, cols - 1, 1, cols - 2);
+    EXPECT_FALSE(grid.occupied(0, cols - 1));
+    EXPECT_TRUE(grid.occupied(1, cols - 2));
+    EXPECT_EQ(grid.count(), 2);
+}
+
+TEST(OccupancyGridTest, CoversChecksARegionAWordAtATime) {
+    const int rows = 4, cols = 130;
+    OccupancyGrid atoms, region;
+    atoms.reset(rows, cols);
+    region.reset(rows, cols);
+    EXPECT_TRUE(atoms.covers(region));
+    for (int j = 60; j < 70; j++) {
+        region.set(2, j);
+        atoms.set(2, j);
+    }
+    atoms.set(0, 129);
+    EXPECT_TRUE(atoms.covers(region));
+    region.set(3, 128);
+    EXPECT_FALSE(atoms.covers(region));
+    atoms.set(3, 128);
+    EXPECT_TRUE(atoms.covers(region));
+    atoms.clear(2, 64);
+    EXPECT_FALSE(atoms.covers(region));
+}
+
+}
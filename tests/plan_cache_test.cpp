@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "core/frame_context.h"
+#include "core/plan_cache.h"
+#include "core/router.h"
+
+namespace {
+
+const int ROWS = 12, COLS = 12, N = 4, MAX_TIME = 40;
+
+LatticeGeometry testLattice() {
+    LatticeGeometry lattice;
+    lattice.vec1X = 10.0f;
+    lattice.vec2Y = 10.0f;
+    lattice.centerX = 400.0f;
+    lattice.centerY = 300.0f;
+    return lattice;
+}
+
+std::vector<uint8_t> randomOccupancy(unsigned seed) {
+    srand(seed);
+    std::vector<uint8_t> occupancy((size_t)ROWS * COLS);
+    for (uint8_t& site : occupancy) site = rand() % 2;
+    return occupancy;
+}
+
+// routeShot: routes and smooths an occupancy matrix in context, and returns the number of lattice frames.
+int routeShot(FrameContext& context, const std::vector<uint8_t>& occupancy, const LatticeGeometry& lattice, int& numTweezers) {
+    numTweezers = 0;
+    for (uint8_t site : occupancy) numTweezers += site == 1;
+    context.prepare(ROWS, COLS, numTweezers, N, MAX_TIME);
+    int** tweezerPositions = context.tweezerPositions();
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) tweezerPositions[i][j] = occupancy[i * COLS + j];
+    }
+    return generateFrames(numTweezers, ROWS, COLS, tweezerPositions, context.trajectories, N, lattice, MAX_TIME);
+}
+
+// findShot: looks up an occupancy matrix with the test parameters.
+CachedPlan* findShot(PlanCache& cache, const std::vector<uint8_t>& occupancy, const LatticeGeometry& lattice, int n = N) {
+    return cache.find(occupancy.data(), ROWS, COLS, n, lattice, MAX_TIME, RoutingMethod::CenterOfMass, nullptr);
+}
+
+TEST(PlanCacheTest, HitReturnsTheStoredPlan) {
+    PlanCache cache;
+    cache.configure(4, 1 << 30);
+    LatticeGeometry lattice = testLattice();
+    std::vector<uint8_t> occupancy = randomOccupancy(1);
+
+    FrameContext context;
+    int numTweezers = 0;
+    int numFrames = routeShot(context, occupancy, lattice, numTweezers);
+    EXPECT_EQ(findShot(cache, occupancy, lattice), nullptr);
+    cache.insert(context.trajectories, numTweezers, numFrames).siteSteps = 7;
+
+    CachedPlan* plan = findShot(cache, occupancy, lattice);
+    ASSERT_NE(plan, nullptr);
+    EXPECT_EQ(plan->numTweezers, numTweezers);
+    EXPECT_EQ(plan->numLatticeFrames, numFrames);
+    EXPECT_EQ(plan->siteSteps, 7);
+    for (int frame = 0; frame < numFrames; frame++) {
+        for (int i = 0; i < numTweezers; i++) {
+            EXPECT_EQ(plan->trajectories.latticeRow(frame, i), context.trajectories.latticeRow(frame, i));
+            EXPECT_EQ(plan->trajectories.latticeCol(frame, i), context.trajectories.latticeCol(frame, i));
+        }
+    }
+    for (int move = 0; move < N * (numFrames - 1) + 1; move++) {
+        for (int i = 0; i < numTweezers; i++) {
+            EXPECT_EQ(plan->trajectories.moveX(move, i), context.trajectories.moveX(move, i));
+            EXPECT_EQ(plan->trajectories.moveY(move, i), context.trajectories.moveY(move, i));
+        }
+    }
+    EXPECT_EQ(cache.stats().lookups, 2);
+    EXPECT_EQ(cache.stats().hits, 1);
+    EXPECT_DOUBLE_EQ(cache.stats().hitRate(), 0.5);
+}
+
+TEST(PlanCacheTest, AnyChangeToTheKeyMisses) {
+    PlanCache cache;
+    cache.configure(4, 1 << 30);
+    LatticeGeometry lattice = testLattice();
+    std::vector<uint8_t> occupancy = randomOccupancy(2);
+
+    FrameContext context;
+    int numTweezers = 0;
+    int numFrames = routeShot(context, occupancy, lattice, numTweezers);
+    findShot(cache, occupancy, lattice);
+    cache.insert(context.trajectories, numTweezers, numFrames);
+
+    std::vector<uint8_t> moved = occupancy;
+    moved[5] = 1 - moved[5];
+    EXPECT_EQ(findShot(cache, moved, lattice), nullptr);
+    EXPECT_EQ(findShot(cache, occupancy, lattice, N + 1), nullptr);
+    LatticeGeometry rotated = lattice;
+    rotated.vec1Y = 0.5f;
+    EXPECT_EQ(findShot(cache, occupancy, rotated), nullptr);
+    std::vector<uint8_t> targets((size_t)ROWS * COLS, 0);
+    EXPECT_EQ(cache.find(occupancy.data(), ROWS, COLS, N, lattice, MAX_TIME, RoutingMethod::CenterOfMass, targets.data()), nullptr);
+    EXPECT_EQ(cache.find(occupancy.data(), ROWS, COLS, N, lattice, MAX_TIME, RoutingMethod::Assignment, nullptr), nullptr);
+    EXPECT_NE(findShot(cache, occupancy, lattice), nullptr);
+}
+
+TEST(PlanCacheTest, EvictsTheLeastRecentlyUsedPlan) {
+    PlanCache cache;
+    cache.configure(2, 1 << 30);
+    LatticeGeometry lattice = testLattice();
+    FrameContext context;
+    std::vector<uint8_t> shots[3] = { randomOccupancy(3), randomOccupancy(4), randomOccupancy(5) };
+    for (int s = 0; s < 2; s++) {
+        int numTweezers = 0;
+        int numFrames = routeShot(context, shots[s], lattice, numTweezers);
+        findShot(cache, shots[s], lattice);
+        cache.insert(context.trajectories, numTweezers, numFrames);
+    }
+    // Using the first shot leaves the second the least recently used, so the third takes its place.
+    EXPECT_NE(findShot(cache, shots[0], lattice), nullptr);
+    int numTweezers = 0;
+    int numFrames = routeShot(context, shots[2], lattice, numTweezers);
+    findShot(cache, shots[2], lattice);
+    cache.insert(context.trajectories, numTweezers, numFrames);
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.stats().evictions, 1);
+    EXPECT_NE(findShot(cache, shots[0], lattice), nullptr);
+    EXPECT_EQ(findShot(cache, shots[1], lattice), nullptr);
+    EXPECT_NE(findShot(cache, shots[2], lattice), nullptr);
+}
+
+TEST(PlanCacheTest, TrimKeepsTheCacheWithinItsBytes) {
+    PlanCache cache;
+    // Too small for two plans, so only the newest survives a trim.
+    cache.configure(8, 1);
+    LatticeGeometry lattice = testLattice();
+    FrameContext context;
+    for (unsigned seed = 6; seed < 9; seed++) {
+        std::vector<uint8_t> occupancy = randomOccupancy(seed);
+        int numTweezers = 0;
+        int numFrames = routeShot(context, occupancy, lattice, numTweezers);
+        findShot(cache, occupancy, lattice);
+        cache.insert(context.trajectories, numTweezers, numFrames);
+        cache.trim();
+        EXPECT_EQ(cache.size(), 1);
+        EXPECT_NE(findShot(cache, occupancy, lattice), nullptr);
+    }
+    EXPECT_EQ(cache.stats().evictions, 2);
+
+    PlanCache disabled;
+    disabled.configure(0, 1 << 30);
+    EXPECT_FALSE(disabled.enabled());
+}
+
+}  // namespace
@@ -0,0 +1,335 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "core/bitplane_rasterizer.h"
+#include "render/dmd_renderer.h"
+
+namespace {
+
+const int WIDTH = 1140;
+const int HEIGHT = 912;
+
+class RendererTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        srand(8);
+        occupancy.resize(12 * 12);
+        for (uint8_t& site : occupancy) site = rand() % 2;
+        request.occupancy = occupancy.data();
+        request.occupancyRows = 12;
+        request.occupancyCols = 12;
+        request.N = 10;
+        request.lattice.vec1X = 8.66f;
+        request.lattice.vec1Y = 5.0f;
+        request.lattice.vec2X = 8.66f;
+        request.lattice.vec2Y = -5.0f;
+        request.lattice.centerX = 456.0f;
+        request.lattice.centerY = 570.0f;
+        request.shape.shape = TweezerShape::Disc;
+        request.shape.size = 3;
+    }
+
+    DmdRendererConfig headlessConfig() {
+        DmdRendererConfig config;
+        config.headless = true;
+        config.captureToMemory = true;
+        config.shaderDirectory = DMD_SOURCE_DIRECTORY;
+        return config;
+    }
+
+    // render: runs the shot with the given configuration and returns the captured frames, or skips the test without EGL.
+    std::vector<std::vector<uint8_t>> render(const DmdRendererConfig& config, bool* usedGpuRaster = nullptr) {
+        DmdRenderer renderer;
+        std::vector<std::vector<uint8_t>> frames;
+        if (!renderer.init(config)) return frames;
+        ShotResult result = renderer.runShot(request);
+        EXPECT_TRUE(result.completed);
+        const FrameCapture& capture = renderer.display()->capture;
+        EXPECT_EQ(capture.numFrames, result.numRgbFrames);
+        for (int f = 0; f < capture.numFrames; f++) {
+            frames.emplace_back(capture.frame(f), capture.frame(f) + capture.frameBytes);
+        }
+        if (usedGpuRaster != nullptr) *usedGpuRaster = renderer.usingGpuRaster();
+        return frames;
+    }
+
+    std::vector<uint8_t> occupancy;
+    ShotRequest request;
+};
+
+TEST_F(RendererTest, CapturedFramesMatchTheCpuFrames) {
+    DmdRendererConfig config = headlessConfig();
+    config.pipelineWorkers = 0;
+    DmdRenderer renderer;
+    if (!renderer.init(config)) GTEST_SKIP() << "no EGL display";
+    ShotResult result = renderer.runShot(request);
+    ASSERT_TRUE(result.completed);
+    ASSERT_GT(result.numRgbFrames, 1);
+
+    // The renderer leaves the smoothed moves of the shot in its context, so each frame can be rebuilt on the CPU.
+    TweezerShapeRegistry shapes;
+    DmdRemap remap;
+    remap.build(WIDTH, HEIGHT, config.rowOffset);
+    FrameJob job;
+    job.trajectories = &renderer.context().trajectories;
+    job.numMoves = result.numMoves;
+    job.stamp = &shapes.get(request.shape);
+    job.inverted = config.inverted;
+    job.remap = &remap;
+    job.width = WIDTH;
+    job.height = HEIGHT;
+    std::vector<uint32_t> packed((size_t)WIDTH * HEIGHT), remapped((size_t)WIDTH * HEIGHT);
+    remap.fillOutside(remapped.data(), ALL_SUBFRAMES_MASK);
+
+    const FrameCapture& capture = renderer.display()->capture;
+    for (int f = 0; f < result.numRgbFrames; f++) {
+        const uint32_t* expected = renderFrame(job, f, packed.data(), remapped.data());
+        const uint8_t* captured = capture.frame(f);
+        long mismatches = 0;
+        for (int row = 0; row < HEIGHT; row++) {
+            // Captured frames start with the top row; the texture's first row is displayed at the bottom.
+            const uint32_t* source = expected + (size_t)(HEIGHT - 1 - row) * WIDTH;
+            const uint8_t* rgb = captured + (size_t)row * WIDTH * 3;
+            for (int col = 0; col < WIDTH; col++) {
+                uint32_t pixel = source[col];
+                if (rgb[col * 3] != ((pixel >> 16) & 255) || rgb[col * 3 + 1] != ((pixel >> 8) & 255) || rgb[col * 3 + 2] != (pixel & 255)) {
+                    mismatches++;
+                }
+            }
+        }
+        EXPECT_EQ(mismatches, 0) << "frame " << f;
+    }
+}
+
+TEST_F(RendererTest, AllRenderingPathsProduceTheSameFrames) {
+    DmdRendererConfig config = headlessConfig();
+    std::vector<std::vector<uint8_t>> reference = render(config);
+    if (reference.empty()) GTEST_SKIP() << "no EGL display";
+
+    config.pipelineWorkers = 0;
+    EXPECT_EQ(render(config), reference) << "rendered in line";
+
+    config.gpuRemap = true;
+    EXPECT_EQ(render(config), reference) << "remapped in the fragment shader";
+
+    for (GpuRasterPath path : { GpuRasterPath::Compute, GpuRasterPath::Instanced }) {
+        config.gpuRaster = true;
+        config.gpuRasterPath = path;
+        bool usedGpuRaster = false;
+        EXPECT_EQ(render(config, &usedGpuRaster), reference) << "rasterized on the GPU, path " << (int)path;
+        EXPECT_TRUE(usedGpuRaster);
+    }
+}
+
+TEST_F(RendererTest, RepeatedShotsReplayTheCachedPlanAndFrames) {
+    DmdRendererConfig config = headlessConfig();
+    std::vector<std::vector<uint8_t>> reference = render(config);
+    if (reference.empty()) GTEST_SKIP() << "no EGL display";
+
+    config.planCacheEntries = 4;
+    DmdRenderer renderer;
+    ASSERT_TRUE(renderer.init(config));
+    ShotResult first = renderer.runShot(request);
+    ShotResult second = renderer.runShot(request);
+    EXPECT_FALSE(first.planCached);
+    EXPECT_TRUE(second.planCached);
+    EXPECT_FALSE(second.framesCached);
+    EXPECT_EQ(second.numLatticeFrames, first.numLatticeFrames);
+    EXPECT_EQ(second.siteSteps, first.siteSteps);
+
+    config.cacheFrames = true;
+    ASSERT_TRUE(renderer.init(config));
+    renderer.runShot(request);
+    ShotResult replayed = renderer.runShot(request);
+    EXPECT_TRUE(replayed.framesCached);
+    const FrameCapture& capture = renderer.display()->capture;
+    ASSERT_EQ(capture.numFrames, (int)reference.size());
+    for (int f = 0; f < capture.numFrames; f++) {
+        EXPECT_EQ(std::vector<uint8_t>(capture.frame(f), capture.frame(f) + capture.frameBytes), reference[f]) << "frame " << f;
+    }
+    EXPECT_EQ(renderer.planCache().stats().hits, 1);
+}
+
+TEST_F(RendererTest, FramesThatDoNotFitAreNotCached) {
+    DmdRendererConfig config = headlessConfig();
+    config.planCacheEntries = 4;
+    DmdRenderer renderer;
+    if (!renderer.init(config)) GTEST_SKIP() << "no EGL display";
+    renderer.runShot(request);
+    size_t planBytes = renderer.planCache().capacityBytes();
+
+    // Room for the plan, but not for its frames.
+    config.planCacheBytes = planBytes + 1024;
+    config.cacheFrames = true;
+    ASSERT_TRUE(renderer.init(config));
+    ShotResult first = renderer.runShot(request);
+    ShotResult second = renderer.runShot(request);
+    ASSERT_GT((size_t)config.width * config.height * first.numRgbFrames * sizeof(uint32_t), (size_t)1024);
+    EXPECT_TRUE(first.completed);
+    EXPECT_TRUE(second.completed);
+    EXPECT_TRUE(second.planCached);
+    EXPECT_FALSE(second.framesCached);
+    EXPECT_EQ(renderer.planCache().stats().framesSkipped, 2);
+    EXPECT_LE(renderer.planCache().capacityBytes(), config.planCacheBytes);
+}
+
+TEST_F(RendererTest, AHeldShotIsRepairedAndContinuedFromItsFrame) {
+    DmdRendererConfig config = headlessConfig();
+    DmdRenderer renderer;
+    if (!renderer.init(config)) GTEST_SKIP() << "no EGL display";
+    const int holdFrame = 3;
+    ASSERT_GT(renderer.planShot(request).numLatticeFrames, holdFrame + 1);
+
+    request.holdFrame = holdFrame;
+    ShotResult held = renderer.runShot(request);
+    EXPECT_TRUE(held.completed);
+    EXPECT_TRUE(held.held);
+    EXPECT_EQ(renderer.heldFrame(), holdFrame);
+    EXPECT_EQ(held.numRgbFrames, request.N * holdFrame / SUBFRAMES_PER_FRAME + 1);
+    // The last frame is still displayed: reading the display back gives it again, not a black frame.
+    FrameCapture& capture = renderer.display()->capture;
+    ASSERT_EQ(capture.numFrames, held.numRgbFrames);
+    renderer.display()->captureFrame();
+    const uint8_t* last = capture.frame(held.numRgbFrames - 1);
+    const uint8_t* shown = capture.frame(held.numRgbFrames);
+    EXPECT_TRUE(std::equal(last, last + capture.frameBytes, shown));
+    EXPECT_TRUE(std::any_of(shown, shown + capture.frameBytes, [](uint8_t value) { return value != 0; }));
+
+    // The image finds the atom of the first tweezer lost.
+    const TrajectoryStore& plan = renderer.context().trajectories;
+    auto site = [&](const TrajectoryStore& trajectories, int frame, int i) {
+        return (trajectories.latticeRow(frame, i) + 6) * 12 + trajectories.latticeCol(frame, i) + 6;
+    };
+    std::vector<int> heldSites;
+    for (int i = 1; i < plan.numTweezers; i++) heldSites.push_back(site(plan, holdFrame, i));
+    std::vector<int8_t> delta(occupancy.size(), (int8_t)AtomChange::Unchanged);
+    delta[site(plan, holdFrame, 0)] = (int8_t)AtomChange::Lost;
+
+    request.holdFrame = -1;
+    ShotResult continued = renderer.replanShot(request, -1, delta.data());
+    EXPECT_TRUE(continued.completed);
+    EXPECT_FALSE(continued.held);
+    EXPECT_EQ(renderer.heldFrame(), -1);
+    EXPECT_EQ(continued.lostAtoms, 1);
+    EXPECT_GE(continued.repairedPaths, 0);
+    ASSERT_EQ(continued.numTweezers, held.numTweezers - 1);
+    EXPECT_EQ(capture.numFrames, continued.numRgbFrames);
+    // The repaired plan starts where the held frame left the atoms that remain.
+    const TrajectoryStore& repaired = renderer.context().trajectories;
+    std::vector<int> startSites;
+    for (int i = 0; i < repaired.numTweezers; i++) startSites.push_back(site(repaired, 0, i));
+    std::sort(heldSites.begin(), heldSites.end());
+    std::sort(startSites.begin(), startSites.end());
+    EXPECT_EQ(startSites, heldSites);
+    // Played to the end, the shot clears the display.
+    renderer.display()->captureFrame();
+    shown = capture.frame(capture.numFrames - 1);
+    EXPECT_TRUE(std::all_of(shown, shown + capture.frameBytes, [](uint8_t value) { return value == 0; }));
+}
+
+TEST_F(RendererTest, EmptyOccupancyDisplaysNothing) {
+    DmdRendererConfig config = headlessConfig();
+    DmdRenderer renderer;
+    if (!renderer.init(config)) GTEST_SKIP() << "no EGL display";
+    std::fill(occupancy.begin(), occupancy.end(), 0);
+    ShotResult result = renderer.runShot(request);
+    EXPECT_TRUE(result.completed);
+    EXPECT_EQ(result.numTweezers, 0);
+    EXPECT_EQ(result.numRgbFrames, 0);
+}
+
+TEST_F(RendererTest, PresentsArePacedAgainstTheRefreshRate) {
+    DmdRendererConfig config = headlessConfig();
+    config.captureToMemory = false;
+    DmdRenderer renderer;
+    if (!renderer.init(config)) GTEST_SKIP() << "no EGL display";
+
+    // The headless display has no refresh rate, so the presents are timed but not classified.
+    ShotResult result = renderer.runShot(request);
+    ASSERT_TRUE(result.completed);
+    const PacingReport& pacing = renderer.pacingReport();
+    EXPECT_EQ(pacing.presents, result.numRgbFrames);
+    EXPECT_EQ(pacing.intervals, result.numRgbFrames - 1);
+    EXPECT_GT(pacing.minIntervalMicroseconds, 0.0);
+    EXPECT_TRUE(pacing.exact());
+
+    // At 1 MHz every present after the first comes many refreshes late.
+    config.refreshRate = 1e6;
+    ASSERT_TRUE(renderer.init(config));
+    result = renderer.runShot(request);
+    EXPECT_TRUE(result.completed);
+    EXPECT_EQ(pacing.lateFrames, result.numRgbFrames - 1);
+    EXPECT_EQ(pacing.firstFaultFrame, 1);
+    EXPECT_GE(pacing.repeatedRefreshes, pacing.lateFrames);
+    EXPECT_FALSE(pacing.exact());
+}
+
+TEST_F(RendererTest, PacingFaultsAbortOrReissueTheShot) {
+    DmdRendererConfig config = headlessConfig();
+    DmdRenderer renderer;
+    if (!renderer.init(config)) GTEST_SKIP() << "no EGL display";
+    // The frames of the shot played through, against which the frames presented after a fault are checked.
+    ShotResult result = renderer.runShot(request);
+    ASSERT_TRUE(result.completed);
+    ASSERT_GT(result.numRgbFrames, 3);
+    std::vector<std::vector<uint8_t>> reference;
+    const FrameCapture& played = renderer.display()->capture;
+    for (int f = 0; f < played.numFrames; f++) reference.emplace_back(played.frame(f), played.frame(f) + played.frameBytes);
+    // init() opens the display again, so its capture is looked up after each shot.
+    auto expectPresented = [&](const std::vector<int>& frames) {
+        const FrameCapture& capture = renderer.display()->capture;
+        ASSERT_EQ(capture.numFrames, (int)frames.size());
+        for (int f = 0; f < capture.numFrames; f++) {
+            EXPECT_EQ(std::vector<uint8_t>(capture.frame(f), capture.frame(f) + capture.frameBytes), reference[frames[f]])
+                << "present " << f << " should show frame " << frames[f];
+        }
+    };
+
+    // At 1 MHz every present after the first of a run comes late.
+    config.refreshRate = 1e6;
+    config.pacingAction = PacingAction::Abort;
+    ASSERT_TRUE(renderer.init(config));
+    result = renderer.runShot(request);
+    EXPECT_FALSE(result.completed);
+    const PacingReport& pacing = renderer.pacingReport();
+    EXPECT_TRUE(pacing.aborted);
+    EXPECT_EQ(pacing.presents, 2);
+    EXPECT_EQ(pacing.reissues, 0);
+    expectPresented({ 0, 1 });
+
+    // A late frame is presented again, never going back to the first frame, for as long as it comes late and the budget lasts.
+    config.pacingAction = PacingAction::Reissue;
+    config.maxReissues = 2;
+    ASSERT_TRUE(renderer.init(config));
+    result = renderer.runShot(request);
+    EXPECT_FALSE(result.completed);
+    EXPECT_TRUE(pacing.aborted);
+    EXPECT_EQ(pacing.reissues, 2);
+    EXPECT_EQ(pacing.presents, 4);
+    EXPECT_EQ(pacing.lateFrames, 3);
+    EXPECT_EQ(pacing.firstFaultFrame, 1);
+    expectPresented({ 0, 1, 1, 1 });
+
+    // At 1 Hz every present after the first replaces a frame that was never shown, which cannot be reissued.
+    config.refreshRate = 1.0;
+    ASSERT_TRUE(renderer.init(config));
+    result = renderer.runShot(request);
+    EXPECT_FALSE(result.completed);
+    EXPECT_TRUE(pacing.aborted);
+    EXPECT_EQ(pacing.droppedFrames, 1);
+    EXPECT_EQ(pacing.reissues, 0);
+    expectPresented({ 0, 1 });
+
+    // Once the faults stop, the same renderer plays shots through again.
+    config.refreshRate = 0.0;
+    ASSERT_TRUE(renderer.init(config));
+    result = renderer.runShot(request);
+    EXPECT_TRUE(result.completed);
+    EXPECT_EQ(pacing.reissues, 0);
+    EXPECT_FALSE(pacing.aborted);
+}
+
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "core/frame_context.h"
+#include "core/replan_router.h"
+#include "core/router.h"
+
+namespace {
+
+const int ROWS = 12, COLS = 12, N = 4, MAX_TIME = 40;
+
+LatticeGeometry testLattice() {
+    LatticeGeometry lattice;
+    lattice.vec1X = 10.0f;
+    lattice.vec2Y = 10.0f;
+    lattice.centerX = 400.0f;
+    lattice.centerY = 300.0f;
+    return lattice;
+}
+
+// planShot: routes and smooths a random occupancy matrix in context, and returns the number of lattice frames.
+int planShot(FrameContext& context, unsigned seed, RoutingMethod method, const uint8_t* targetPattern = nullptr) {
+    srand(seed);
+    std::vector<int> occupancy((size_t)ROWS * COLS);
+    int numTweezers = 0;
+    for (int& site : occupancy) {
+        site = rand() % 2;
+        numTweezers += site;
+    }
+    context.prepare(ROWS, COLS, numTweezers, N, MAX_TIME);
+    int** tweezerPositions = context.tweezerPositions();
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) tweezerPositions[i][j] = occupancy[i * COLS + j];
+    }
+    return generateFrames(numTweezers, ROWS, COLS, tweezerPositions, context.trajectories, N, testLattice(), MAX_TIME, method,
+                          &context.routing, &context.reservation, &context.centerOfMass, targetPattern);
+}
+
+// site: the site of tweezer i in a lattice frame of a smoothed plan, numbered row-major from the corner of the occupancy matrix.
+int site(const TrajectoryStore& trajectories, int frame, int i) {
+    return (trajectories.latticeRow(frame, i) + ROWS / 2) * COLS + trajectories.latticeCol(frame, i) + COLS / 2;
+}
+
+// expectValidMoves: checks that every tweezer of a smoothed plan moves at most one site per frame, and that no two tweezers share a
+// site or swap sites.
+void expectValidMoves(const TrajectoryStore& trajectories, int numFrames) {
+    for (int frame = 0; frame < numFrames; frame++) {
+        std::set<int> sites;
+        std::set<std::pair<int, int>> steps;
+        for (int i = 0; i < trajectories.numTweezers; i++) {
+            EXPECT_TRUE(sites.insert(site(trajectories, frame, i)).second) << "two tweezers share a site in frame " << frame;
+            if (frame == 0) continue;
+            int from = site(trajectories, frame - 1, i), to = site(trajectories, frame, i);
+            EXPECT_LE(abs(to / COLS - from / COLS) + abs(to % COLS - from % COLS), 1);
+            if (from != to) steps.insert({ from, to });
+        }
+        for (const auto& step : steps) {
+            EXPECT_EQ(steps.count({ step.second, step.first }), 0u) << "two tweezers swap sites in frame " << frame;
+        }
+    }
+}
+
+TEST(ReplanRouterTest, WithoutChangesTheRestOfThePlanIsKept) {
+    FrameContext context;
+    int planFrames = planShot(context, 1, RoutingMethod::Assignment);
+    ASSERT_GT(planFrames, 3);
+    const TrajectoryStore& plan = context.trajectories;
+    std::vector<int8_t> delta((size_t)ROWS * COLS, (int8_t)AtomChange::Unchanged);
+
+    TrajectoryStore repaired;
+    ReplanWorkspace workspace;
+    const int fromFrame = 2;
+    int numFrames = replanFrames(plan, planFrames, fromFrame, delta.data(), ROWS, COLS, repaired, N, testLattice(), MAX_TIME,
+                                 workspace, context.reservation);
+    EXPECT_EQ(numFrames, planFrames - fromFrame);
+    ASSERT_EQ(repaired.numTweezers, plan.numTweezers);
+    EXPECT_EQ(workspace.repairedPaths, 0);
+    // The repaired moves are the moves of the plan from the frame of the image on.
+    for (int move = 0; move < N * (numFrames - 1) + 1; move++) {
+        for (int i = 0; i < plan.numTweezers; i++) {
+            EXPECT_EQ(repaired.moveX(move)[i], plan.moveX(fromFrame * N + move)[i]);
+            EXPECT_EQ(repaired.moveY(move)[i], plan.moveY(fromFrame * N + move)[i]);
+        }
+    }
+}
+
+TEST(ReplanRouterTest, AnExtraAtomFillsTheHoleOfALostOne) {
+    FrameContext context;
+    int planFrames = planShot(context, 2, RoutingMethod::Assignment);
+    const TrajectoryStore& plan = context.trajectories;
+    const int fromFrame = 1;
+    std::vector<int8_t> delta((size_t)ROWS * COLS, (int8_t)AtomChange::Unchanged);
+    // Lose the first tweezer, and find an extra atom on the first site left empty in the frame of the image.
+    const int lost = 0;
+    delta[site(plan, fromFrame, lost)] = (int8_t)AtomChange::Lost;
+    std::vector<char> occupied((size_t)ROWS * COLS, 0);
+    for (int i = 0; i < plan.numTweezers; i++) occupied[site(plan, fromFrame, i)] = 1;
+    int extra = 0;
+    while (occupied[extra]) extra++;
+    delta[extra] = (int8_t)AtomChange::Extra;
+
+    TrajectoryStore repaired;
+    ReplanWorkspace workspace;
+    int numFrames = replanFrames(plan, planFrames, fromFrame, delta.data(), ROWS, COLS, repaired, N, testLattice(), MAX_TIME,
+                                 workspace, context.reservation);
+    ASSERT_GT(numFrames, 0);
+    EXPECT_EQ(workspace.lostAtoms, 1);
+    EXPECT_EQ(workspace.extraAtoms, 1);
+    EXPECT_EQ(workspace.holesFilled, 1);
+    EXPECT_EQ(workspace.repairedPaths, 1);
+    ASSERT_EQ(repaired.numTweezers, plan.numTweezers);
+    expectValidMoves(repaired, numFrames);
+
+    // The extra atom, numbered last, starts on its site and ends on the hole; the other tweezers follow their old paths.
+    int added = repaired.numTweezers - 1;
+    EXPECT_EQ(site(repaired, 0, added), extra);
+    EXPECT_EQ(site(repaired, numFrames - 1, added), site(plan, planFrames - 1, lost));
+    for (int k = 0; k < added; k++) {
+        for (int frame = 0; frame < numFrames; frame++) {
+            int planFrame = std::min(fromFrame + frame, planFrames - 1);
+            EXPECT_EQ(site(repaired, frame, k), site(plan, planFrame, k + 1)) << "tweezer " << k << ", frame " << frame;
+        }
+    }
+}
+
+TEST(ReplanRouterTest, AnExtraAtomInTheWayTakesOverThePathThroughIt) {
+    FrameContext context;
+    int planFrames = planShot(context, 4, RoutingMethod::CenterOfMass);
+    const TrajectoryStore& plan = context.trajectories;
+    const int fromFrame = 0;
+    // Find an extra atom on a site that is empty in the frame of the image, but that a tweezer passes later.
+    std::vector<char> occupied((size_t)ROWS * COLS, 0), passed((size_t)ROWS * COLS, 0);
+    for (int i = 0; i < plan.numTweezers; i++) {
+        occupied[site(plan, fromFrame, i)] = 1;
+        for (int frame = fromFrame + 1; frame < planFrames; frame++) passed[site(plan, frame, i)] = 1;
+    }
+    int extra = 0;
+    while (extra < ROWS * COLS && (occupied[extra] || !passed[extra])) extra++;
+    ASSERT_LT(extra, ROWS * COLS);
+    std::vector<int8_t> delta((size_t)ROWS * COLS, (int8_t)AtomChange::Unchanged);
+    delta[extra] = (int8_t)AtomChange::Extra;
+
+    TrajectoryStore repaired;
+    ReplanWorkspace workspace;
+    int numFrames = replanFrames(plan, planFrames, fromFrame, delta.data(), ROWS, COLS, repaired, N, testLattice(), MAX_TIME,
+                                 workspace, context.reservation);
+    ASSERT_GT(numFrames, 0);
+    EXPECT_EQ(workspace.repairedPaths, 0);
+    ASSERT_EQ(repaired.numTweezers, plan.numTweezers + 1);
+    expectValidMoves(repaired, numFrames);
+    // Every site the plan ended on is still filled, and the extra atom starts on its own.
+    std::set<int> ends;
+    for (int i = 0; i < repaired.numTweezers; i++) ends.insert(site(repaired, numFrames - 1, i));
+    for (int i = 0; i < plan.numTweezers; i++) EXPECT_EQ(ends.count(site(plan, planFrames - 1, i)), 1u);
+    EXPECT_EQ(site(repaired, 0, repaired.numTweezers - 1), extra);
+}
+
+TEST(ReplanRouterTest, ASurplusAtomFillsALostTarget) {
+    // A 4 x 4 block of targets in the middle, with a reservoir along the top row.
+    std::vector<uint8_t> pattern((size_t)ROWS * COLS, (uint8_t)TargetSite::Free);
+    for (int i = 4; i < 8; i++) {
+        for (int j = 4; j < 8; j++) pattern[i * COLS + j] = (uint8_t)TargetSite::Target;
+    }
+    for (int j = 0; j < COLS; j++) pattern[j] = (uint8_t)TargetSite::Reservoir;
+
+    FrameContext context;
+    int planFrames = planShot(context, 3, RoutingMethod::Assignment, pattern.data());
+    const TrajectoryStore& plan = context.trajectories;
+    const int fromFrame = 1;
+    int lost = 0;
+    while (pattern[site(plan, planFrames - 1, lost)] != (uint8_t)TargetSite::Target) lost++;
+    std::vector<int8_t> delta((size_t)ROWS * COLS, (int8_t)AtomChange::Unchanged);
+    delta[site(plan, fromFrame, lost)] = (int8_t)AtomChange::Lost;
+
+    TrajectoryStore repaired;
+    ReplanWorkspace workspace;
+    int numFrames = replanFrames(plan, planFrames, fromFrame, delta.data(), ROWS, COLS, repaired, N, testLattice(), MAX_TIME,
+                                 workspace, context.reservation, pattern.data());
+    ASSERT_GT(numFrames, 0);
+    EXPECT_EQ(workspace.holesFilled, 1);
+    EXPECT_EQ(repaired.numTweezers, plan.numTweezers - 1);
+    expectValidMoves(repaired, numFrames);
+    int filled = 0;
+    for (int i = 0; i < repaired.numTweezers; i++) filled += pattern[site(repaired, numFrames - 1, i)] == (uint8_t)TargetSite::Target;
+    EXPECT_EQ(filled, 16);
+}
+
+}  // namespace
@@ -0,0 +1,326 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "core/frame_context.h"
+#include "core/router.h"
+
+namespace {
+
+// loadOccupancy: copies a row-major matrix into the context's occupancy matrix and returns the number of atoms.
+int loadOccupancy(FrameContext& context, const std::vector<int>& occupancy, int rows, int cols, int N, int maxTime) {
+    int numTweezers = 0;
+    for (int value : occupancy) numTweezers += value == 1;
+    context.prepare(rows, cols, numTweezers, N, maxTime);
+    int** tweezerPositions = context.tweezerPositions();
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) tweezerPositions[i][j] = occupancy[i * cols + j];
+    }
+    return numTweezers;
+}
+
+std::vector<int> randomOccupancy(int rows, int cols, double fill, unsigned seed) {
+    srand(seed);
+    std::vector<int> occupancy((size_t)rows * cols);
+    for (int& site : occupancy) site = rand() < fill * RAND_MAX ? 1 : 0;
+    return occupancy;
+}
+
+// expectValidMoves: checks that every tweezer stays on the lattice and moves at most one site per frame, and that no two tweezers
+// share a site or swap sites.
+void expectValidMoves(TrajectoryStore& trajectories, int numTweezers, int numFrames, int rows, int cols,
+                      LatticeTopology topology = LatticeTopology::Square) {
+    const LatticeNeighbourhood& neighbourhood = latticeNeighbourhood(topology);
+    for (int frame = 0; frame < numFrames; frame++) {
+        std::set<std::pair<int, int>> sites;
+        for (int i = 0; i < numTweezers; i++) {
+            int row = trajectories.latticeRow(frame, i);
+            int col = trajectories.latticeCol(frame, i);
+            ASSERT_TRUE(row >= 0 && row < rows && col >= 0 && col < cols);
+            EXPECT_TRUE(sites.insert({ row, col }).second) << "two tweezers share a site in frame " << frame;
+            if (frame > 0) {
+                EXPECT_LE(neighbourhood.distance(row - trajectories.latticeRow(frame - 1, i), col - trajectories.latticeCol(frame - 1, i)), 1);
+            }
+        }
+        if (frame == 0) continue;
+        std::set<std::pair<std::pair<int, int>, std::pair<int, int>>> steps;
+        for (int i = 0; i < numTweezers; i++) {
+            std::pair<int, int> from(trajectories.latticeRow(frame - 1, i), trajectories.latticeCol(frame - 1, i));
+            std::pair<int, int> to(trajectories.latticeRow(frame, i), trajectories.latticeCol(frame, i));
+            if (from != to) steps.insert({ from, to });
+        }
+        for (const auto& step : steps) {
+            EXPECT_EQ(steps.count({ step.second, step.first }), 0u) << "two tweezers swap sites in frame " << frame;
+        }
+    }
+}
+
+TEST(RouterTest, MovesAreSingleStepsWithoutCollisions) {
+    const int rows = 20, cols = 20, maxTime = 40;
+    FrameContext context;
+    std::vector<int> occupancy = randomOccupancy(rows, cols, 0.5, 6);
+    int numTweezers = loadOccupancy(context, occupancy, rows, cols, 1, maxTime);
+    TrajectoryStore& trajectories = context.trajectories;
+    int numFrames = routeCenterOfMass(numTweezers, rows, cols, context.tweezerPositions(), trajectories, maxTime);
+    ASSERT_GT(numFrames, 1);
+    ASSERT_LE(numFrames, maxTime);
+    expectValidMoves(trajectories, numTweezers, numFrames, rows, cols);
+}
+
+TEST(RouterTest, AssignmentFillsTheSitesClosestToTheCenterOfMass) {
+    const int rows = 20, cols = 20, maxTime = 40;
+    for (double fill : { 0.2, 0.5, 0.8 }) {
+        FrameContext context;
+        std::vector<int> occupancy = randomOccupancy(rows, cols, fill, 11);
+        int numTweezers = loadOccupancy(context, occupancy, rows, cols, 1, maxTime);
+        TrajectoryStore& trajectories = context.trajectories;
+        double comRow = 0.0, comCol = 0.0;
+        for (int s = 0; s < rows * cols; s++) {
+            comRow += occupancy[s] * (s / cols);
+            comCol += occupancy[s] * (s % cols);
+        }
+        comRow /= numTweezers;
+        comCol /= numTweezers;
+
+        int numFrames = routeAssignment(numTweezers, rows, cols, context.tweezerPositions(), trajectories, maxTime, context.routing);
+        ASSERT_LT(numFrames, maxTime) << "fill " << fill;
+        expectValidMoves(trajectories, numTweezers, numFrames, rows, cols);
+
+        // Every tweezer ends on one of the numTweezers sites closest to the center of mass, and the tweezers never step further than
+        // the optimal assignment requires.
+        std::vector<std::pair<double, int>> byDistance;
+        for (int s = 0; s < rows * cols; s++) {
+            double dRow = s / cols - comRow, dCol = s % cols - comCol;
+            byDistance.push_back({ dRow * dRow + dCol * dCol, s });
+        }
+        std::sort(byDistance.begin(), byDistance.end());
+        std::set<int> targets;
+        for (int t = 0; t < numTweezers; t++) targets.insert(byDistance[t].second);
+        for (int i = 0; i < numTweezers; i++) {
+            int site = trajectories.latticeRow(numFrames - 1, i) * cols + trajectories.latticeCol(numFrames - 1, i);
+            EXPECT_EQ(targets.count(site), 1u) << "fill " << fill << ", tweezer " << i;
+        }
+        EXPECT_EQ(countLatticeMoves(trajectories, numTweezers, numFrames), context.routing.assignmentCost) << "fill " << fill;
+        int** tweezerPositions = context.tweezerPositions();
+        for (int site : targets) EXPECT_EQ(tweezerPositions[site / cols][site % cols], 1);
+    }
+}
+
+TEST(RouterTest, AssignmentTakesFewerStepsThanCenterOfMass) {
+    const int rows = 20, cols = 20, maxTime = 40;
+    std::vector<int> occupancy = randomOccupancy(rows, cols, 0.5, 12);
+    FrameContext com, assignment;
+    int numTweezers = loadOccupancy(com, occupancy, rows, cols, 1, maxTime);
+    loadOccupancy(assignment, occupancy, rows, cols, 1, maxTime);
+    int comFrames = routeCenterOfMass(numTweezers, rows, cols, com.tweezerPositions(), com.trajectories, maxTime);
+    int assignmentFrames = routeAssignment(numTweezers, rows, cols, assignment.tweezerPositions(), assignment.trajectories, maxTime,
+                                           assignment.routing);
+    EXPECT_LE(countLatticeMoves(assignment.trajectories, numTweezers, assignmentFrames),
+              countLatticeMoves(com.trajectories, numTweezers, comFrames));
+}
+
+TEST(RouterTest, TriangularRoutesTakeDiagonalSteps) {
+    const int rows = 20, cols = 20, maxTime = 40;
+    std::vector<int> occupancy = randomOccupancy(rows, cols, 0.3, 11);
+    FrameContext square, triangular, com;
+    int numTweezers = loadOccupancy(square, occupancy, rows, cols, 1, maxTime);
+    loadOccupancy(triangular, occupancy, rows, cols, 1, maxTime);
+    loadOccupancy(com, occupancy, rows, cols, 1, maxTime);
+    int squareFrames = routeAssignment(numTweezers, rows, cols, square.tweezerPositions(), square.trajectories, maxTime, square.routing);
+    int triangularFrames = routeAssignment(numTweezers, rows, cols, triangular.tweezerPositions(), triangular.trajectories, maxTime,
+                                           triangular.routing, LatticeTopology::Triangular);
+    ASSERT_LT(triangularFrames, maxTime);
+    expectValidMoves(triangular.trajectories, numTweezers, triangularFrames, rows, cols, LatticeTopology::Triangular);
+
+    // Every tweezer reaches its target along a shortest path, and some of those paths take the vec1 - vec2 diagonal.
+    long long triangularSteps = countLatticeMoves(triangular.trajectories, numTweezers, triangularFrames, LatticeTopology::Triangular);
+    EXPECT_EQ(triangularSteps, triangular.routing.assignmentCost);
+    int diagonalSteps = 0;
+    for (int frame = 1; frame < triangularFrames; frame++) {
+        for (int i = 0; i < numTweezers; i++) {
+            int dRow = triangular.trajectories.latticeRow(frame, i) - triangular.trajectories.latticeRow(frame - 1, i);
+            int dCol = triangular.trajectories.latticeCol(frame, i) - triangular.trajectories.latticeCol(frame - 1, i);
+            diagonalSteps += dRow != 0 && dCol != 0;
+        }
+    }
+    EXPECT_GT(diagonalSteps, 0);
+    EXPECT_LT(triangularSteps, countLatticeMoves(square.trajectories, numTweezers, squareFrames));
+
+    int comFrames = routeCenterOfMass(numTweezers, rows, cols, com.tweezerPositions(), com.trajectories, maxTime,
+                                      LatticeTopology::Triangular);
+    expectValidMoves(com.trajectories, numTweezers, comFrames, rows, cols, LatticeTopology::Triangular);
+}
+
+TEST(RouterTest, ReservationShortensTheAssignmentPlan) {
+    const int rows = 20, cols = 20, maxTime = 40;
+    int savedFrames = 0;
+    for (LatticeTopology topology : { LatticeTopology::Square, LatticeTopology::Triangular }) {
+        for (double fill : { 0.2, 0.5, 0.8 }) {
+            std::vector<int> occupancy = randomOccupancy(rows, cols, fill, 1);
+            FrameContext assignment, reservation;
+            int numTweezers = loadOccupancy(assignment, occupancy, rows, cols, 1, maxTime);
+            loadOccupancy(reservation, occupancy, rows, cols, 1, maxTime);
+            int assignmentFrames = routeAssignment(numTweezers, rows, cols, assignment.tweezerPositions(), assignment.trajectories, maxTime,
+                                                   assignment.routing, topology);
+            int reservationFrames = routeReservation(numTweezers, rows, cols, reservation.tweezerPositions(), reservation.trajectories,
+                                                     maxTime, reservation.routing, reservation.reservation, topology);
+            expectValidMoves(reservation.trajectories, numTweezers, reservationFrames, rows, cols, topology);
+
+            // The plan is never longer than the one it started from, and every tweezer still ends on the same site.
+            EXPECT_EQ(reservation.reservation.assignmentFrames, assignmentFrames);
+            EXPECT_LE(reservationFrames, assignmentFrames) << "fill " << fill;
+            savedFrames += assignmentFrames - reservationFrames;
+            for (int i = 0; i < numTweezers; i++) {
+                EXPECT_EQ(reservation.trajectories.latticeRow(reservationFrames - 1, i),
+                          assignment.trajectories.latticeRow(assignmentFrames - 1, i));
+                EXPECT_EQ(reservation.trajectories.latticeCol(reservationFrames - 1, i),
+                          assignment.trajectories.latticeCol(assignmentFrames - 1, i));
+            }
+        }
+    }
+    EXPECT_GT(savedFrames, 0);
+}
+
+TEST(RouterTest, AssignmentLeavesAFilledRegionAlone) {
+    const int rows = 6, cols = 6, maxTime = 10;
+    std::vector<int> occupancy((size_t)rows * cols, 0);
+    for (int i = 2; i < 4; i++) {
+        for (int j = 2; j < 4; j++) occupancy[i * cols + j] = 1;
+    }
+    FrameContext context;
+    int numTweezers = loadOccupancy(context, occupancy, rows, cols, 1, maxTime);
+    EXPECT_EQ(routeAssignment(numTweezers, rows, cols, context.tweezerPositions(), context.trajectories, maxTime, context.routing), 1);
+    EXPECT_EQ(context.routing.assignmentCost, 0);
+}
+
+TEST(RouterTest, PatternFillsTargetsAndParksTheSurplus) {
+    // A defect-free 8 x 8 block in the middle, with the surplus atoms parked in the first and last rows.
+    const int rows = 20, cols = 20, maxTime = 40;
+    std::vector<uint8_t> pattern((size_t)rows * cols, (uint8_t)TargetSite::Free);
+    for (int i = 6; i < 14; i++) {
+        for (int j = 6; j < 14; j++) pattern[i * cols + j] = (uint8_t)TargetSite::Target;
+    }
+    for (int j = 0; j < cols; j++) {
+        pattern[j] = (uint8_t)TargetSite::Reservoir;
+        pattern[(rows - 1) * cols + j] = (uint8_t)TargetSite::Reservoir;
+    }
+    std::vector<int> occupancy = randomOccupancy(rows, cols, 0.5, 21);
+    FrameContext assignment, reservation;
+    int numTweezers = loadOccupancy(assignment, occupancy, rows, cols, 1, maxTime);
+    loadOccupancy(reservation, occupancy, rows, cols, 1, maxTime);
+    ASSERT_GT(numTweezers, 64 + 2 * cols);
+
+    int numFrames = routeAssignment(numTweezers, rows, cols, assignment.tweezerPositions(), assignment.trajectories, maxTime,
+                                    assignment.routing, LatticeTopology::Square, pattern.data());
+    ASSERT_LT(numFrames, maxTime);
+    expectValidMoves(assignment.trajectories, numTweezers, numFrames, rows, cols);
+    EXPECT_EQ(assignment.routing.numTargets, 64);
+    EXPECT_EQ(assignment.routing.targetsFilled, 64);
+    EXPECT_EQ(assignment.routing.parkedAtoms, 2 * cols);
+    int** tweezerPositions = assignment.tweezerPositions();
+    for (int s = 0; s < rows * cols; s++) {
+        if (pattern[s] != (uint8_t)TargetSite::Free) {
+            EXPECT_EQ(tweezerPositions[s / cols][s % cols], 1) << "site " << s;
+        }
+    }
+    // Exchanging targets never lengthens the paths of the assignment.
+    EXPECT_LE(countLatticeMoves(assignment.trajectories, numTweezers, numFrames), assignment.routing.assignmentCost);
+
+    int reservationFrames = routeReservation(numTweezers, rows, cols, reservation.tweezerPositions(), reservation.trajectories, maxTime,
+                                             reservation.routing, reservation.reservation, LatticeTopology::Square, pattern.data());
+    expectValidMoves(reservation.trajectories, numTweezers, reservationFrames, rows, cols);
+    EXPECT_LE(reservationFrames, numFrames);
+    for (int i = 0; i < numTweezers; i++) {
+        EXPECT_EQ(reservation.trajectories.latticeRow(reservationFrames - 1, i), assignment.trajectories.latticeRow(numFrames - 1, i));
+        EXPECT_EQ(reservation.trajectories.latticeCol(reservationFrames - 1, i), assignment.trajectories.latticeCol(numFrames - 1, i));
+    }
+}
+
+TEST(RouterTest, PatternWithMoreTargetsThanAtomsPlacesEveryAtom) {
+    // A checkerboard of 50 targets for about 30 atoms, routed through generateFrames, which takes the pattern over the center of mass.
+    const int rows = 10, cols = 10, maxTime = 40;
+    std::vector<uint8_t> pattern((size_t)rows * cols);
+    for (int s = 0; s < rows * cols; s++) pattern[s] = (uint8_t)((s / cols + s % cols) % 2 == 0 ? TargetSite::Target : TargetSite::Free);
+    std::vector<int> occupancy = randomOccupancy(rows, cols, 0.3, 4);
+    FrameContext context;
+    int numTweezers = loadOccupancy(context, occupancy, rows, cols, 1, maxTime);
+    ASSERT_LT(numTweezers, 50);
+    LatticeGeometry lattice;
+    int numFrames = generateFrames(numTweezers, rows, cols, context.tweezerPositions(), context.trajectories, 1, lattice, maxTime,
+                                   RoutingMethod::CenterOfMass, &context.routing, &context.reservation, &context.centerOfMass,
+                                   pattern.data());
+    ASSERT_LT(numFrames, maxTime);
+    EXPECT_EQ(context.routing.numTargets, 50);
+    EXPECT_EQ(context.routing.targetsFilled, numTweezers);
+    EXPECT_EQ(context.routing.parkedAtoms, 0);
+    // Smoothing recenters the lattice stage, so the final sites are read from the occupancy matrix.
+    int** tweezerPositions = context.tweezerPositions();
+    for (int s = 0; s < rows * cols; s++) {
+        if (tweezerPositions[s / cols][s % cols] == 1) {
+            EXPECT_EQ(pattern[s], (uint8_t)TargetSite::Target) << "site " << s;
+        }
+    }
+}
+
+TEST(RouterTest, StopsAtMaxTime) {
+    const int rows = 30, cols = 30, maxTime = 3;
+    FrameContext context;
+    std::vector<int> occupancy((size_t)rows * cols, 0);
+    occupancy[0] = 1;
+    occupancy[rows * cols - 1] = 1;
+    int numTweezers = loadOccupancy(context, occupancy, rows, cols, 1, maxTime);
+    EXPECT_EQ(routeCenterOfMass(numTweezers, rows, cols, context.tweezerPositions(), context.trajectories, maxTime), maxTime);
+}
+
+TEST(RouterTest, SmoothingInterpolatesBetweenLatticeSites) {
+    const int rows = 4, cols = 4, N = 5;
+    TrajectoryStore trajectories;
+    trajectories.reserve(1, N, 2);
+    trajectories.latticeRow(0, 0) = 2;
+    trajectories.latticeCol(0, 0) = 2;
+    trajectories.latticeRow(1, 0) = 3;
+    trajectories.latticeCol(1, 0) = 2;
+    LatticeGeometry lattice;
+    lattice.vec1X = 10.0f;
+    lattice.vec1Y = 5.0f;
+    lattice.vec2X = -4.0f;
+    lattice.vec2Y = 8.0f;
+    lattice.centerX = 400.0f;
+    lattice.centerY = 300.0f;
+
+    EXPECT_EQ(smoothTrajectories(trajectories, 1, 2, rows, cols, N, lattice), N + 1);
+    // Site (2, 2) is the center of a 4 x 4 matrix, and site (3, 2) is one vec1 away from it.
+    for (int k = 0; k <= N; k++) {
+        EXPECT_FLOAT_EQ(trajectories.moveX(k, 0), 400.0f + 10.0f * k / N);
+        EXPECT_FLOAT_EQ(trajectories.moveY(k, 0), 300.0f + 5.0f * k / N);
+    }
+}
+
+TEST(RouterTest, GenerateFramesEndsOnTheRoutedSites) {
+    const int rows = 10, cols = 10, N = 4, maxTime = 40;
+    FrameContext context;
+    std::vector<int> occupancy = randomOccupancy(rows, cols, 0.3, 7);
+    int numTweezers = loadOccupancy(context, occupancy, rows, cols, N, maxTime);
+    LatticeGeometry lattice;
+    lattice.vec1X = 8.66f;
+    lattice.vec1Y = 5.0f;
+    lattice.vec2X = 8.66f;
+    lattice.vec2Y = -5.0f;
+    lattice.centerX = 456.0f;
+    lattice.centerY = 570.0f;
+    TrajectoryStore& trajectories = context.trajectories;
+    int numFrames = generateFrames(numTweezers, rows, cols, context.tweezerPositions(), trajectories, N, lattice, maxTime);
+    int lastMove = N * (numFrames - 1);
+    for (int i = 0; i < numTweezers; i++) {
+        EXPECT_EQ(trajectories.moveX(lastMove, i), trajectories.dmdX(numFrames - 1, i));
+        EXPECT_EQ(trajectories.moveY(lastMove, i), trajectories.dmdY(numFrames - 1, i));
+    }
+}
+
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "cli/shot_file.h"
+
+namespace {
+
+std::string writeTemporary(const std::string& name, const std::string& contents) {
+    std::string path = ::testing::TempDir() + name;
+    std::ofstream(path) << contents;
+    return path;
+}
+
+TEST(ShotFileTest, ReadsTheExampleShot) {
+    ShotFile shot;
+    std::string error;
+    ASSERT_TRUE(readShotFile(DMD_SOURCE_DIRECTORY "cli/examples/half_filled_20x20.txt", shot, error)) << error;
+    EXPECT_EQ(shot.request.occupancyRows, 20);
+    EXPECT_EQ(shot.request.occupancyCols, 20);
+    EXPECT_EQ(shot.request.N, 50);
+    EXPECT_EQ(shot.request.shape.size, 3);
+    EXPECT_FLOAT_EQ(shot.request.lattice.vec2Y, -5.0f);
+    EXPECT_EQ(shot.request.occupancy, shot.occupancy.data());
+    EXPECT_EQ(shot.occupancy.size(), 400u);
+}
+
+TEST(ShotFileTest, ReadsShapesAndMasks) {
+    std::string path = writeTemporary("shot_mask.txt",
+        "size 2 3\nN 2\nvec1 1 0\nvec2 0 1\ncenter 10 10\n# comment\nshape custom\nmask 1 2\n1 0\noccupancy\n1 0 1\n0 1 0\n");
+    ShotFile shot;
+    std::string error;
+    ASSERT_TRUE(readShotFile(path, shot, error)) << error;
+    EXPECT_EQ(shot.request.shape.shape, TweezerShape::Custom);
+    EXPECT_EQ(shot.request.shape.maskRows, 1);
+    EXPECT_EQ(shot.request.shape.maskCols, 2);
+    ASSERT_NE(shot.request.shape.mask, nullptr);
+    EXPECT_EQ(shot.request.shape.mask[0], 1);
+    EXPECT_EQ(shot.request.occupancy[2], 1);
+    EXPECT_EQ(shot.request.occupancy[3], 0);
+    remove(path.c_str());
+}
+
+TEST(ShotFileTest, ReadsRoutingAndTopology) {
+    std::string path = writeTemporary("shot_routing.txt",
+        "size 1 2\nN 1\nvec1 8.66 5\nvec2 8.66 -5\ncenter 10 10\nrouting assignment\ntopology triangular\noccupancy\n1 0\n");
+    ShotFile shot;
+    std::string error;
+    ASSERT_TRUE(readShotFile(path, shot, error)) << error;
+    EXPECT_EQ(shot.request.routing, RoutingMethod::Assignment);
+    EXPECT_EQ(shot.request.lattice.topology, LatticeTopology::Triangular);
+    LatticeTopology topology = LatticeTopology::Triangular;
+    EXPECT_TRUE(parseLatticeTopology("0", topology));
+    EXPECT_EQ(topology, LatticeTopology::Square);
+    EXPECT_FALSE(parseLatticeTopology("hexagonal", topology));
+    remove(path.c_str());
+}
+
+TEST(ShotFileTest, ReadsATargetPattern) {
+    std::string path = writeTemporary("shot_target.txt",
+        "size 2 2\nN 1\nvec1 1 0\nvec2 0 1\ncenter 10 10\noccupancy\n1 0\n0 1\ntarget\n1 1\n2 0\n");
+    ShotFile shot;
+    std::string error;
+    ASSERT_TRUE(readShotFile(path, shot, error)) << error;
+    ASSERT_EQ(shot.request.targetPattern, shot.target.data());
+    EXPECT_EQ(shot.target[0], (uint8_t)TargetSite::Target);
+    EXPECT_EQ(shot.target[1], (uint8_t)TargetSite::Target);
+    EXPECT_EQ(shot.target[2], (uint8_t)TargetSite::Reservoir);
+    EXPECT_EQ(shot.target[3], (uint8_t)TargetSite::Free);
+    remove(path.c_str());
+}
+
+TEST(ShotFileTest, ReadsAReplanSection) {
+    std::string path = writeTemporary("shot_replan.txt",
+        "size 2 2\nN 1\nvec1 1 0\nvec2 0 1\ncenter 10 10\noccupancy\n1 0\n0 1\nreplan 3\n-1 1\n0 0\n");
+    ShotFile shot;
+    std::string error;
+    ASSERT_TRUE(readShotFile(path, shot, error)) << error;
+    EXPECT_EQ(shot.replanFrame, 3);
+    ASSERT_EQ(shot.delta.size(), 4u);
+    EXPECT_EQ(shot.delta[0], (int8_t)AtomChange::Lost);
+    EXPECT_EQ(shot.delta[1], (int8_t)AtomChange::Extra);
+    EXPECT_EQ(shot.delta[3], (int8_t)AtomChange::Unchanged);
+    remove(path.c_str());
+}
+
+TEST(ShotFileTest, RejectsASecondSize) {
+    // The occupancy was read for 2 x 2 sites, and must not be routed as 50 x 50.
+    std::string path = writeTemporary("shot_resized.txt",
+        "size 2 2\nN 1\nvec1 1 0\nvec2 0 1\ncenter 10 10\noccupancy\n1 0\n0 1\nsize 50 50\n");
+    ShotFile shot;
+    std::string error;
+    EXPECT_FALSE(readShotFile(path, shot, error));
+    EXPECT_NE(error.find("size"), std::string::npos);
+    remove(path.c_str());
+}
+
+TEST(ShotFileTest, RejectsIncompleteFiles) {
+    std::string path = writeTemporary("shot_incomplete.txt", "size 2 2\nN 2\noccupancy\n1 0\n0 1\n");
+    ShotFile shot;
+    std::string error;
+    EXPECT_FALSE(readShotFile(path, shot, error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(readShotFile(path + ".missing", shot, error));
+    remove(path.c_str());
+}
+
+}
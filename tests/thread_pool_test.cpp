@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "core/thread_pool.h"
+
+namespace {
+
+TEST(ThreadPoolTest, RunsEveryTaskOnce) {
+    for (int threads : { 1, 2, 4 }) {
+        ThreadPool pool(threads);
+        EXPECT_EQ(pool.size(), threads);
+        std::vector<std::atomic<int>> calls(1000);
+        for (int round = 0; round < 5; round++) {
+            pool.parallelFor((int)calls.size(), [&](int i) { calls[i]++; });
+        }
+        for (size_t i = 0; i < calls.size(); i++) ASSERT_EQ(calls[i].load(), 5) << "task " << i;
+    }
+}
+
+TEST(ThreadPoolTest, HandlesEmptyAndResizedWork) {
+    ThreadPool pool(3);
+    int calls = 0;
+    pool.parallelFor(0, [&](int) { calls++; });
+    EXPECT_EQ(calls, 0);
+
+    pool.resize(1);
+    EXPECT_EQ(pool.size(), 1);
+    pool.parallelFor(10, [&](int) { calls++; });
+    EXPECT_EQ(calls, 10);
+
+    pool.resize(4);
+    std::atomic<int> total{ 0 };
+    pool.parallelFor(100, [&](int i) { total += i; });
+    EXPECT_EQ(total.load(), 4950);
+}
+
+}
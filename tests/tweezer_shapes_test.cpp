@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "core/tweezer_shapes.h"
+
+namespace {
+
+// pixelCount: the number of pixels a stamp covers.
+int pixelCount(const TweezerStamp& stamp) {
+    int count = 0;
+    for (const StampSpan& span : stamp.spans) count += span.colEnd - span.colBegin;
+    return count;
+}
+
+// drawAt: draws a stamp centered on (x, y) into a small frame and returns the covered pixels.
+std::vector<uint32_t> drawAt(const TweezerStamp& stamp, int width, int height, int x, int y) {
+    std::vector<uint32_t> frame((size_t)width * height, 0);
+    stamp.draw(frame.data(), width, 0, height, x, y, 1);
+    return frame;
+}
+
+TEST(TweezerShapesTest, BuiltInShapesCoverTheExpectedPixels) {
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec spec;
+    spec.size = 3;
+    spec.shape = TweezerShape::Square;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 49);
+    spec.shape = TweezerShape::Diamond;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 25);
+    spec.shape = TweezerShape::Disc;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 29);
+    spec.shape = TweezerShape::Gaussian;
+    spec.parameter = 1.0f;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 1);
+}
+
+TEST(TweezerShapesTest, RegistryCompilesEachShapeOnce) {
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec spec;
+    spec.shape = TweezerShape::Disc;
+    spec.size = 5;
+    shapes.get(spec);
+    shapes.get(spec);
+    EXPECT_EQ(shapes.size(), 1u);
+    spec.size = 6;
+    shapes.get(spec);
+    EXPECT_EQ(shapes.size(), 2u);
+}
+
+TEST(TweezerShapesTest, RegistryKeepsARecentlyUsedFewStamps) {
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec disc;
+    disc.shape = TweezerShape::Disc;
+    disc.size = 2;
+    TweezerShapeSpec spec;
+    spec.shape = TweezerShape::Gaussian;
+    spec.size = 3;
+    // Sweep the Gaussian cut-off well past the capacity, looking the disc up all along.
+    for (int i = 0; i < 4 * (int)TweezerShapeRegistry::MAX_ENTRIES; i++) {
+        spec.parameter = 0.01f * (i + 1);
+        shapes.get(spec);
+        EXPECT_EQ(pixelCount(shapes.get(disc)), 13);
+    }
+    EXPECT_EQ(shapes.size(), TweezerShapeRegistry::MAX_ENTRIES);
+    // An evicted stamp is compiled again, the same as before.
+    spec.parameter = 1.0f;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 1);
+}
+
+TEST(TweezerShapesTest, CustomMasksAreComparedInFull) {
+    uint8_t first[3 * 3] = { 0, 1, 0, 1, 1, 1, 0, 1, 0 };
+    uint8_t second[3 * 3] = { 1, 0, 1, 0, 1, 0, 1, 0, 1 };
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec spec;
+    spec.shape = TweezerShape::Custom;
+    spec.maskRows = 3;
+    spec.maskCols = 3;
+    spec.mask = first;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 5);
+    spec.mask = second;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 5);
+    EXPECT_EQ(shapes.size(), 2u);
+    // Nonzero values other than 1 draw the same mask.
+    second[0] = 7;
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 5);
+    EXPECT_EQ(shapes.size(), 2u);
+}
+
+TEST(TweezerShapesTest, PatternOffsetsAreRowColumnDeviations) {
+    const int offsets[3][2] = { { 0, 0 }, { 1, 0 }, { 0, 2 } };
+    TweezerShapeRegistry shapes;
+    shapes.setPattern(offsets, 3);
+    TweezerShapeSpec spec;
+    spec.shape = TweezerShape::Pattern;
+    std::vector<uint32_t> frame = drawAt(shapes.get(spec), 10, 10, 4, 4);
+    EXPECT_EQ(frame[4 * 10 + 4], 1u);
+    EXPECT_EQ(frame[5 * 10 + 4], 1u);
+    EXPECT_EQ(frame[4 * 10 + 6], 1u);
+    EXPECT_EQ(pixelCount(shapes.get(spec)), 3);
+}
+
+TEST(TweezerShapesTest, CustomMasksAreCenteredAndClipped) {
+    const uint8_t mask[2 * 3] = {
+        1, 1, 1,
+        0, 1, 0
+    };
+    TweezerShapeRegistry shapes;
+    TweezerShapeSpec spec;
+    spec.shape = TweezerShape::Custom;
+    spec.mask = mask;
+    spec.maskRows = 2;
+    spec.maskCols = 3;
+    const TweezerStamp& stamp = shapes.get(spec);
+    EXPECT_EQ(pixelCount(stamp), 4);
+
+    // The mask center (row 1, column 1) lands on the tweezer.
+    std::vector<uint32_t> frame = drawAt(stamp, 10, 10, 5, 5);
+    EXPECT_EQ(frame[4 * 10 + 4] + frame[4 * 10 + 5] + frame[4 * 10 + 6] + frame[5 * 10 + 5], 4u);
+
+    // Drawn at the corner, only the pixels on screen are set.
+    frame = drawAt(stamp, 10, 10, 0, 0);
+    EXPECT_EQ(frame[0], 1u);
+    EXPECT_EQ(frame[1], 0u);
+}
+
+}
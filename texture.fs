@@ -7,7 +7,42 @@ in vec2 TexCoord;
 // texture sampler
 uniform sampler2D texture1;
 
+// DMD remap parameters (see DmdRemap): when gpuRemap is set, texture1 holds the image in its own coordinate system and each DMD pixel
+// fetches the texel given by rowAlgorithm()/columnAlgorithm(); DMD pixels without a source texel show backgroundColor.
+uniform bool gpuRemap;
+uniform int rowOffset;
+uniform ivec2 screenSize;
+uniform vec3 backgroundColor;
+
+// When packedInput is set, the image is read from packedTexture instead: one unsigned integer per pixel holding the 24 bit planes of the
+// frame (see bitplane_rasterizer.h), inverted here if invertPacked is set.
+uniform bool packedInput;
+uniform usampler2D packedTexture;
+uniform bool invertPacked;
+
+vec4 fetchSource(ivec2 texel)
+{
+	if (!packedInput)
+		return texelFetch(texture1, texel, 0);
+	uint bits = texelFetch(packedTexture, texel, 0).r;
+	if (invertPacked) bits ^= 0xFFFFFFu;
+	return vec4(float((bits >> 16) & 255u), float((bits >> 8) & 255u), float(bits & 255u), 255.0) / 255.0;
+}
+
 void main()
 {
-	FragColor = texture(texture1, TexCoord);
-}
\ No newline at end of file
+	ivec2 dmdPixel = ivec2(TexCoord * vec2(screenSize));
+	if (!gpuRemap) {
+		FragColor = packedInput ? fetchSource(dmdPixel) : texture(texture1, TexCoord);
+		return;
+	}
+
+	int dmdRow = dmdPixel.y;
+	int dmdCol = dmdPixel.x;
+	int x = rowOffset - dmdCol + dmdRow / 2;
+	int y = (dmdRow + 1) / 2 + dmdCol;
+	if (x >= 0 && x < screenSize.y && y >= 0 && y < screenSize.x)
+		FragColor = fetchSource(ivec2(y, x));
+	else
+		FragColor = vec4(backgroundColor, 1.0);
+}
@@ -0,0 +1,42 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+// One invocation per (subframe, tweezer) pair. positions holds the x coordinates of every pair in subframe-major order, followed by
+// the y coordinates in the same order.
+layout (std430, binding = 0) readonly buffer Positions {
+	float positions[];
+};
+
+// packed 24-bit-plane frame: subframe j is stored in bit 23 - j (see bitplane_rasterizer.h)
+layout (r32ui, binding = 0) uniform uimage2D packedImage;
+
+// tweezer shape: nonzero texels are drawn; texel (0, 0) lies at stampOrigin (column, row) relative to the tweezer center
+uniform usampler2D stampMask;
+uniform ivec2 stampOrigin;
+uniform int numTweezers;
+uniform int numSubframes;
+uniform ivec2 screenSize;
+
+void main()
+{
+	int id = int(gl_GlobalInvocationID.x);
+	int count = numTweezers * numSubframes;
+	if (id >= count) return;
+
+	int subframe = id / numTweezers;
+	int x = int(positions[id]);
+	int y = int(positions[count + id]);
+	uint mask = 1u << uint(23 - subframe);
+
+	ivec2 stampSize = textureSize(stampMask, 0);
+	for (int r = 0; r < stampSize.y; r++) {
+		int row = x + stampOrigin.y + r;
+		if (row < 0 || row >= screenSize.y) continue;
+		for (int c = 0; c < stampSize.x; c++) {
+			int col = y + stampOrigin.x + c;
+			if (col < 0 || col >= screenSize.x) continue;
+			if (texelFetch(stampMask, ivec2(c, r), 0).r != 0u)
+				imageAtomicOr(packedImage, ivec2(col, row), mask);
+		}
+	}
+}
@@ -0,0 +1,14 @@
+#version 330 core
+out uint FragMask;
+
+flat in ivec2 stampPixel;
+flat in uint subframeMask;
+
+uniform usampler2D stampMask;
+
+// Written with glLogicOp(GL_OR) into the packed 24-bit-plane frame, so every tweezer only sets its own subframe's bit.
+void main()
+{
+	if (texelFetch(stampMask, ivec2(gl_FragCoord.xy) - stampPixel, 0).r == 0u) discard;
+	FragMask = subframeMask;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in float aX;
+layout (location = 2) in float aY;
+
+// One instance per (subframe, tweezer) pair, in subframe-major order; each instance covers the bounding box of the tweezer shape.
+// aCorner is the texture coordinate of the display quad's vertex, so the same vertex and index buffers serve both shaders.
+flat out ivec2 stampPixel;
+flat out uint subframeMask;
+
+// tweezer shape: nonzero texels are drawn; texel (0, 0) lies at stampOrigin (column, row) relative to the tweezer center
+uniform usampler2D stampMask;
+uniform ivec2 stampOrigin;
+uniform int numTweezers;
+uniform ivec2 screenSize;
+
+void main()
+{
+	int subframe = gl_InstanceID / numTweezers;
+	stampPixel = ivec2(int(aY), int(aX)) + stampOrigin;
+	subframeMask = 1u << uint(23 - subframe);
+
+	vec2 pixel = vec2(stampPixel) + aCorner * vec2(textureSize(stampMask, 0));
+	gl_Position = vec4(pixel / vec2(screenSize) * 2.0 - 1.0, 0.0, 1.0);
+}